@@ -8,8 +8,44 @@
 
 #include <type_traits>
 #include <functional>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
 #include <vector>
+#include <list>
+#include <array>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <queue>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <chrono>
+#include <bit>
+#include <iterator>
+#include <fstream>
+#include <span>
+#include <filesystem>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+// a*b + c on 8 floats. msvc's /arch:AVX2 implies FMA without defining __FMA__, gcc and clang
+// only emit it with -mfma, elsewhere it falls back to a separate multiply and add
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define OGE_FMADD256(a, b, c) _mm256_fmadd_ps(a, b, c)
+#elif defined(__AVX2__)
+#define OGE_FMADD256(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
 #include <iostream>
 #include <format>
 
@@ -17,6 +53,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <spdlog/spdlog.h>
 #include <spdlog/fmt/ostr.h>
@@ -26,6 +65,8 @@
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
+struct stbtt_fontinfo;
+
 namespace oge {
 
     namespace utils {
@@ -86,20 +127,216 @@ namespace oge {
                 static void message(GLenum, GLenum, GLuint, GLenum, GLsizei, const GLchar*, const void*);
                 static level _level;
         };
+
+        // jobs
+
+        struct thread_pool {
+            public:
+                thread_pool(unsigned int threads = std::max(2u, std::thread::hardware_concurrency()) - 1);
+                ~thread_pool();
+
+                thread_pool(const thread_pool&) = delete;
+                thread_pool& operator=(const thread_pool&) = delete;
+
+                template<typename F> auto submit(F&& fn) -> std::future<std::invoke_result_t<F>> {
+                    using R = std::invoke_result_t<F>;
+                    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+                    std::future<R> result = task->get_future();
+                    enqueue([task]() { (*task)(); });
+                    return result;
+                }
+
+                // splits [0, count) into ranges of at most `grain` items; the calling
+                // thread takes part, so it is safe to call from inside a job
+                void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+                inline unsigned int size() const { return (unsigned int)_threads.size(); }
+                // true on this pool's own worker threads
+                bool is_worker() const;
+
+                static thread_pool& global();
+
+            private:
+                void enqueue(std::function<void()> job);
+                void worker();
+
+            private:
+                std::vector<std::thread> _threads;
+                std::deque<std::function<void()>> _jobs;
+                std::mutex _mutex;
+                std::condition_variable _cv;
+                bool _stop = false;
+        };
+
+        // frame memory
+
+        // bump allocator for data that dies before the frame ends. every thread has its own;
+        // next_frame() (application::run calls it) makes each of them start over on its next
+        // allocation. capacity is kept, so steady frames never touch the heap. outside of
+        // application the owning loop has to call next_frame() itself
+        struct frame_arena {
+            public:
+                explicit frame_arena(size_t chunk_size = size_t(1) << 20);
+                ~frame_arena();
+
+                frame_arena(const frame_arena&) = delete;
+                frame_arena& operator=(const frame_arena&) = delete;
+
+                void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+                template<typename T> T* allocate_array(size_t count) { return (T*)allocate(count * sizeof(T), alignof(T)); }
+                // rewinds, folding the chunks of a busy frame into one for the next
+                void reset();
+
+                inline size_t used() const { return _used; }
+                inline size_t capacity() const { return _capacity; }
+
+                static frame_arena& local();
+                // std::pmr view of the calling thread's arena, deallocation is a no-op
+                static std::pmr::memory_resource* resource();
+                static void next_frame();
+
+            private:
+                struct chunk {
+                    uint8_t* data;
+                    size_t size;
+                };
+
+                std::vector<chunk> _chunks;
+                size_t _current = 0, _offset = 0;
+                size_t _chunk_size, _used = 0, _capacity = 0;
+                uint64_t _frame = 0;
+        };
+
+        template<typename T> using frame_vector = std::pmr::vector<T>;
+
+        // pooled memory
+
+        // size-class allocator for small objects: blocks up to max_block bytes are carved from
+        // 64 KiB slabs, one run of slabs per class, bigger or over-aligned requests go to the
+        // heap. every thread keeps a short free list per class and only takes a lock to trade
+        // a batch with the pool, so allocation and release are O(1). blocks are recycled
+        // within their class and returned to the heap when the pool is destroyed
+        struct pool_resource : public std::pmr::memory_resource {
+            public:
+                struct stats {
+                    size_t slabs = 0;
+                    size_t reserved = 0;
+                    size_t large = 0;
+                };
+
+                pool_resource();
+                ~pool_resource();
+
+                pool_resource(const pool_resource&) = delete;
+                pool_resource& operator=(const pool_resource&) = delete;
+
+                stats statistics() const;
+
+                static constexpr size_t max_block = 4096;
+                static pool_resource& global();
+
+                // per-thread free lists
+                struct thread_cache;
+
+            private:
+                void* do_allocate(size_t bytes, size_t alignment) override;
+                void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+                // links up to `count` blocks in front of `head` through their first word
+                void refill(uint32_t size_class, size_t count, void*& head);
+                void release(uint32_t size_class, void* head, void* tail);
+
+            private:
+                static constexpr uint32_t classes = 20;
+
+                struct alignas(64) central {
+                    std::mutex lock;
+                    void* free = nullptr;
+                    uint8_t* cursor = nullptr;
+                    uint8_t* end = nullptr;
+                };
+
+                central _central[classes];
+                mutable std::mutex _slab_lock;
+                std::vector<void*> _slabs;
+                std::atomic<size_t> _large = 0;
+                uint64_t _id;
+        };
+
+        template<typename T> struct pool_delete {
+            pool_resource* pool = &pool_resource::global();
+
+            void operator()(T* object) const {
+                object->~T();
+                pool->deallocate(object, sizeof(T), alignof(T));
+            }
+        };
+
+        template<typename T> using pool_ptr = std::unique_ptr<T, pool_delete<T>>;
+
+        // typed front of a pool_resource. objects have to be released as the type they were
+        // created as, polymorphic hierarchies derive from pool_allocated instead
+        template<typename T> struct object_pool {
+            public:
+                explicit object_pool(pool_resource& pool = pool_resource::global()) : _pool(&pool) {}
+
+                template<typename... Args> T* create(Args&&... args) {
+                    return new (_pool->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+                }
+
+                template<typename... Args> pool_ptr<T> make(Args&&... args) {
+                    return pool_ptr<T>(create(std::forward<Args>(args)...), pool_delete<T>{ _pool });
+                }
+
+                void destroy(T* object) {
+                    if (object) {
+                        pool_delete<T>{ _pool }(object);
+                    }
+                }
+
+                inline pool_resource& resource() const { return *_pool; }
+
+            private:
+                pool_resource* _pool;
+        };
+
+        // plain new/delete of derived types go through the global pool. deleting through a base
+        // pointer passes the dynamic size along, so the base needs a virtual destructor
+        struct pool_allocated {
+            static void* operator new(size_t size) { return pool_resource::global().allocate(size); }
+            static void* operator new(size_t size, std::align_val_t alignment) { return pool_resource::global().allocate(size, (size_t)alignment); }
+            static void operator delete(void* p, size_t size) { pool_resource::global().deallocate(p, size); }
+            static void operator delete(void* p, size_t size, std::align_val_t alignment) { pool_resource::global().deallocate(p, size, (size_t)alignment); }
+        };
+
         // shader
+        struct shader_source {
+            std::string vertex, fragment;
+        };
+
+        // lets string keyed maps be searched with a const char* or string_view without a temporary
+        struct string_hash {
+            using is_transparent = void;
+            size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+        };
+
         struct shader {
             private:
                 unsigned int _id;
-                std::unordered_map<std::string, int> _uniform_location_cache;
+                std::unordered_map<std::string, int, string_hash, std::equal_to<>> _uniform_location_cache;
 
             public:
                 // shader() {}
                 shader(const char* vertex_path, const char* fragment_path);
+                explicit shader(const shader_source& source);
                 ~shader() { glDeleteProgram(_id); }
 
                 void bind() const;
                 void unbind() const;
 
+                inline unsigned int id() const { return _id; }
+
                 // void load(const char* vertex_path, const char* fragment_path);
                 
                 template<typename T> void set_uniform(const char* name, const T& value);
@@ -197,791 +434,10146 @@ namespace oge {
                 float _rotation = 0.0f;
         };
 
-    }
-
-    namespace events {
-
-        enum class type {
-            none = 0,
-            window_close, window_resize, window_focus, window_move,
-            key_press, key_release, key_type,
-            mouse_button_press, mouse_button_release, mouse_move, mouse_scroll
-        };
+        // instancing
 
-        enum category {
-            none = 0,
-            application = 1 << 0,
-            input = 1 << 1,
-            keyboard = 1 << 2,
-            mouse = 1 << 3,
-            mouse_button = 1 << 4,
+        // one per-instance attribute of an AoS instance record.
+        // components = 16 describes a mat4 and occupies 4 consecutive locations.
+        struct instance_attribute {
+            unsigned int location;
+            int components;
+            GLenum type = GL_FLOAT;
+            bool normalized = false;
         };
 
-        #define ECT(etype) \
-            static type get_static_type() { return type::##etype; } \
-            virtual type get_type() const override { return get_static_type(); } \
-            virtual const char* get_name() const override { return #etype; }
-
-        #define ECC(ecat) \
-            virtual int get_category_flags() const override { return ecat; } 
-
-        
-        struct event {
+        struct instance_buffer {
             public:
-                bool handled = false;
+                enum class mode { attribute, storage };
 
-                virtual type get_type() const = 0;
-                virtual const char* get_name() const = 0;
-                virtual int get_category_flags() const = 0;
-                virtual std::string to_string() const { return get_name(); }
+                // attribute mode: records are fed through vertex attributes with divisor 1
+                instance_buffer(std::initializer_list<instance_attribute> layout);
+                // storage mode: records are read from an SSBO indexed by gl_InstanceID
+                instance_buffer(size_t stride, mode m = mode::storage);
+                ~instance_buffer();
 
-                inline bool is_in_category(category cat) const { return get_category_flags() & cat; }
-        
-                inline friend std::ostream& operator<<(std::ostream& os, const event& e) {
-                    return os << e.to_string();
-                }
-        };
+                instance_buffer(const instance_buffer&) = delete;
+                instance_buffer& operator=(const instance_buffer&) = delete;
 
-        struct event_dispatcher {
-            public:
-                event_dispatcher(event& event) : _event(event) {}
+                // for SoA data use one buffer per stream and attach them all to the same vao
+                void attach(unsigned int vao) const;
+                void bind_base(unsigned int binding) const;
 
-                template<typename T, typename F>
-                bool dispatch(const F& func) {
-                    if (_event.get_type() == T::get_static_type()) {
-                        _event.handled |= func(static_cast<T&>(_event));
-                        return true;
-                    }
-                    return false;
-                }
+                void upload(const void* data, size_t count);
+                template<typename T> void upload(const std::vector<T>& data) { upload(data.data(), data.size()); }
+
+                inline size_t count() const { return _count; }
+                inline size_t stride() const { return _stride; }
+                inline unsigned int id() const { return _id; }
 
             private:
-                event& _event;
+                unsigned int _id = 0;
+                size_t _stride = 0, _capacity = 0, _count = 0;
+                mode _mode;
+                std::vector<instance_attribute> _layout;
         };
 
+        void draw_elements_instanced(unsigned int vao, int index_count, size_t instance_count, GLenum index_type = GL_UNSIGNED_INT);
 
-        struct key_event : public event {
-            public:
-                inline int code() const { return _code; }
-                ECC(keyboard | input)
-            protected:
-                key_event(int key_code) : _code(key_code) {}
-                int _code;
-        };
+        // 2d batch
 
-        struct key_press_event : public key_event {
+        struct batch2d {
             public:
-                key_press_event(int key_code, int repeat_count) : key_event(key_code), _repeat_count(repeat_count) {}
-                inline int repeat_count() const { return _repeat_count; }
+                static constexpr unsigned int max_textures = 16;
 
-                std::string to_string() const override {
-                    return std::format("key_press_event: {} ({} repeats)", _code, _repeat_count);
-                }
+                struct stats {
+                    unsigned int draw_calls = 0;
+                    unsigned int quads = 0;
+                };
 
-                ECT(key_press)
-            private:
-                int _repeat_count;
-        };
+                batch2d(size_t max_quads = 10000);
+                ~batch2d();
 
-        struct key_release_event : public key_event {
-            public:
-                key_release_event(int key_code) : key_event(key_code) {}
+                batch2d(const batch2d&) = delete;
+                batch2d& operator=(const batch2d&) = delete;
 
-                std::string to_string() const override {
-                    return std::format("key_release_event: {}", _code);
-                }
+                void begin(const glm::mat4& view_projection);
+                void end();
 
-                ECT(key_release)
-        };
+                void draw_quad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color);
+                void draw_quad(const glm::vec3& position, const glm::vec2& size, unsigned int texture,
+                               const glm::vec2& uv0 = { 0.0f, 0.0f }, const glm::vec2& uv1 = { 1.0f, 1.0f },
+                               const glm::vec4& color = glm::vec4(1.0f));
 
-        struct key_type_event : public key_event {
-            public:
-                key_type_event(int key_code) : key_event(key_code) {}
+                const stats& statistics() const { return _stats; }
 
-                std::string to_string() const override {
-                    return std::format("key_type_event: {}", _code);
-                }
+            private:
+                void flush();
 
-                ECT(key_type)
-        };
+            private:
+                struct vertex {
+                    glm::vec3 position;
+                    glm::vec2 uv;
+                    glm::vec4 color;
+                    float texture;
+                };
 
-        struct mouse_button_event : public event {
-            public:
-                inline int button() const { return _button; }
-                ECC(mouse_button | input)
-            protected:
-                mouse_button_event(int button) : _button(button) {}
-                int _button;
-        };
+                shader _shader;
+                unsigned int _vao, _vbo, _ibo, _white;
 
-        struct mouse_button_press_event : public mouse_button_event {
-            public:
-                mouse_button_press_event(int button) : mouse_button_event(button) {}
+                size_t _max_quads;
+                std::vector<vertex> _vertices;
 
-                std::string to_string() const override {
-                    return std::format("mouse_button_press_event: {}", _button);
-                }
+                std::array<unsigned int, max_textures> _textures;
+                unsigned int _texture_count = 1;
 
-                ECT(mouse_button_press)
+                stats _stats;
         };
 
-        struct mouse_button_release_event : public mouse_button_event {
-            public:
-                mouse_button_release_event(int button) : mouse_button_event(button) {}
-
-                std::string to_string() const override {
-                    return std::format("mouse_button_release_event: {}", _button);
-                }
-
-                ECT(mouse_button_release)
-        };
+        // text
 
-        struct mouse_move_event : public event {
+        struct font {
             public:
-                mouse_move_event(const utils::vec2f& pos) : _pos(pos) {}
+                font(const char* path);
+                ~font();
 
-                inline float x() const { return _pos.x; }
-                inline float y() const { return _pos.y; }
+                font(const font&) = delete;
+                font& operator=(const font&) = delete;
 
-                std::string to_string() const override {
-                    return std::format("mouse_move_event: {}, {}", _pos.x, _pos.y);
-                }
+                inline bool valid() const { return _info != nullptr; }
+                inline unsigned short id() const { return _id; }
+                inline stbtt_fontinfo* info() const { return _info.get(); }
+
+                float scale_for(float pixel_height) const;
+                float line_height(float pixel_height) const;
+                // texels the largest glyph covers along either axis at this size
+                unsigned int max_glyph_extent(float pixel_height) const;
 
-                ECT(mouse_move)
-                ECC(mouse | input)
             private:
-                utils::vec2f _pos;
+                std::string _data;
+                std::unique_ptr<stbtt_fontinfo> _info;
+                unsigned short _id;
+                int _ascent = 0, _descent = 0, _line_gap = 0;
+                int _box_width = 0, _box_height = 0;
         };
 
-        struct mouse_scroll_event : public event {
+        // fixed-cell glyph cache; glyphs are rasterized on first use and the
+        // least recently used cell is recycled once the atlas is full
+        struct glyph_atlas {
             public:
-                mouse_scroll_event(const utils::vec2f& offset) : _offset(offset) {}
+                struct glyph {
+                    glm::vec2 uv0, uv1;
+                };
 
-                inline float x() const { return _offset.x; }
-                inline float y() const { return _offset.y; }
+                glyph_atlas(unsigned int size = 1024, unsigned int cell = 64);
+                ~glyph_atlas();
 
-                std::string to_string() const override {
-                    return std::format("mouse_scroll_event: {}, {}", _offset.x, _offset.y);
-                }
+                glyph_atlas(const glyph_atlas&) = delete;
+                glyph_atlas& operator=(const glyph_atlas&) = delete;
+
+                // nullptr when every cell is already in use this frame
+                const glyph* acquire(const font& fnt, float pixel_height, int glyph_index);
+                void next_frame() { _frame++; }
+                // grows the cells to hold `extent` texels plus padding, and the texture so it keeps
+                // at least 8x8 of them. drops every cached glyph, true when that happened
+                bool fit(unsigned int extent);
+
+                inline unsigned int texture() const { return _texture; }
+                inline unsigned int cell_size() const { return _cell; }
+                inline size_t evictions() const { return _evictions; }
 
-                ECT(mouse_scroll)
-                ECC(mouse | input)
             private:
-                utils::vec2f _offset;
+                struct cell {
+                    uint64_t key;
+                    uint64_t frame;
+                    glyph uv;
+                    std::list<unsigned int>::iterator lru;
+                };
+
+                unsigned int _texture;
+                unsigned int _size, _cell, _columns;
+                uint64_t _frame = 0;
+                size_t _evictions = 0;
+
+                std::vector<cell> _cells;
+                std::list<unsigned int> _lru;
+                std::unordered_map<uint64_t, unsigned int> _lookup;
+                std::vector<unsigned char> _scratch;
         };
 
-        struct window_resize_event : public event {
+        struct text_renderer {
             public:
-                window_resize_event(const utils::vec2u& size) : _size(size) {}
+                struct stats {
+                    size_t layout_hits = 0;
+                    size_t layout_misses = 0;
+                    size_t dropped_glyphs = 0;
+                };
 
-                inline unsigned int width() const { return _size.x; }
-                inline unsigned int height() const { return _size.y; }
+                text_renderer(batch2d& batch, unsigned int atlas_size = 1024, size_t max_cached_runs = 4096);
 
-                std::string to_string() const override {
-                    return std::format("window_resize_event: {}, {}", _size.x, _size.y);
-                }
+                // position is the baseline origin; one pixel maps to `scale` world units
+                void draw(const font& fnt, float pixel_height, std::string_view text,
+                          const glm::vec3& position, const glm::vec4& color = glm::vec4(1.0f), float scale = 1.0f);
+                glm::vec2 measure(const font& fnt, float pixel_height, std::string_view text);
+
+                // call once per frame, after the batch has been flushed
+                void next_frame();
+
+                const stats& statistics() const { return _stats; }
+                glyph_atlas& atlas() { return _atlas; }
 
-                ECT(window_resize)
-                ECC(application)
             private:
-                utils::vec2u _size;
-        };
+                struct placed_glyph {
+                    int glyph_index;
+                    glm::vec2 min, max;
+                };
 
-        struct window_close_event : public event {
-            public:
-                window_close_event() {}
+                struct run_key {
+                    unsigned short font;
+                    float size;
+                    std::string text;
+                };
 
-                std::string to_string() const override {
-                    return std::format("window_close_event");
-                }
+                struct run {
+                    std::vector<placed_glyph> glyphs;
+                    glm::vec2 extent;
+                    std::list<const run_key*>::iterator lru;
+                };
 
-                ECT(window_close)
-                ECC(application)
-        };
+                struct run_view {
+                    unsigned short font;
+                    float size;
+                    std::string_view text;
+                };
 
-        struct window_focus_event : public event {
-            public:
-                window_focus_event(bool focused) : _focused(focused) {}
+                struct run_hash {
+                    using is_transparent = void;
+                    size_t operator()(const run_view& k) const;
+                    size_t operator()(const run_key& k) const { return (*this)(run_view{ k.font, k.size, k.text }); }
+                };
 
-                inline bool focused() const { return _focused; }
+                struct run_equal {
+                    using is_transparent = void;
+                    static run_view view(const run_key& k) { return { k.font, k.size, k.text }; }
+                    static run_view view(const run_view& k) { return k; }
+                    template<typename A, typename B> bool operator()(const A& a, const B& b) const {
+                        run_view x = view(a), y = view(b);
+                        return x.font == y.font && x.size == y.size && x.text == y.text;
+                    }
+                };
 
-                std::string to_string() const override {
-                    return std::format("window_focus_event: {}", _focused);
-                }
+                const run& layout(const font& fnt, float pixel_height, std::string_view text);
 
-                ECT(window_focus)
-                ECC(application)
             private:
-                bool _focused;
+                batch2d& _batch;
+                glyph_atlas _atlas;
+                size_t _max_cached_runs;
+
+                std::list<const run_key*> _run_lru;
+                std::unordered_map<run_key, run, run_hash, run_equal> _runs;
+
+                stats _stats;
         };
 
-        struct window_move_event : public event {
-            public:
-                window_move_event(const utils::vec2i& pos) : _pos(pos) {}
+        // tilemap
 
-                inline int x() const { return _pos.x; }
-                inline int y() const { return _pos.y; }
+        struct tilemap {
+            public:
+                static constexpr int chunk_size = 32;
+
+                // fills a chunk entering the streaming range; tile id 0 is empty,
+                // id n samples cell n-1 of the atlas (row-major from the top left)
+                using chunk_loader_fn = std::function<void(const glm::ivec2& chunk, std::vector<uint16_t>& tiles)>;
+                // called with the tiles of a chunk leaving the streaming range
+                using chunk_unloader_fn = std::function<void(const glm::ivec2& chunk, const std::vector<uint16_t>& tiles)>;
+
+                struct stats {
+                    unsigned int loaded_chunks = 0;
+                    unsigned int visible_chunks = 0;
+                    unsigned int pending_builds = 0;
+                    unsigned int draw_calls = 0;
+                };
 
-                std::string to_string() const override {
-                    return std::format("window_move_event: {}, {}", _pos.x, _pos.y);
-                }
+                tilemap(unsigned int atlas_texture, const glm::ivec2& atlas_tiles, float tile_size = 1.0f, int stream_margin = 1);
+                ~tilemap();
 
-                ECT(window_move)
-                ECC(application)
-            private:
-                utils::vec2i _pos;
-        };
+                tilemap(const tilemap&) = delete;
+                tilemap& operator=(const tilemap&) = delete;
 
+                void set_loader(const chunk_loader_fn& loader) { _loader = loader; }
+                void set_unloader(const chunk_unloader_fn& unloader) { _unloader = unloader; }
 
-    }
+                // edits only mark the owning chunk dirty, its mesh is rebuilt on a worker
+                void set_tile(const glm::ivec2& tile, uint16_t id);
+                uint16_t tile(const glm::ivec2& tile) const;
 
+                // streams chunks around the camera and uploads finished meshes
+                void on_update(const ortho_camera& camera);
+                void draw(const ortho_camera& camera);
 
-    namespace core {
+                const stats& statistics() const { return _stats; }
 
-        struct glfw {
-            public:
-                static void init();
-                static void terminate();
             private:
-                static bool initialized;
-        };
+                struct chunk_mesh {
+                    uint64_t version;
+                    std::vector<float> vertices;
+                };
+
+                struct chunk {
+                    std::vector<uint16_t> tiles;
+                    unsigned int vao = 0, vbo = 0;
+                    int index_count = 0;
+
+                    uint64_t version = 0, built_version = 0;
+                    bool building = false;
+                    std::future<chunk_mesh> pending;
+                };
+
+                static uint64_t chunk_key(const glm::ivec2& c) { return ((uint64_t)(uint32_t)c.x << 32) | (uint32_t)c.y; }
+                static glm::ivec2 chunk_coord(uint64_t key) { return { (int)(uint32_t)(key >> 32), (int)(uint32_t)key }; }
+
+                glm::ivec4 visible_range(const ortho_camera& camera) const;
+                chunk& load_chunk(const glm::ivec2& c);
+                void unload_chunk(uint64_t key, chunk& ch);
+                void schedule_build(const glm::ivec2& c, chunk& ch);
+                void upload(chunk& ch, const chunk_mesh& mesh);
 
-        struct ogl {
-            public:
-                static void init();
-                static void terminate();
             private:
-                static bool initialized;
+                shader _shader;
+                unsigned int _texture, _ibo;
+                glm::ivec2 _atlas_tiles;
+                float _tile_size;
+                int _stream_margin;
+
+                chunk_loader_fn _loader;
+                chunk_unloader_fn _unloader;
+
+                std::unordered_map<uint64_t, chunk> _chunks;
+                stats _stats;
         };
 
+        // render queue
 
-        class input {
-            protected:
-                input() = default;
+        struct render_queue {
             public:
-                input(const input&) = delete;
-                input& operator=(const input&) = delete;
+                // programs that declare `uniform mat4 u_transform` receive the command's transform
+                struct command {
+                    unsigned int program = 0, vao = 0, texture = 0;
+                    int index_count = 0;
+                    unsigned int instance_count = 1;
+                    glm::mat4 transform = glm::mat4(1.0f);
+                };
 
-                static bool is_key_pressed(int key_code);
-                static bool is_mouse_button_pressed(int button);
-                static utils::vec2f mouse_position();
-        };
+                struct stats {
+                    size_t commands = 0;
+                    size_t program_changes = 0, texture_changes = 0, vao_changes = 0;
+                    // state changes avoided compared to executing in submission order
+                    size_t state_changes_saved = 0;
+                };
 
-        struct callbacks {
-            static void error_callback(int error, const char* description);
+                // layer | translucent | opaque: shader, texture, depth front to back
+                //                     | translucent: depth back to front, shader, texture
+                static uint64_t make_key(uint8_t layer, bool translucent, uint16_t shader, uint16_t texture, float depth);
 
-            static void window_size_callback(GLFWwindow* window, int width, int height);
-            static void window_close_callback(GLFWwindow* window);
-            // static void window_refresh_callback(GLFWwindow* window);
-            static void window_focus_callback(GLFWwindow* window, int focused);
-            // static void window_iconify_callback(GLFWwindow* window, int iconified);
-            // static void window_maximize_callback(GLFWwindow* window, int maximized);
-            // static void window_content_scale_callback(GLFWwindow* window, float xscale, float yscale);
-            static void window_pos_callback(GLFWwindow* window, int xpos, int ypos);
+                void submit(uint64_t key, const command& cmd);
+                // sorts, executes and clears everything submitted this frame
+                void flush();
 
-            static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
-            static void key_type_callback(GLFWwindow* window, unsigned int codepoint);
+                const stats& statistics() const { return _stats; }
 
-            static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
-            static void mouse_position_callback(GLFWwindow* window, double xpos, double ypos);
-            static void mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-            
+            private:
+                struct item {
+                    uint64_t key;
+                    uint32_t index;
+                };
+
+                void sort();
+                int transform_location(unsigned int program);
+                static size_t count_changes(const std::vector<command>& commands, const item* order, size_t count,
+                                            size_t& programs, size_t& textures, size_t& vaos);
+
+            private:
+                std::vector<item> _items, _scratch;
+                std::vector<command> _commands;
+                std::unordered_map<unsigned int, int> _transform_locations;
+                stats _stats;
         };
 
-        using window_event_callback_fn = std::function<void(events::event&)>;
+        // culling
 
-        struct window_state {
+        struct frustum {
+            public:
+                // planes point inwards: a point is inside when dot(xyz, p) + w >= 0
+                frustum(const glm::mat4& view_projection);
 
-            const char* title = "OGE Window";
+                bool contains(const glm::vec3& min, const glm::vec3& max) const;
+                bool contains(const glm::vec3& center, float radius) const;
 
-            utils::vec2i position;
-            utils::vec2u size = { 1024, 512 };
-            utils::vec2u framebuffer_size;
-            utils::vec2f cursor_position;
-            utils::vec2f scroll_offset;
+                glm::vec4 planes[6];
+        };
 
-            bool vsync = true;
-            bool fullscreen = false;
+        struct aabb_soa {
+            std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
 
-            window_event_callback_fn callback;
+            void push_back(const glm::vec3& min, const glm::vec3& max);
+            void clear();
+            inline size_t size() const { return min_x.size(); }
+        };
 
-            GLFWwindow* window;
-            GLFWmonitor* monitor;
+        struct sphere_soa {
+            std::vector<float> x, y, z, radius;
 
-            window_state(
-                const char* title = "OGE Window",
-                const utils::vec2u& size = { 1024, 512 }
-            ) : title(title), size(size) {}
+            void push_back(const glm::vec3& center, float r);
+            void clear();
+            inline size_t size() const { return x.size(); }
+        };
 
+        // write the indices of the visible objects into `visible` (in order) and return the count
+        size_t cull(const frustum& f, const aabb_soa& boxes, std::vector<uint32_t>& visible);
+        size_t cull(const frustum& f, const sphere_soa& spheres, std::vector<uint32_t>& visible);
+
+        // particles
+
+        struct particle_settings {
+            glm::vec3 position = { 0.0f, 0.0f, 0.0f };
+            glm::vec3 velocity_min = { -1.0f, 1.0f, -1.0f }, velocity_max = { 1.0f, 3.0f, 1.0f };
+            glm::vec3 gravity = { 0.0f, -9.81f, 0.0f };
+            float lifetime_min = 1.0f, lifetime_max = 2.0f;
+            float size = 0.05f;
+            glm::vec4 color = { 1.0f, 1.0f, 1.0f, 1.0f };
+            float rate = 1000.0f;   // particles per second
+            bool additive = true;
+            unsigned int texture = 0;   // 0 draws solid round sprites
         };
 
-        struct window {
+        struct particle_emitter {
             public:
-                window( const window_state& state = window_state());
-                ~window();
+                using settings = particle_settings;
 
-                void on_update();
+                particle_emitter(size_t capacity, const settings& s = settings());
+                ~particle_emitter();
 
-                inline const utils::vec2u& size() const { return state.size; }
+                particle_emitter(const particle_emitter&) = delete;
+                particle_emitter& operator=(const particle_emitter&) = delete;
 
-                void set_event_callback(const window_event_callback_fn& callback);
-                void set_vsync(bool enabled);
-                void set_fullscreen(bool enabled);
-                void set_icon(const char* path);
+                settings& config() { return _settings; }
 
-                bool is_vsync() const;
-                bool is_fullscreen() const;
+                void emit(size_t count);
+                void on_update(const float& dt);
 
-                inline bool is_open() const { return !glfwWindowShouldClose(state.window); }
+                void draw(const ortho_camera& camera);
+                void draw(const presepctive_camera& camera);
 
-                inline void* native_window() const { return state.window; }
+                inline size_t alive() const { return _count; }
+                inline size_t capacity() const { return _capacity; }
 
             private:
-                void init();
-                void shutdown();
+                void draw(const glm::mat4& view, const glm::mat4& view_projection);
+                size_t integrate(size_t begin, size_t end, float dt, uint32_t* dead);
+                void compact(const uint32_t* dead, size_t count);
+                void move(size_t from, size_t to);
+                float random(float lo, float hi);
 
             private:
-                window_state state;
+                struct instance {
+                    glm::vec4 position_size;
+                    uint32_t color;
+                };
+
+                settings _settings;
+                size_t _capacity, _count = 0;
+                float _spawn_accumulator = 0.0f;
+                uint32_t _seed = 0x9e3779b9;
+
+                // soa storage, allocated once at full capacity
+                std::vector<float> _x, _y, _z, _vx, _vy, _vz, _life, _inv_lifetime;
+                std::vector<uint32_t> _color;
+
+                std::vector<uint32_t> _dead;
+                std::vector<instance> _instances;
+
+                shader _shader;
+                unsigned int _vao, _vbo;
+                instance_buffer _instance_buffer;
         };
 
-        struct layer {
+        // debug draw
+
+        // compiled out in release builds unless OGE_DEBUG_DRAW is set explicitly
+        #ifndef OGE_DEBUG_DRAW
+            #ifdef NDEBUG
+                #define OGE_DEBUG_DRAW 0
+            #else
+                #define OGE_DEBUG_DRAW 1
+            #endif
+        #endif
+
+        #if OGE_DEBUG_DRAW
+            #define OGE_DEBUG_DRAW_BODY ;
+        #else
+            #define OGE_DEBUG_DRAW_BODY {}
+        #endif
+
+        // immediate-mode shapes, callable from any thread; everything queued during
+        // the frame goes out in at most two draws (depth tested and overlay) on flush
+        struct debug_draw {
             public:
-                layer(const char* name = "Layer") : _name(name) {}
+                static void line(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color = glm::vec4(1.0f), bool depth_test = true) OGE_DEBUG_DRAW_BODY
+                static void aabb(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color = glm::vec4(1.0f), bool depth_test = true) OGE_DEBUG_DRAW_BODY
+                static void circle(const glm::vec3& center, const glm::vec3& normal, float radius, const glm::vec4& color = glm::vec4(1.0f), bool depth_test = true) OGE_DEBUG_DRAW_BODY
+                static void frustum(const glm::mat4& view_projection, const glm::vec4& color = glm::vec4(1.0f), bool depth_test = true) OGE_DEBUG_DRAW_BODY
+                // screen-space label anchored at a world position, needs set_text()
+                static void text3d(const glm::vec3& position, std::string_view text, const glm::vec4& color = glm::vec4(1.0f)) OGE_DEBUG_DRAW_BODY
+
+                static void set_text(batch2d* batch, text_renderer* text, const font* fnt, float pixel_height = 16.0f) OGE_DEBUG_DRAW_BODY
+
+                // GL thread only
+                static void flush(const glm::mat4& view_projection) OGE_DEBUG_DRAW_BODY
+                static void shutdown() OGE_DEBUG_DRAW_BODY
+        };
 
-                virtual void on_attach() {}
-                virtual void on_detach() {}
-                virtual void on_update( const float&) {}
-                virtual void on_event(events::event&) {}
+        // render targets
 
-                virtual void pre_update() {}
-                virtual void post_update() {}
-                
-                inline const char* name() const { return _name; }
+        struct texture_desc {
+            unsigned int width = 0, height = 0;
+            GLenum format = GL_RGBA8;
 
-            protected:
-                const char* _name;
+            bool operator==(const texture_desc& o) const { return width == o.width && height == o.height && format == o.format; }
         };
 
-        struct imgui_layer : public layer {
+        bool is_depth_format(GLenum format);
+
+        struct framebuffer {
             public:
-                imgui_layer();
-                ~imgui_layer() = default;
+                // attachments are borrowed, the framebuffer never deletes them
+                framebuffer(const std::vector<unsigned int>& colors, unsigned int depth = 0, GLenum depth_format = GL_DEPTH_COMPONENT24);
+                ~framebuffer();
 
-                virtual void on_attach() override;
-                virtual void on_detach() override;
-                virtual void on_update( const float&) override {}
-                virtual void on_event(events::event&) override;
+                framebuffer(const framebuffer&) = delete;
+                framebuffer& operator=(const framebuffer&) = delete;
 
-                void pre_update() override;
-                void post_update() override;
+                void bind() const;
+                void unbind() const;
 
-                bool on_mouse_button_press(events::mouse_button_event& e);
+                inline unsigned int id() const { return _id; }
 
+            private:
+                unsigned int _id;
         };
 
-        struct layer_stack {
+        // recycles render target textures between passes and frames. physical sizes
+        // are rounded up to `granularity` so a window drag doesn't allocate every frame
+        struct render_target_pool {
             public:
-                layer_stack();
-                ~layer_stack();
+                struct target {
+                    unsigned int texture;
+                    texture_desc physical;
+                };
 
-                void push_layer(layer* layer);
-                void pop_layer(layer* layer);
-                void push_overlay(layer* overlay);
-                void pop_overlay(layer* overlay);
+                render_target_pool(unsigned int granularity = 64, unsigned int max_idle_frames = 60);
+                ~render_target_pool();
+
+                render_target_pool(const render_target_pool&) = delete;
+                render_target_pool& operator=(const render_target_pool&) = delete;
+
+                target acquire(const texture_desc& desc);
+                void release(const target& t);
+
+                // drops targets nobody asked for in max_idle_frames, returns the deleted textures
+                std::vector<unsigned int> next_frame();
+
+                inline size_t allocated() const { return _allocated; }
+                inline size_t free_count() const { return _free.size(); }
 
-                std::vector<layer*>::iterator begin() { return _layers.begin(); }
-                std::vector<layer*>::iterator end() { return _layers.end(); }
             private:
-                std::vector<layer*> _layers;
-                size_t _layer_insert_index = 0;
+                struct entry {
+                    target t;
+                    uint64_t last_used;
+                };
+
+                unsigned int _granularity, _max_idle_frames;
+                uint64_t _frame = 0;
+                size_t _allocated = 0;
+                std::vector<entry> _free;
         };
 
-        struct application {
+        struct render_graph {
             public:
-                application( const char* title = "OGE Application", const utils::vec2u& size = { 1024, 512 } );
-                virtual ~application() = default;
+                using resource = uint32_t;
+                static constexpr resource invalid = ~0u;
+
+                struct builder {
+                    public:
+                        resource create(const char* name, const texture_desc& desc);
+                        resource read(resource r);
+                        resource write(resource r);
+                        // keep this pass even if nothing reads what it writes
+                        void side_effect();
+
+                    private:
+                        friend struct render_graph;
+                        builder(render_graph& graph, uint32_t pass) : _graph(graph), _pass(pass) {}
+                        render_graph& _graph;
+                        uint32_t _pass;
+                };
 
-                void run();
+                struct context {
+                    public:
+                        unsigned int texture(resource r) const;
+                        const texture_desc& desc(resource r) const;
+                        // logical size over physical size, scale uvs by this when sampling
+                        glm::vec2 uv_scale(resource r) const;
+
+                    private:
+                        friend struct render_graph;
+                        context(const render_graph& graph) : _graph(graph) {}
+                        const render_graph& _graph;
+                };
 
-                void on_event(events::event& event);
+                struct stats {
+                    unsigned int passes = 0, culled_passes = 0;
+                    unsigned int transient_targets = 0, pooled_targets = 0;
+                };
 
-                void push_layer(layer* layer);
-                void push_overlay(layer* overlay);
+                using setup_fn = std::function<void(builder&)>;
+                using execute_fn = std::function<void(const context&)>;
 
-                inline window& get_window() { return *_window; }
-                inline static application& get() { return *_instance; }
+                render_graph() = default;
+                ~render_graph();
+
+                render_graph(const render_graph&) = delete;
+                render_graph& operator=(const render_graph&) = delete;
+
+                resource import(const char* name, unsigned int texture, const texture_desc& desc);
+                // the default framebuffer; writing it counts as a side effect
+                resource import_backbuffer(unsigned int width, unsigned int height);
+
+                void add_pass(const char* name, const setup_fn& setup, const execute_fn& execute);
+
+                // culls, allocates, runs every live pass and resets for the next frame
+                void execute();
+
+                const stats& statistics() const { return _stats; }
+                render_target_pool& pool() { return _pool; }
 
             private:
-                bool on_window_close(events::window_close_event& event);
+                struct resource_node {
+                    const char* name;
+                    texture_desc desc;
+                    bool imported = false, backbuffer = false;
+                    render_target_pool::target physical = { 0, {} };
+
+                    std::vector<uint32_t> writers = {};
+                    uint32_t ref_count = 0;
+                    uint32_t first_pass = ~0u, last_pass = 0;
+                };
+
+                struct pass_node {
+                    const char* name;
+                    execute_fn execute;
+                    std::vector<resource> reads = {}, writes = {};
+                    bool side_effect = false;
+                    uint32_t ref_count = 0;
+                    bool culled = false;
+                };
+
+                void compile();
+                unsigned int framebuffer_for(const pass_node& pass);
 
             private:
-                static application* _instance;
-                std::unique_ptr<window> _window;
+                std::vector<resource_node> _resources;
+                std::vector<pass_node> _passes;
 
-                bool _running = true;
-                float _lastframe_time = 0.0f;
+                render_target_pool _pool;
+                // keyed by attachment texture names, depth flagged in the top bit
+                std::map<std::vector<unsigned int>, std::unique_ptr<framebuffer>> _framebuffers;
+                stats _stats;
+        };
 
-                layer_stack _layer_stack;
+        // meshes
+
+        // cpu-side indexed triangle mesh; every stream but positions is optional,
+        // when present it has one entry per position
+        struct mesh_data {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec2> uvs;
+            std::vector<glm::vec4> tangents;   // w is the bitangent sign
+            std::vector<glm::vec4> colors;
+            std::vector<uint32_t> indices;
+
+            inline size_t vertex_count() const { return positions.size(); }
+            inline size_t triangle_count() const { return indices.size() / 3; }
         };
 
+        // quadric error metric edge collapse onto existing vertices, so every lod can
+        // share the source vertex buffer. returns the simplified index buffer and the
+        // largest error accepted (in squared distance units)
+        std::vector<uint32_t> simplify(const mesh_data& mesh, const std::vector<uint32_t>& indices,
+                                       size_t target_triangles, float max_error = std::numeric_limits<float>::max(),
+                                       float* result_error = nullptr);
+
+        struct mesh_lods {
+            struct level {
+                uint32_t first_index, index_count;
+                float error;
+            };
+
+            // all levels packed back to back, level 0 is the source
+            std::vector<uint32_t> indices;
+            std::vector<level> levels;
+        };
 
-    }
+        mesh_lods generate_lods(const mesh_data& mesh, unsigned int count = 4, float ratio = 0.5f);
 
-    namespace utils {
+        struct lod_selector {
+            public:
+                // thresholds[i] is the projected height (fraction of the viewport) below
+                // which level i + 1 takes over; must be descending
+                lod_selector(std::vector<float> thresholds = { 0.25f, 0.12f, 0.06f, 0.03f }, float hysteresis = 0.15f);
 
-        struct ortho_camera_controller {
+                unsigned int select(const presepctive_camera& camera, const glm::vec3& center, float radius, unsigned int current) const;
+                // updates `levels` in place for every sphere, in parallel
+                void select(const presepctive_camera& camera, const sphere_soa& bounds, std::vector<uint8_t>& levels) const;
+
+            private:
+                unsigned int select(float projected, unsigned int current) const;
+
+            private:
+                std::vector<float> _thresholds;
+                float _hysteresis;
+        };
+
+        // occlusion
+
+        // rasterizes a few big occluders into a small cpu depth buffer, builds a
+        // max-depth pyramid and rejects boxes that sit entirely behind it
+        struct occlusion_culler {
             public:
-                ortho_camera_controller(float aspect_ratio, bool rotation = false);
+                struct stats {
+                    size_t occluder_triangles = 0;
+                    size_t tested = 0;
+                    size_t culled = 0;
+                };
 
-                void on_update(const float& dt);
-                void on_event(events::event& e);
+                occlusion_culler(unsigned int width = 256, unsigned int height = 128);
 
-                ortho_camera& camera() { return _camera; }
-                const ortho_camera& camera() const { return _camera; }
+                void begin(const glm::mat4& view_projection);
+                void begin(const presepctive_camera& camera) { begin(camera.view_projection()); }
+                void add_occluder(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+                                  const glm::mat4& model = glm::mat4(1.0f));
+                // rasterizes the occluders and builds the pyramid
+                void finish();
 
-                float zoom_level() const { return _zoom_level; }
-                void set_zoom_level(float level) { _zoom_level = level; }
+                // keeps the candidates whose box may be visible; candidates usually come from cull()
+                size_t test(const aabb_soa& boxes, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& visible);
 
-            private:
-                bool on_mouse_scroll(events::mouse_scroll_event& e);
-                bool on_window_resize(events::window_resize_event& e);
+                const stats& statistics() const { return _stats; }
+                // level 0 is full resolution, depth in [0, 1]
+                const std::vector<float>& level(unsigned int i) const { return _levels[i]; }
 
             private:
-                float _aspect_ratio;
-                float _zoom_level = 1.0f;
+                void rasterize(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, int y_begin, int y_end);
+                bool occluded(const glm::vec3& min, const glm::vec3& max) const;
 
-                ortho_camera _camera;
+            private:
+                unsigned int _width, _height, _stride;
+                glm::mat4 _view_projection;
 
-                bool _rotation;
+                // screen-space x, y, depth and w per occluder vertex
+                std::vector<glm::vec4> _vertices;
+                std::vector<uint32_t> _indices;
 
-                glm::vec3 _camera_position = { 0.0f, 0.0f, 0.0f };
+                std::vector<std::vector<float>> _levels;
+                std::vector<glm::uvec2> _level_sizes;
+                stats _stats;
+        };
 
-                float _camera_rotation = 0.0f;
-                float _camera_translation_speed = 5.0f, _camera_rotation_speed = 180.0f;
+        // clustered lighting
+
+        // matches the std430 layout of `light` in clustered_frag.glsl.
+        // spot_cos is the cosine of the outer cone angle, -1 makes a point light
+        struct light {
+            glm::vec3 position = { 0.0f, 0.0f, 0.0f };
+            float radius = 1.0f;
+            glm::vec3 color = { 1.0f, 1.0f, 1.0f };
+            float intensity = 1.0f;
+            glm::vec3 direction = { 0.0f, 0.0f, -1.0f };
+            float spot_cos = -1.0f;
         };
 
-        struct presepctive_camera_controller {
+        // splits the camera frustum into grid.x * grid.y screen tiles and grid.z
+        // exponential depth slices and lists the lights touching each cluster.
+        // shaders read them from bindings 0 (lights), 1 (offset, count per cluster) and 2 (indices)
+        struct light_clusters {
             public:
-                presepctive_camera_controller(float fov, float aspect_ratio, float near_clip, float far_clip);
+                struct stats {
+                    size_t lights = 0;
+                    size_t assignments = 0;
+                    size_t dropped = 0;   // lights past max_per_cluster
+                };
 
-                void on_update(const float& dt);
-                void on_event(events::event& e);
+                light_clusters(const glm::uvec3& grid = { 16, 9, 24 }, unsigned int max_per_cluster = 128);
 
-                presepctive_camera& camera() { return _camera; }
-                const presepctive_camera& camera() const { return _camera; }
+                void update(const presepctive_camera& camera, const std::vector<light>& lights);
+                // binds the storage buffers and sets the u_cluster_* uniforms
+                void bind(shader& s, const glm::vec2& viewport) const;
 
-                float zoom_level() const { return _zoom_level; }
-                void set_zoom_level(float level) { _zoom_level = level; }
+                const glm::uvec3& grid() const { return _grid; }
+                const std::vector<glm::uvec2>& clusters() const { return _clusters; }
+                const std::vector<uint32_t>& indices() const { return _indices; }
+                const stats& statistics() const { return _stats; }
 
             private:
-                bool on_mouse_scroll(events::mouse_scroll_event& e);
-                bool on_window_resize(events::window_resize_event& e);
+                void build_bounds(const glm::mat4& projection);
+                void assign_slice(unsigned int z, std::vector<uint32_t>& out, size_t& dropped);
 
             private:
-                float _aspect_ratio;
-                float _zoom_level = 1.0f;
+                glm::uvec3 _grid;
+                unsigned int _max_per_cluster;
 
-                presepctive_camera _camera;
+                glm::mat4 _projection = glm::mat4(0.0f);
+                float _near = 0.0f, _far = 0.0f;
+                // view-space bounds per cluster, x fastest
+                std::vector<glm::vec3> _bounds_min, _bounds_max;
 
-                glm::vec3 _camera_position = { 0.0f, 0.0f, 0.0f };
+                // view-space lights, SoA for the sphere tests
+                std::vector<float> _x, _y, _z, _r;
+                std::vector<glm::vec4> _spot;   // view-space direction, cos; w = -1 for point lights
 
-                float _camera_rotation = 0.0f;
-                float _camera_translation_speed = 5.0f, _camera_rotation_speed = 180.0f;
+                std::vector<glm::uvec2> _clusters;
+                std::vector<uint32_t> _indices;
+                std::vector<std::vector<uint32_t>> _slices;
+
+                instance_buffer _light_buffer, _cluster_buffer, _index_buffer;
+                stats _stats;
         };
-        
-    }
 
-}
+        // vertex layouts
+
+        // compressed encodings are decoded by the attribute fetch except the octahedral
+        // ones, which arrive as a normalized vec2 (see packed_vert.glsl).
+        // half positions keep ~3 significant digits, so keep meshes near their origin
+        enum class vertex_format {
+            float2, float3, float4,
+            half2, half4,
+            octahedral,           // unit vector in 2 x snorm16
+            octahedral_tangent,   // unit vector + handedness in the low bit of y
+            unorm8x4
+        };
 
-#endif//OGE_HH
-// #define OGE_IMPL
-#ifdef OGE_IMPL
+        enum class vertex_semantic { position, normal, tangent, uv, color };
 
-#include <fstream>
-#include <sstream>
+        struct vertex_attribute {
+            vertex_semantic semantic;
+            vertex_format format;
+            unsigned int location;
+        };
 
-namespace oge {
+        uint32_t pack_octahedral(const glm::vec3& n);
+        glm::vec3 unpack_octahedral(uint32_t packed);
+        // w is the bitangent sign
+        uint32_t pack_tangent(const glm::vec4& t);
+        glm::vec4 unpack_tangent(uint32_t packed);
 
-    namespace utils {
-            
-        std::shared_ptr<spdlog::logger> log::_core_logger;
-    
-        void log::init() {
-            spdlog::set_pattern("%^[%T] %n: %v%$");
-            _core_logger = spdlog::stdout_color_mt("OGE");
+        // interleaved vertex layout, attributes are laid out in the order given
+        struct vertex_layout {
+            public:
+                vertex_layout(std::initializer_list<vertex_attribute> attributes);
+
+                // binds vbo to the vao and points every attribute into it
+                void attach(unsigned int vao, unsigned int vbo) const;
+
+                void encode(const glm::vec4& value, size_t attribute, void* vertex) const;
+                glm::vec4 decode(const void* vertex, size_t attribute) const;
+                // interleaves a mesh, missing streams get neutral defaults
+                std::vector<uint8_t> pack(const mesh_data& mesh) const;
+
+                inline size_t stride() const { return _stride; }
+                inline size_t offset(size_t attribute) const { return _offsets[attribute]; }
+                inline const std::vector<vertex_attribute>& attributes() const { return _attributes; }
+
+                static size_t format_size(vertex_format format);
+
+            private:
+                std::vector<vertex_attribute> _attributes;
+                std::vector<size_t> _offsets;
+                size_t _stride = 0;
+        };
+
+        // mesh optimization
+
+        struct vertex_cache_stats {
+            float acmr = 0.0f;   // transformed vertices per triangle, 0.5 is ideal on big meshes
+            float atvr = 0.0f;   // transformed vertices per unique vertex, 1 is ideal
+        };
+
+        struct vertex_fetch_stats {
+            size_t bytes_fetched = 0;
+            float overfetch = 0.0f;   // bytes fetched over the bytes of all referenced vertices
+        };
+
+        // fifo post-transform cache
+        vertex_cache_stats analyze_vertex_cache(const std::vector<uint32_t>& indices, size_t vertex_count, unsigned int cache_size = 16);
+        // 64 byte lines through a 16 KiB direct mapped cache, for vertices missing the post-transform cache
+        vertex_fetch_stats analyze_vertex_fetch(const std::vector<uint32_t>& indices, size_t vertex_count, size_t vertex_size);
+
+        // merges bit-identical vertices across all streams, returns the new vertex count
+        size_t deduplicate_vertices(mesh_data& mesh);
+        // forsyth's linear-speed triangle order
+        void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count);
+        // reorders runs of cache-friendly triangles so outward facing ones come first.
+        // run after optimize_vertex_cache, the acmr barely moves
+        void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions);
+        // renumbers vertices in first-use order and drops unreferenced ones, returns the new vertex count
+        size_t optimize_vertex_fetch(mesh_data& mesh);
+
+        struct index_data {
+            std::vector<uint8_t> data;
+            GLenum type = GL_UNSIGNED_INT;
+            size_t count = 0;
+        };
+
+        // 16-bit indices whenever every vertex fits
+        index_data pack_indices(const std::vector<uint32_t>& indices, size_t vertex_count);
+
+        struct mesh_optimize_report {
+            size_t vertices_before = 0, vertices_after = 0;
+            vertex_cache_stats cache_before, cache_after;
+            vertex_fetch_stats fetch_before, fetch_after;
+        };
+
+        // the whole pipeline in order, vertex_size is the packed size (vertex_layout::stride())
+        mesh_optimize_report optimize_mesh(mesh_data& mesh, size_t vertex_size);
+
+        // memory mapped files
+
+        // read-only mapping of a whole file. empty files are valid with a null data()
+        struct mapped_file {
+            public:
+                mapped_file() = default;
+                explicit mapped_file(const char* path);
+                ~mapped_file();
+
+                mapped_file(mapped_file&& other) noexcept;
+                mapped_file& operator=(mapped_file&& other) noexcept;
+                mapped_file(const mapped_file&) = delete;
+                mapped_file& operator=(const mapped_file&) = delete;
+
+                inline bool valid() const { return _open; }
+                inline const uint8_t* data() const { return _data; }
+                inline size_t size() const { return _size; }
+                inline std::string_view view() const { return { (const char*)_data, _size }; }
+
+            private:
+                void close();
+
+            private:
+                const uint8_t* _data = nullptr;
+                size_t _size = 0;
+                bool _open = false;
+                void* _mapping = nullptr;   // windows only
+        };
+
+        // asset packs
+
+        // reads `path` from the newest mounted pack holding it, otherwise from disk
+        std::string read_file(const char* path);
+
+        // one file of 4 KiB aligned entries behind a table of contents sorted by name hash.
+        // entries are stored raw, viewable in place, or as independent lz4 blocks that
+        // decompress in parallel
+        struct asset_pack {
+            public:
+                // on-disk toc record, read straight out of the mapping
+                struct entry {
+                    uint64_t hash;
+                    uint64_t offset;        // from the start of the pack
+                    uint64_t size;          // unpacked
+                    uint64_t stored_size;   // block table included
+                    uint32_t name_offset, name_size;
+                    uint32_t flags;
+                    uint32_t reserved;
+                };
+
+                static constexpr uint32_t compressed = 1;
+
+                asset_pack() = default;
+                explicit asset_pack(const char* path);
+
+                inline bool valid() const { return _names != nullptr; }
+                inline std::span<const entry> entries() const { return { _entries, _count }; }
+                inline size_t block_size() const { return _block_size; }
+
+                const entry* find(std::string_view name) const;
+                std::string_view name(const entry& e) const;
+                // zero copy, empty for compressed entries
+                std::span<const uint8_t> view(const entry& e) const;
+                // dst holds e.size bytes; false when the entry is corrupt
+                bool read(const entry& e, uint8_t* dst) const;
+
+                // '\\' to '/', no leading "./"
+                static std::string normalize(std::string_view name);
+                static uint64_t hash(std::string_view name);
+
+                // mounts are searched newest first; change them at startup and shutdown only,
+                // pointers handed out by locate() die with the pack
+                static bool mount(const char* path);
+                static void unmount_all();
+                static const asset_pack* locate(std::string_view name);
+
+            private:
+                mapped_file _file;
+                const entry* _entries = nullptr;
+                size_t _count = 0;
+                size_t _block_size = 0;
+                const char* _names = nullptr;
+                size_t _names_size = 0;
+        };
+
+        struct asset_pack_builder {
+            public:
+                explicit asset_pack_builder(size_t block_size = 64 * 1024);
+
+                // a later add with the same name replaces the earlier one
+                void add(std::string_view name, std::vector<uint8_t> data, bool compress = true);
+                bool add_file(std::string_view name, const char* path, bool compress = true);
+                // every regular file below dir, named "dir/relative/path" the way read_file asks for it
+                size_t add_directory(const char* dir, bool compress = true);
+
+                // blocks compress on the thread pool; entries that shrink by less than 1/8 stay raw
+                bool write(const char* path) const;
+
+            private:
+                struct pending {
+                    std::vector<uint8_t> data;
+                    bool compress;
+                };
+
+                size_t _block_size;
+                std::map<std::string, pending> _files;
+        };
+
+        // decimal float at p, advances p past it. returns false if there is no number there
+        bool parse_float(const char*& p, const char* end, float& out);
+
+        // model import
+
+        struct submesh {
+            uint32_t first_index;
+            uint32_t index_count;
+        };
+
+        struct model_data {
+            mesh_data mesh;
+            std::vector<submesh> submeshes;
+        };
+
+        // .obj, .gltf or .glb by extension; glTF node transforms are baked in.
+        // logs and returns false on failure
+        bool import_model(const char* path, model_data& out);
+
+        struct interleaved_mesh {
+            std::vector<uint8_t> vertices;
+            index_data indices;
+            std::vector<submesh> submeshes;
+            size_t vertex_count = 0;
+        };
+
+        // import_model, optionally the optimize_* passes per submesh, then packed to layout
+        interleaved_mesh import_mesh(const char* path, const vertex_layout& layout, bool optimize = true);
+
+        // textures
+
+        // rgba8 texture. the path constructor decodes on the thread pool and the pixels
+        // reach the GPU through a staging PBO in process_uploads(); until then id() and
+        // bind() use a shared placeholder
+        struct texture2d {
+            public:
+                struct stats {
+                    size_t pending = 0;
+                    size_t uploaded_bytes = 0;   // this frame
+                };
+
+                explicit texture2d(const char* path, bool mips = true, bool srgb = false);
+                texture2d(unsigned int width, unsigned int height, const void* rgba, bool mips = false, bool srgb = false);
+                ~texture2d();
+
+                texture2d(const texture2d&) = delete;
+                texture2d& operator=(const texture2d&) = delete;
+
+                void bind(unsigned int slot = 0) const;
+
+                unsigned int id() const;
+                bool ready() const;
+                bool failed() const;
+                unsigned int width() const;
+                unsigned int height() const;
+
+                // GL thread, once per frame. stops after `budget` bytes so big levels stream in
+                static void process_uploads(size_t budget = 32 << 20);
+                static unsigned int placeholder();
+                static const stats& statistics();
+                static void shutdown();
+
+                // opaque, shared between the texture, its decode job and the upload queue
+                struct state;
+
+            private:
+                std::shared_ptr<state> _state;
+        };
+
+        // block compression
+
+        #ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+        #define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+        #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+        #endif
+        #ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+        #define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+        #define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+        #endif
+
+        // bc1: rgb + 1 bit alpha, bc3: rgba, bc4: r, bc5: rg (normal maps), bc7: rgba (mode 6 only)
+        enum class block_format { bc1, bc3, bc4, bc5, bc7 };
+
+        size_t block_bytes(block_format format);
+        GLenum gl_format(block_format format, bool srgb);
+
+        // encodes rgba8 pixels into 4x4 blocks, rows of blocks run on the thread pool.
+        // edge blocks of sizes that aren't multiples of 4 repeat the last row/column
+        std::vector<uint8_t> compress_blocks(const uint8_t* rgba, unsigned int width, unsigned int height, block_format format);
+
+        // decodes an image with stb_image, builds the mip chain, compresses every level and
+        // writes a container whose level payloads are 16 byte aligned and stored as-is
+        bool cook_texture(const char* source, const char* destination, block_format format, bool srgb = false, bool mips = true);
+
+        // a cooked container, mapped; level data points straight into the mapping
+        struct cooked_texture {
+            public:
+                struct level {
+                    unsigned int width, height;
+                    const uint8_t* data;
+                    size_t size;
+                };
+
+                explicit cooked_texture(const char* path);
+
+                inline bool valid() const { return !_levels.empty(); }
+                inline GLenum format() const { return _format; }
+                inline unsigned int width() const { return _levels.empty() ? 0 : _levels[0].width; }
+                inline unsigned int height() const { return _levels.empty() ? 0 : _levels[0].height; }
+                inline const std::vector<level>& levels() const { return _levels; }
+
+                // immutable storage with every level uploaded, 0 on failure
+                unsigned int upload() const;
+
+            private:
+                mapped_file _file;
+                GLenum _format = 0;
+                std::vector<level> _levels;
+        };
+
+        // image kernels
+
+        enum class image_filter { box, triangle, kaiser };
+
+        // rgba8, rows top to bottom as stored
+        struct image {
+            unsigned int width = 0, height = 0;
+            std::vector<uint8_t> pixels;
+        };
+
+        // alpha is always linear. the avx2/sse paths produce the same bytes as the scalar ones
+        void srgb_to_linear(const uint8_t* src, float* dst, size_t pixels);
+        void linear_to_srgb(const float* src, uint8_t* dst, size_t pixels);
+        void premultiply_alpha(uint8_t* rgba, size_t pixels);
+        // output channel i takes input channel order[i], { 2, 1, 0, 3 } turns bgra into rgba
+        void swizzle(uint8_t* rgba, size_t pixels, const std::array<uint8_t, 4>& order);
+
+        // separable, filtered in linear light when srgb is set; rows run on the thread pool
+        image resize(const image& src, unsigned int width, unsigned int height, image_filter filter = image_filter::kaiser, bool srgb = true);
+        // src and every level down to 1x1, each level filtered from the previous one in float
+        std::vector<image> generate_mips(const image& src, image_filter filter = image_filter::box, bool srgb = true);
+
+        // plain loops the kernels above are measured against
+        namespace scalar {
+            void srgb_to_linear(const uint8_t* src, float* dst, size_t pixels);
+            void linear_to_srgb(const float* src, uint8_t* dst, size_t pixels);
+            void premultiply_alpha(uint8_t* rgba, size_t pixels);
+            void swizzle(uint8_t* rgba, size_t pixels, const std::array<uint8_t, 4>& order);
+        }
+
+        // logs simd vs scalar timings on a size x size image
+        void benchmark_image_kernels(unsigned int size = 2048);
+
+        // asset manager
+
+        enum class asset_state { empty, loading, ready, failed };
+
+        struct asset_id {
+            uint32_t index = 0, generation = 0;   // generation 0 never names a live slot
+
+            inline bool valid() const { return generation != 0; }
+            bool operator==(const asset_id&) const = default;
+        };
+
+        template<typename T> struct asset_handle {
+            asset_id id;
+
+            inline bool valid() const { return id.valid(); }
+            bool operator==(const asset_handle&) const = default;
+        };
+
+        struct asset_size {
+            size_t cpu = 0, gpu = 0;
+        };
+
+        // specialized per asset type:
+        //   payload                                        built on a worker from the key
+        //   static payload decode(const std::string& key)
+        //   static std::unique_ptr<T> create(payload&& p)   main thread, may touch GL; nullptr fails the load
+        //   static asset_size size(const T& asset)          zero while the asset is still streaming in
+        template<typename T> struct asset_loader;
+
+        // key is "vertex_path|fragment_path"
+        template<> struct asset_loader<shader> {
+            using payload = shader_source;
+            static payload decode(const std::string& key);
+            static std::unique_ptr<shader> create(payload&& source);
+            static asset_size size(const shader& program);
+        };
+
+        // key is the image path; texture2d decodes and uploads on its own
+        template<> struct asset_loader<texture2d> {
+            using payload = std::string;
+            static payload decode(const std::string& key);
+            static std::unique_ptr<texture2d> create(payload&& path);
+            static asset_size size(const texture2d& texture);
+        };
+
+        template<> struct asset_loader<model_data> {
+            using payload = std::unique_ptr<model_data>;
+            static payload decode(const std::string& key);
+            static std::unique_ptr<model_data> create(payload&& model);
+            static asset_size size(const model_data& model);
+        };
+
+        // typed generational handles over shared, deduplicated assets. loads decode on the
+        // thread pool and finish in update(); unreferenced assets stay cached and are evicted
+        // least recently used first once either budget is exceeded. main thread only
+        struct asset_manager {
+            public:
+                struct stats {
+                    size_t assets = 0;
+                    size_t loading = 0;
+                    size_t cpu_bytes = 0;
+                    size_t gpu_bytes = 0;
+                    size_t dedup_hits = 0;
+                    size_t evictions = 0;
+                };
+
+                asset_manager(size_t cpu_budget = size_t(512) << 20, size_t gpu_budget = size_t(1) << 30);
+                ~asset_manager();
+
+                asset_manager(const asset_manager&) = delete;
+                asset_manager& operator=(const asset_manager&) = delete;
+
+                // the same type and key give back the same asset with one more reference. it is
+                // created once every dependency is ready and fails when any of them fails
+                template<typename T> asset_handle<T> load(std::string_view key, std::initializer_list<asset_id> dependencies = {}) {
+                    static const type_ops ops = {
+                        [](void* payload) -> void* { return asset_loader<T>::create(std::move(*(typename asset_loader<T>::payload*)payload)).release(); },
+                        [](void* object) { delete (T*)object; },
+                        [](const void* object) { return asset_loader<T>::size(*(const T*)object); }
+                    };
+                    return { acquire(type_id<T>(), key, dependencies, ops, [key = std::string(key)]() -> std::shared_ptr<void> {
+                        return std::make_shared<typename asset_loader<T>::payload>(asset_loader<T>::decode(key));
+                    }) };
+                }
+
+                // nullptr until ready
+                template<typename T> T* get(asset_handle<T> handle) { return (T*)object(handle.id, type_id<T>()); }
+
+                asset_state state(asset_id id) const;
+                void retain(asset_id id);
+                // at zero references the asset stays cached until the budget needs its memory
+                void release(asset_id id);
+
+                // once per frame: creates decoded assets, picks up sizes of streamed ones, evicts to budget
+                void update();
+                void evict_unused();
+                // destroys everything, outstanding handles go stale
+                void clear();
+
+                void set_budget(size_t cpu, size_t gpu);
+                inline const stats& statistics() const { return _stats; }
+
+                static asset_manager& global();
+
+            private:
+                struct type_ops {
+                    void* (*create)(void* payload);
+                    void (*destroy)(void* object);
+                    asset_size (*size)(const void* object);
+                };
+
+                struct slot {
+                    uint32_t generation = 1;
+                    uint32_t type = 0;
+                    asset_state state = asset_state::empty;
+                    uint32_t references = 0;
+                    std::string key;
+                    const type_ops* ops = nullptr;
+                    void* object = nullptr;
+                    std::future<std::shared_ptr<void>> decoding;
+                    std::vector<asset_id> dependencies;
+                    asset_size size;
+                    bool cached = false;              // unreferenced, sitting in _lru
+                    std::list<uint32_t>::iterator lru;
+                };
+
+                asset_id acquire(uint32_t type, std::string_view key, std::initializer_list<asset_id> dependencies,
+                                 const type_ops& ops, std::function<std::shared_ptr<void>()> decode);
+                void* object(asset_id id, uint32_t type);
+                slot* resolve(asset_id id);
+                const slot* resolve(asset_id id) const;
+                void evict(uint32_t index);
+                bool over_budget() const;
+
+                static uint32_t next_type_id();
+                template<typename T> static uint32_t type_id() {
+                    static const uint32_t id = next_type_id();
+                    return id;
+                }
+
+            private:
+                std::vector<slot> _slots;
+                std::vector<uint32_t> _free;
+                std::unordered_map<std::string, uint32_t> _lookup;
+                std::list<uint32_t> _lru;            // front is the least recently released
+                size_t _cpu_budget, _gpu_budget;
+                stats _stats;
+        };
+
+        // virtual file system
+
+        enum class io_priority { low, normal, high };
+        enum class io_status { ok, missing, failed, cancelled };
+
+        struct io_result {
+            io_status status = io_status::failed;
+            std::vector<uint8_t> data;
+
+            inline bool ok() const { return status == io_status::ok; }
+        };
+
+        using io_callback = std::function<void(io_result&&)>;
+
+        struct io_request {
+            uint64_t ticket = 0;
+            std::future<io_result> result;
+        };
+
+        // mount points over directories and asset packs, searched newest first; paths no
+        // mount claims are read as they are. one i/o thread keeps up to `queue_depth` reads
+        // in flight through io_uring on linux and through a few blocking reader threads
+        // elsewhere; packed entries decompress on the thread pool. callbacks run on any of those
+        struct vfs {
+            public:
+                struct stats {
+                    size_t submitted = 0;
+                    size_t completed = 0;
+                    size_t cancelled = 0;
+                    size_t bytes_read = 0;
+                };
+
+                explicit vfs(unsigned int queue_depth = 64);
+                ~vfs();
+
+                vfs(const vfs&) = delete;
+                vfs& operator=(const vfs&) = delete;
+
+                // mount_directory("", "res") resolves "shaders/x.glsl" to res/shaders/x.glsl
+                bool mount_directory(std::string_view prefix, const char* dir);
+                bool mount_pack(std::string_view prefix, const char* path);
+                void unmount_all();
+
+                io_request read_async(std::string_view path, io_priority priority = io_priority::normal);
+                uint64_t read_async(std::string_view path, io_callback done, io_priority priority = io_priority::normal);
+                // blocks the caller, queued ahead of everything else. packed entries are read on
+                // the global thread pool, so this must not be called from one of its jobs
+                io_result read(std::string_view path);
+                // queued reads complete as cancelled right away, reads in flight once their i/o
+                // returns, which io_uring is asked to cut short. false when the ticket already completed
+                bool cancel(uint64_t ticket);
+
+                inline bool uses_io_uring() const { return _ring != nullptr; }
+                stats statistics() const;
+
+                static vfs& global();
+
+                // opaque io_uring instance, linux only
+                struct ring;
+
+            private:
+                struct mount {
+                    std::string prefix;
+                    std::string directory;
+                    std::unique_ptr<asset_pack> pack;
+                };
+
+                struct request {
+                    uint64_t ticket;
+                    std::string path;
+                    io_callback done;
+                };
+
+                // where a path ended up: a pack entry, a file on disk, or nothing
+                struct target {
+                    const asset_pack* pack = nullptr;
+                    const asset_pack::entry* entry = nullptr;
+                    std::string file;
+                };
+
+                void worker();
+                // loose files when there is no io_uring, kept off the shared pool so blocking
+                // reads can't starve its jobs
+                void reader();
+                void read_on_pool(request& req, target where);
+                target resolve(std::string_view path) const;
+                void finish(uint64_t ticket, const io_callback& done, io_result&& result);
+                void wake();
+
+            private:
+                unsigned int _depth;
+                std::vector<mount> _mounts;
+                mutable std::mutex _mutex;
+                std::condition_variable _cv;
+                std::array<std::deque<request>, 3> _queues;   // indexed by io_priority
+                std::unordered_map<uint64_t, bool> _active;   // ticket -> cancelled
+                uint64_t _next_ticket = 1;
+                std::atomic<unsigned int> _in_flight = 0;
+                std::atomic<unsigned int> _pool_jobs = 0;
+                bool _stop = false;
+                stats _stats;
+
+                std::unique_ptr<ring> _ring;
+                std::thread _thread;
+                std::vector<uint64_t> _cancels;               // in flight on the ring, cancel pending
+
+                std::deque<std::pair<request, std::string>> _file_reads;
+                std::condition_variable _read_cv;
+                std::vector<std::thread> _readers;
+                bool _readers_stop = false;
+        };
+
+        // asset cooking
+
+        // turns one source file into `output`. other files it read (includes, referenced
+        // assets) go into `dependencies` so that editing them re-cooks this one too
+        struct cook_rule {
+            std::vector<std::string> extensions;   // ".png", compared lowercase
+            std::string output_extension;
+            std::string parameters;                // part of the cache key, change it to force a re-cook
+            std::function<bool(const std::string& input, const std::string& output, std::vector<std::string>& dependencies)> cook;
+        };
+
+        struct cook_report {
+            size_t cooked = 0;
+            size_t up_to_date = 0;
+            size_t failed = 0;
+            size_t removed = 0;
+            double milliseconds = 0.0;
+        };
+
+        // runtime side of the cooker: source path -> cooked file
+        struct cook_manifest {
+            public:
+                bool load(const char* path);
+                // relative source path in, path of the cooked file out
+                const std::string* find(std::string_view source) const;
+                inline size_t size() const { return _outputs.size(); }
+
+            private:
+                std::unordered_map<std::string, std::string> _outputs;
+        };
+
+        // walks `source_dir`, cooks whatever a rule claims into `output_dir` and only redoes
+        // assets whose content, dependencies or rule parameters changed since the last run.
+        // unchanged files are recognised by size and mtime before anything is hashed
+        struct asset_cooker {
+            public:
+                static constexpr const char* manifest_name = "cook_manifest.txt";
+
+                asset_cooker(std::string source_dir, std::string output_dir);
+
+                void add_rule(cook_rule rule);
+                // images to bc7 .otex, glsl with #include "..." inlined
+                void add_default_rules();
+
+                cook_report cook();
+
+            private:
+                std::string _source, _output;
+                std::vector<cook_rule> _rules;
+        };
+
+        // texture streaming
+
+        // cooked textures whose finer mips come and go with on-screen demand. the small mip
+        // tail is loaded up front and never leaves; finer levels are read off the mapping on
+        // the thread pool and uploaded within a per-frame byte budget. storage holds only the
+        // resident range, so growing or dropping a level moves the texture to a new allocation
+        // (levels are copied on the gpu) and texture() must be looked up every frame
+        struct texture_streamer {
+            public:
+                struct stats {
+                    size_t textures = 0;
+                    size_t resident_bytes = 0;
+                    size_t uploaded_bytes = 0;   // this frame
+                    size_t streaming = 0;
+                    size_t dropped_levels = 0;
+                };
+
+                static constexpr uint32_t invalid = ~0u;
+
+                texture_streamer(size_t memory_budget = size_t(256) << 20, size_t upload_budget = size_t(8) << 20, unsigned int tail_size = 64);
+                ~texture_streamer();
+
+                texture_streamer(const texture_streamer&) = delete;
+                texture_streamer& operator=(const texture_streamer&) = delete;
+
+                // a cooked .otex; only its tail is uploaded before this returns
+                uint32_t add(const char* path);
+                void remove(uint32_t texture);
+
+                void begin_frame(const presepctive_camera& camera, const vec2u& viewport);
+                // something sampling `texture` covers the sphere; uv_scale is how often the
+                // texture repeats across its diameter
+                void request(uint32_t texture, const glm::vec3& center, float radius, float uv_scale = 1.0f);
+                // GL thread, after the frame's requests
+                void update();
+
+                unsigned int texture(uint32_t texture) const;
+                void bind(uint32_t texture, unsigned int slot = 0) const;
+                unsigned int resident_level(uint32_t texture) const;
+                unsigned int wanted_level(uint32_t texture) const;
+
+                inline const stats& statistics() const { return _stats; }
+
+            private:
+                struct entry {
+                    std::unique_ptr<cooked_texture> source;
+                    unsigned int id = 0;
+                    unsigned int resident = 0;       // finest level in storage
+                    unsigned int tail = 0;           // first level of the permanent tail
+                    unsigned int wanted = 0;         // finest level asked for this frame
+                    uint64_t last_requested = 0;
+                    float min_lod = 0.0f;            // fades new detail in over a few frames
+                    std::future<std::vector<uint8_t>> staging;
+                    unsigned int staging_level = 0;  // what the read in flight holds
+                };
+
+                void reallocate(entry& e, unsigned int first);
+                size_t level_bytes(const entry& e, unsigned int first) const;
+
+            private:
+                size_t _memory_budget, _upload_budget;
+                unsigned int _tail_size;
+                std::vector<entry> _entries;
+                std::vector<uint32_t> _free;
+                glm::mat4 _view = glm::mat4(1.0f);
+                float _pixels_per_unit = 1.0f;   // projected size of one unit at distance one
+                uint64_t _frame = 0;
+                stats _stats;
+        };
+
+    }
+
+    namespace events {
+
+        enum class type {
+            none = 0,
+            window_close, window_resize, window_focus, window_move,
+            key_press, key_release, key_type,
+            mouse_button_press, mouse_button_release, mouse_move, mouse_scroll
+        };
+
+        enum category {
+            none = 0,
+            application = 1 << 0,
+            input = 1 << 1,
+            keyboard = 1 << 2,
+            mouse = 1 << 3,
+            mouse_button = 1 << 4,
+        };
+
+        #define ECT(etype) \
+            static type get_static_type() { return type::##etype; } \
+            virtual type get_type() const override { return get_static_type(); } \
+            virtual const char* get_name() const override { return #etype; }
+
+        #define ECC(ecat) \
+            virtual int get_category_flags() const override { return ecat; } 
+
+        
+        // heap allocated events come from the global pool
+        struct event : public utils::pool_allocated {
+            public:
+                virtual ~event() = default;
+
+                bool handled = false;
+
+                virtual type get_type() const = 0;
+                virtual const char* get_name() const = 0;
+                virtual int get_category_flags() const = 0;
+                virtual std::string to_string() const { return get_name(); }
+
+                inline bool is_in_category(category cat) const { return get_category_flags() & cat; }
+        
+                inline friend std::ostream& operator<<(std::ostream& os, const event& e) {
+                    return os << e.to_string();
+                }
+        };
+
+        struct event_dispatcher {
+            public:
+                event_dispatcher(event& event) : _event(event) {}
+
+                template<typename T, typename F>
+                bool dispatch(const F& func) {
+                    if (_event.get_type() == T::get_static_type()) {
+                        _event.handled |= func(static_cast<T&>(_event));
+                        return true;
+                    }
+                    return false;
+                }
+
+            private:
+                event& _event;
+        };
+
+
+        struct key_event : public event {
+            public:
+                inline int code() const { return _code; }
+                ECC(keyboard | input)
+            protected:
+                key_event(int key_code) : _code(key_code) {}
+                int _code;
+        };
+
+        struct key_press_event : public key_event {
+            public:
+                key_press_event(int key_code, int repeat_count) : key_event(key_code), _repeat_count(repeat_count) {}
+                inline int repeat_count() const { return _repeat_count; }
+
+                std::string to_string() const override {
+                    return std::format("key_press_event: {} ({} repeats)", _code, _repeat_count);
+                }
+
+                ECT(key_press)
+            private:
+                int _repeat_count;
+        };
+
+        struct key_release_event : public key_event {
+            public:
+                key_release_event(int key_code) : key_event(key_code) {}
+
+                std::string to_string() const override {
+                    return std::format("key_release_event: {}", _code);
+                }
+
+                ECT(key_release)
+        };
+
+        struct key_type_event : public key_event {
+            public:
+                key_type_event(int key_code) : key_event(key_code) {}
+
+                std::string to_string() const override {
+                    return std::format("key_type_event: {}", _code);
+                }
+
+                ECT(key_type)
+        };
+
+        struct mouse_button_event : public event {
+            public:
+                inline int button() const { return _button; }
+                ECC(mouse_button | input)
+            protected:
+                mouse_button_event(int button) : _button(button) {}
+                int _button;
+        };
+
+        struct mouse_button_press_event : public mouse_button_event {
+            public:
+                mouse_button_press_event(int button) : mouse_button_event(button) {}
+
+                std::string to_string() const override {
+                    return std::format("mouse_button_press_event: {}", _button);
+                }
+
+                ECT(mouse_button_press)
+        };
+
+        struct mouse_button_release_event : public mouse_button_event {
+            public:
+                mouse_button_release_event(int button) : mouse_button_event(button) {}
+
+                std::string to_string() const override {
+                    return std::format("mouse_button_release_event: {}", _button);
+                }
+
+                ECT(mouse_button_release)
+        };
+
+        struct mouse_move_event : public event {
+            public:
+                mouse_move_event(const utils::vec2f& pos) : _pos(pos) {}
+
+                inline float x() const { return _pos.x; }
+                inline float y() const { return _pos.y; }
+
+                std::string to_string() const override {
+                    return std::format("mouse_move_event: {}, {}", _pos.x, _pos.y);
+                }
+
+                ECT(mouse_move)
+                ECC(mouse | input)
+            private:
+                utils::vec2f _pos;
+        };
+
+        struct mouse_scroll_event : public event {
+            public:
+                mouse_scroll_event(const utils::vec2f& offset) : _offset(offset) {}
+
+                inline float x() const { return _offset.x; }
+                inline float y() const { return _offset.y; }
+
+                std::string to_string() const override {
+                    return std::format("mouse_scroll_event: {}, {}", _offset.x, _offset.y);
+                }
+
+                ECT(mouse_scroll)
+                ECC(mouse | input)
+            private:
+                utils::vec2f _offset;
+        };
+
+        struct window_resize_event : public event {
+            public:
+                window_resize_event(const utils::vec2u& size) : _size(size) {}
+
+                inline unsigned int width() const { return _size.x; }
+                inline unsigned int height() const { return _size.y; }
+
+                std::string to_string() const override {
+                    return std::format("window_resize_event: {}, {}", _size.x, _size.y);
+                }
+
+                ECT(window_resize)
+                ECC(application)
+            private:
+                utils::vec2u _size;
+        };
+
+        struct window_close_event : public event {
+            public:
+                window_close_event() {}
+
+                std::string to_string() const override {
+                    return std::format("window_close_event");
+                }
+
+                ECT(window_close)
+                ECC(application)
+        };
+
+        struct window_focus_event : public event {
+            public:
+                window_focus_event(bool focused) : _focused(focused) {}
+
+                inline bool focused() const { return _focused; }
+
+                std::string to_string() const override {
+                    return std::format("window_focus_event: {}", _focused);
+                }
+
+                ECT(window_focus)
+                ECC(application)
+            private:
+                bool _focused;
+        };
+
+        struct window_move_event : public event {
+            public:
+                window_move_event(const utils::vec2i& pos) : _pos(pos) {}
+
+                inline int x() const { return _pos.x; }
+                inline int y() const { return _pos.y; }
+
+                std::string to_string() const override {
+                    return std::format("window_move_event: {}, {}", _pos.x, _pos.y);
+                }
+
+                ECT(window_move)
+                ECC(application)
+            private:
+                utils::vec2i _pos;
+        };
+
+
+    }
+
+
+    namespace core {
+
+        struct glfw {
+            public:
+                static void init();
+                static void terminate();
+            private:
+                static bool initialized;
+        };
+
+        struct ogl {
+            public:
+                static void init();
+                static void terminate();
+            private:
+                static bool initialized;
+        };
+
+
+        class input {
+            protected:
+                input() = default;
+            public:
+                input(const input&) = delete;
+                input& operator=(const input&) = delete;
+
+                static bool is_key_pressed(int key_code);
+                static bool is_mouse_button_pressed(int button);
+                static utils::vec2f mouse_position();
+        };
+
+        struct callbacks {
+            static void error_callback(int error, const char* description);
+
+            static void window_size_callback(GLFWwindow* window, int width, int height);
+            static void window_close_callback(GLFWwindow* window);
+            // static void window_refresh_callback(GLFWwindow* window);
+            static void window_focus_callback(GLFWwindow* window, int focused);
+            // static void window_iconify_callback(GLFWwindow* window, int iconified);
+            // static void window_maximize_callback(GLFWwindow* window, int maximized);
+            // static void window_content_scale_callback(GLFWwindow* window, float xscale, float yscale);
+            static void window_pos_callback(GLFWwindow* window, int xpos, int ypos);
+
+            static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+            static void key_type_callback(GLFWwindow* window, unsigned int codepoint);
+
+            static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+            static void mouse_position_callback(GLFWwindow* window, double xpos, double ypos);
+            static void mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+            
+        };
+
+        using window_event_callback_fn = std::function<void(events::event&)>;
+
+        struct window_state {
+
+            const char* title = "OGE Window";
+
+            utils::vec2i position;
+            utils::vec2u size = { 1024, 512 };
+            utils::vec2u framebuffer_size;
+            utils::vec2f cursor_position;
+            utils::vec2f scroll_offset;
+
+            bool vsync = true;
+            bool fullscreen = false;
+
+            window_event_callback_fn callback;
+
+            GLFWwindow* window;
+            GLFWmonitor* monitor;
+
+            window_state(
+                const char* title = "OGE Window",
+                const utils::vec2u& size = { 1024, 512 }
+            ) : title(title), size(size) {}
+
+        };
+
+        // reads finished frames back through a ring of persistently mapped pixel
+        // buffers; a fence tells us when a readback landed and a worker thread
+        // converts and writes it, so the GL thread never waits on glReadPixels
+        struct frame_capture {
+            public:
+                enum class format { png, y4m };
+
+                struct stats {
+                    size_t captured = 0;
+                    size_t written = 0;
+                    size_t dropped = 0;
+                };
+
+                // png: `path` is a prefix for path_000000.png, ...; y4m: one 4:2:0 stream
+                frame_capture(const char* path, format fmt, const utils::vec2u& size, unsigned int fps = 60, unsigned int ring = 3);
+                ~frame_capture();
+
+                frame_capture(const frame_capture&) = delete;
+                frame_capture& operator=(const frame_capture&) = delete;
+
+                // call with the finished frame still in the back buffer
+                void capture();
+
+                inline const utils::vec2u& size() const { return _size; }
+                inline bool ok() const { return _ok; }
+                stats statistics() const;
+
+            private:
+                struct slot {
+                    unsigned int pbo = 0;
+                    unsigned char* mapped = nullptr;
+                    GLsync fence = nullptr;
+                    uint64_t frame = 0;
+                    // set by the gl thread when handed over, cleared by the worker
+                    std::atomic<bool> busy = false;
+                };
+
+                void collect(bool wait);
+                void worker();
+                void write_png(const unsigned char* pixels, uint64_t frame);
+                void write_y4m(const unsigned char* pixels);
+
+            private:
+                std::string _path;
+                format _format;
+                utils::vec2u _size;
+                unsigned int _fps;
+                bool _ok = true;
+
+                std::vector<std::unique_ptr<slot>> _slots;
+                unsigned int _next = 0;
+                uint64_t _frame = 0;
+
+                std::ofstream _stream;
+                std::vector<unsigned char> _convert;
+
+                std::thread _thread;
+                std::mutex _mutex;
+                std::condition_variable _cv;
+                std::deque<slot*> _queue;
+                bool _stop = false;
+
+                std::atomic<size_t> _captured = 0, _written = 0, _dropped = 0;
+        };
+
+        struct window {
+            public:
+                window( const window_state& state = window_state());
+                ~window();
+
+                void on_update();
+
+                inline const utils::vec2u& size() const { return state.size; }
+
+                void set_event_callback(const window_event_callback_fn& callback);
+                void set_vsync(bool enabled);
+                void set_fullscreen(bool enabled);
+                void set_icon(const char* path);
+
+                bool is_vsync() const;
+                bool is_fullscreen() const;
+
+                inline bool is_open() const { return !glfwWindowShouldClose(state.window); }
+
+                inline void* native_window() const { return state.window; }
+
+                // records every presented frame until end_capture()
+                bool begin_capture(const char* path, frame_capture::format fmt = frame_capture::format::y4m, unsigned int fps = 60);
+                void end_capture();
+                inline bool is_capturing() const { return _capture != nullptr; }
+                inline const frame_capture* capture() const { return _capture.get(); }
+
+            private:
+                void init();
+                void shutdown();
+
+            private:
+                window_state state;
+                std::unique_ptr<frame_capture> _capture;
+                // framebuffer size when the capture began, before any format rounding
+                utils::vec2u _capture_size = { 0, 0 };
+        };
+
+        // layers are created with new and deleted by the layer_stack, both through the global pool
+        struct layer : public utils::pool_allocated {
+            public:
+                layer(const char* name = "Layer") : _name(name) {}
+                virtual ~layer() = default;
+
+                virtual void on_attach() {}
+                virtual void on_detach() {}
+                virtual void on_update( const float&) {}
+                virtual void on_event(events::event&) {}
+
+                virtual void pre_update() {}
+                virtual void post_update() {}
+                
+                inline const char* name() const { return _name; }
+
+            protected:
+                const char* _name;
+        };
+
+        struct imgui_layer : public layer {
+            public:
+                imgui_layer();
+                ~imgui_layer() = default;
+
+                virtual void on_attach() override;
+                virtual void on_detach() override;
+                virtual void on_update( const float&) override {}
+                virtual void on_event(events::event&) override;
+
+                void pre_update() override;
+                void post_update() override;
+
+                bool on_mouse_button_press(events::mouse_button_event& e);
+
+        };
+
+        struct layer_stack {
+            public:
+                layer_stack();
+                ~layer_stack();
+
+                void push_layer(layer* layer);
+                void pop_layer(layer* layer);
+                void push_overlay(layer* overlay);
+                void pop_overlay(layer* overlay);
+
+                std::vector<layer*>::iterator begin() { return _layers.begin(); }
+                std::vector<layer*>::iterator end() { return _layers.end(); }
+            private:
+                std::vector<layer*> _layers;
+                size_t _layer_insert_index = 0;
+        };
+
+        struct application {
+            public:
+                application( const char* title = "OGE Application", const utils::vec2u& size = { 1024, 512 } );
+                virtual ~application() = default;
+
+                void run();
+
+                void on_event(events::event& event);
+
+                void push_layer(layer* layer);
+                void push_overlay(layer* overlay);
+
+                inline window& get_window() { return *_window; }
+                inline static application& get() { return *_instance; }
+
+            private:
+                bool on_window_close(events::window_close_event& event);
+
+            private:
+                static application* _instance;
+                std::unique_ptr<window> _window;
+
+                bool _running = true;
+                float _lastframe_time = 0.0f;
+
+                layer_stack _layer_stack;
+        };
+
+
+    }
+
+    namespace utils {
+
+        struct ortho_camera_controller {
+            public:
+                ortho_camera_controller(float aspect_ratio, bool rotation = false);
+
+                void on_update(const float& dt);
+                void on_event(events::event& e);
+
+                ortho_camera& camera() { return _camera; }
+                const ortho_camera& camera() const { return _camera; }
+
+                float zoom_level() const { return _zoom_level; }
+                void set_zoom_level(float level) { _zoom_level = level; }
+
+            private:
+                bool on_mouse_scroll(events::mouse_scroll_event& e);
+                bool on_window_resize(events::window_resize_event& e);
+
+            private:
+                float _aspect_ratio;
+                float _zoom_level = 1.0f;
+
+                ortho_camera _camera;
+
+                bool _rotation;
+
+                glm::vec3 _camera_position = { 0.0f, 0.0f, 0.0f };
+
+                float _camera_rotation = 0.0f;
+                float _camera_translation_speed = 5.0f, _camera_rotation_speed = 180.0f;
+        };
+
+        struct presepctive_camera_controller {
+            public:
+                presepctive_camera_controller(float fov, float aspect_ratio, float near_clip, float far_clip);
+
+                void on_update(const float& dt);
+                void on_event(events::event& e);
+
+                presepctive_camera& camera() { return _camera; }
+                const presepctive_camera& camera() const { return _camera; }
+
+                float zoom_level() const { return _zoom_level; }
+                void set_zoom_level(float level) { _zoom_level = level; }
+
+            private:
+                bool on_mouse_scroll(events::mouse_scroll_event& e);
+                bool on_window_resize(events::window_resize_event& e);
+
+            private:
+                float _aspect_ratio;
+                float _zoom_level = 1.0f;
+
+                presepctive_camera _camera;
+
+                glm::vec3 _camera_position = { 0.0f, 0.0f, 0.0f };
+
+                float _camera_rotation = 0.0f;
+                float _camera_translation_speed = 5.0f, _camera_rotation_speed = 180.0f;
+        };
+        
+    }
+
+}
+
+#endif//OGE_HH
+// #define OGE_IMPL
+#ifdef OGE_IMPL
+
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <cctype>
+
+#if defined(_WIN32)
+#undef APIENTRY
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#endif
+#endif
+
+// stb stays static, imgui.lib carries its own stb_truetype; the parts oge never calls would
+// otherwise warn as unused in every translation unit with OGE_IMPL
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4505)
+#endif
+
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imgui/imstb_truetype.h"
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+namespace oge {
+
+    namespace utils {
+            
+        std::shared_ptr<spdlog::logger> log::_core_logger;
+    
+        void log::init() {
+            spdlog::set_pattern("%^[%T] %n: %v%$");
+            _core_logger = spdlog::stdout_color_mt("OGE");
             _core_logger->set_level(spdlog::level::trace);
         }  
    
-        // ogldbg
+        // ogldbg
+
+        ogldbg::level ogldbg::_level = ogldbg::level::highassert;
+
+        void ogldbg::init() {
+            glDebugMessageCallback(message, nullptr);
+            glEnable(GL_DEBUG_OUTPUT);
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+
+        void ogldbg::set_level( const ogldbg::level& lvl) {
+            _level = lvl;
+        }
+
+        // jobs
+
+        thread_pool::thread_pool(unsigned int threads) {
+            _threads.reserve(threads);
+            for (unsigned int i = 0; i < threads; i++) {
+                _threads.emplace_back(&thread_pool::worker, this);
+            }
+        }
+
+        thread_pool::~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _cv.notify_all();
+            for (std::thread& t : _threads) {
+                t.join();
+            }
+        }
+
+        thread_pool& thread_pool::global() {
+            static thread_pool pool;
+            return pool;
+        }
+
+        namespace pool_detail {
+            static thread_local const thread_pool* current = nullptr;
+        }
+
+        bool thread_pool::is_worker() const {
+            return pool_detail::current == this;
+        }
+
+        void thread_pool::enqueue(std::function<void()> job) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _jobs.push_back(std::move(job));
+            }
+            _cv.notify_one();
+        }
+
+        void thread_pool::worker() {
+            pool_detail::current = this;
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _cv.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+                    if (_stop && _jobs.empty()) {
+                        return;
+                    }
+                    job = std::move(_jobs.front());
+                    _jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+        void thread_pool::parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+            if (!count) {
+                return;
+            }
+            grain = std::max<size_t>(grain, 1);
+            size_t ranges = (count + grain - 1) / grain;
+            if (ranges == 1 || _threads.empty()) {
+                fn(0, count);
+                return;
+            }
+
+            // helpers may be dequeued after we return, so the counters must outlive
+            // this frame; `fn` is only touched while ranges are still outstanding
+            struct counters { std::atomic<size_t> next = 0, done = 0; };
+            auto state = std::make_shared<counters>();
+            const auto* body = &fn;
+            auto work = [state, body, count, grain, ranges]() {
+                size_t r;
+                while ((r = state->next.fetch_add(1)) < ranges) {
+                    (*body)(r * grain, std::min(count, (r + 1) * grain));
+                    state->done.fetch_add(1, std::memory_order_release);
+                }
+            };
+
+            size_t helpers = std::min<size_t>(_threads.size(), ranges - 1);
+            for (size_t i = 0; i < helpers; i++) {
+                enqueue(work);
+            }
+            work();
+
+            // every range is claimed by now, only wait for the ones still running elsewhere.
+            // picking up unrelated queued jobs here could stall the caller on a decode or load
+            while (state->done.load(std::memory_order_acquire) < ranges) {
+                std::this_thread::yield();
+            }
+        }
+
+        // frame memory
+
+        namespace arena_detail {
+
+            static std::atomic<uint64_t> frame = 0;
+
+            struct frame_resource final : std::pmr::memory_resource {
+                void* do_allocate(size_t bytes, size_t alignment) override { return frame_arena::local().allocate(bytes, alignment); }
+                void do_deallocate(void*, size_t, size_t) override {}
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+            };
+
+        }
+
+        frame_arena::frame_arena(size_t chunk_size) : _chunk_size(std::max<size_t>(chunk_size, 4096)), _frame(arena_detail::frame.load()) {}
+
+        frame_arena::~frame_arena() {
+            for (chunk& c : _chunks) {
+                ::operator delete(c.data, std::align_val_t(64));
+            }
+        }
+
+        void* frame_arena::allocate(size_t size, size_t alignment) {
+            uint64_t frame = arena_detail::frame.load(std::memory_order_relaxed);
+            if (_frame != frame) {
+                _frame = frame;
+                reset();
+            }
+            size = std::max<size_t>(size, 1);
+            while (_current < _chunks.size()) {
+                chunk& c = _chunks[_current];
+                uintptr_t base = (uintptr_t)c.data;
+                size_t offset = ((base + _offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+                if (offset + size <= c.size) {
+                    _offset = offset + size;
+                    _used += size;
+                    return c.data + offset;
+                }
+                _current++;
+                _offset = 0;
+            }
+            size_t bytes = std::max(_chunk_size, size + alignment);
+            _chunks.push_back({ (uint8_t*)::operator new(bytes, std::align_val_t(64)), bytes });
+            _capacity += bytes;
+            _current = _chunks.size() - 1;
+            _offset = 0;
+            return allocate(size, alignment);
+        }
+
+        void frame_arena::reset() {
+            if (_chunks.size() > 1) {
+                for (chunk& c : _chunks) {
+                    ::operator delete(c.data, std::align_val_t(64));
+                }
+                _chunks.clear();
+                _chunks.push_back({ (uint8_t*)::operator new(_capacity, std::align_val_t(64)), _capacity });
+            }
+            _current = 0;
+            _offset = 0;
+            _used = 0;
+        }
+
+        frame_arena& frame_arena::local() {
+            thread_local frame_arena arena;
+            return arena;
+        }
+
+        std::pmr::memory_resource* frame_arena::resource() {
+            static arena_detail::frame_resource resource;
+            return &resource;
+        }
+
+        void frame_arena::next_frame() {
+            arena_detail::frame.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // pooled memory
+
+        namespace pool_detail {
+
+            static constexpr size_t slab_size = 64 * 1024;
+
+            // 16 byte steps up to 256, powers of two above. over-aligned requests round up to a
+            // power of two so every block of their class lands on the alignment
+            inline uint32_t size_class(size_t bytes, size_t alignment) {
+                if (alignment > 16) {
+                    bytes = std::bit_ceil(std::max(bytes, alignment));
+                }
+                if (bytes <= 256) {
+                    return (uint32_t)((std::max<size_t>(bytes, 1) + 15) / 16 - 1);
+                }
+                return (uint32_t)std::bit_width(bytes - 1) + 7;
+            }
+
+            inline size_t class_size(uint32_t size_class) {
+                return size_class < 16 ? (size_class + 1) * 16 : size_t(256) << (size_class - 15);
+            }
+
+            // blocks a thread takes from or hands back to the pool at once
+            inline size_t batch(uint32_t size_class) {
+                return std::clamp<size_t>(16384 / class_size(size_class), 4, 64);
+            }
+
+            inline bool pooled(size_t bytes, size_t alignment) {
+                return alignment <= 64 && bytes <= pool_resource::max_block;
+            }
+
+            struct registry {
+                std::mutex lock;
+                std::unordered_set<uint64_t> live;
+                uint64_t next = 1;
+            };
+
+            // never destroyed, threads flush their caches on exit, possibly during static teardown
+            inline registry& pools() {
+                static registry* pools = new registry();
+                return *pools;
+            }
+
+        }
+
+        struct pool_resource::thread_cache {
+            struct list {
+                void* head = nullptr;
+                size_t count = 0;
+            };
+
+            struct entry {
+                uint64_t id;
+                pool_resource* pool;
+                list lists[classes];
+            };
+
+            std::vector<entry> entries;
+            size_t last = 0;
+
+            list& find(pool_resource* pool, uint32_t size_class) {
+                if (last < entries.size() && entries[last].id == pool->_id) {
+                    return entries[last].lists[size_class];
+                }
+                for (last = 0; last < entries.size(); last++) {
+                    if (entries[last].id == pool->_id) {
+                        return entries[last].lists[size_class];
+                    }
+                }
+                // first use of this pool on this thread, drop lists of pools that are gone
+                {
+                    pool_detail::registry& pools = pool_detail::pools();
+                    std::lock_guard<std::mutex> guard(pools.lock);
+                    std::erase_if(entries, [&](const entry& e) { return !pools.live.contains(e.id); });
+                }
+                entries.push_back({ pool->_id, pool, {} });
+                last = entries.size() - 1;
+                return entries[last].lists[size_class];
+            }
+
+            ~thread_cache() {
+                pool_detail::registry& pools = pool_detail::pools();
+                std::lock_guard<std::mutex> guard(pools.lock);
+                for (entry& e : entries) {
+                    if (!pools.live.contains(e.id)) {
+                        continue;
+                    }
+                    for (uint32_t c = 0; c < classes; c++) {
+                        void* tail = e.lists[c].head;
+                        if (!tail) {
+                            continue;
+                        }
+                        while (*(void**)tail) {
+                            tail = *(void**)tail;
+                        }
+                        e.pool->release(c, e.lists[c].head, tail);
+                    }
+                }
+            }
+
+            static thread_cache& local() {
+                thread_local thread_cache cache;
+                return cache;
+            }
+        };
+
+        pool_resource::pool_resource() {
+            pool_detail::registry& pools = pool_detail::pools();
+            std::lock_guard<std::mutex> guard(pools.lock);
+            _id = pools.next++;
+            pools.live.insert(_id);
+        }
+
+        pool_resource::~pool_resource() {
+            {
+                pool_detail::registry& pools = pool_detail::pools();
+                std::lock_guard<std::mutex> guard(pools.lock);
+                pools.live.erase(_id);
+            }
+            for (void* slab : _slabs) {
+                ::operator delete(slab, std::align_val_t(64));
+            }
+        }
+
+        void* pool_resource::do_allocate(size_t bytes, size_t alignment) {
+            if (!pool_detail::pooled(bytes, alignment)) {
+                _large.fetch_add(1, std::memory_order_relaxed);
+                return ::operator new(bytes, std::align_val_t(std::max(alignment, alignof(std::max_align_t))));
+            }
+            uint32_t size_class = pool_detail::size_class(bytes, alignment);
+            thread_cache::list& free = thread_cache::local().find(this, size_class);
+            if (!free.head) {
+                size_t count = pool_detail::batch(size_class);
+                refill(size_class, count, free.head);
+                free.count = count;
+            }
+            void* block = free.head;
+            free.head = *(void**)block;
+            free.count--;
+            return block;
+        }
+
+        void pool_resource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+            if (!pool_detail::pooled(bytes, alignment)) {
+                _large.fetch_sub(1, std::memory_order_relaxed);
+                ::operator delete(p, std::align_val_t(std::max(alignment, alignof(std::max_align_t))));
+                return;
+            }
+            uint32_t size_class = pool_detail::size_class(bytes, alignment);
+            thread_cache::list& free = thread_cache::local().find(this, size_class);
+            *(void**)p = free.head;
+            free.head = p;
+            free.count++;
+
+            // a thread that frees more than it allocates hands its colder half back to the pool
+            size_t batch = pool_detail::batch(size_class);
+            if (free.count >= 2 * batch) {
+                void* keep = free.head;
+                for (size_t i = 1; i < batch; i++) {
+                    keep = *(void**)keep;
+                }
+                void* head = *(void**)keep;
+                void* tail = head;
+                while (*(void**)tail) {
+                    tail = *(void**)tail;
+                }
+                *(void**)keep = nullptr;
+                free.count = batch;
+                release(size_class, head, tail);
+            }
+        }
+
+        void pool_resource::refill(uint32_t size_class, size_t count, void*& head) {
+            central& pool = _central[size_class];
+            size_t size = pool_detail::class_size(size_class);
+            std::lock_guard<std::mutex> guard(pool.lock);
+            while (count && pool.free) {
+                void* block = pool.free;
+                pool.free = *(void**)block;
+                *(void**)block = head;
+                head = block;
+                count--;
+            }
+            while (count) {
+                if ((size_t)(pool.end - pool.cursor) < size) {
+                    uint8_t* slab = (uint8_t*)::operator new(pool_detail::slab_size, std::align_val_t(64));
+                    {
+                        std::lock_guard<std::mutex> slabs(_slab_lock);
+                        _slabs.push_back(slab);
+                    }
+                    pool.cursor = slab;
+                    pool.end = slab + pool_detail::slab_size - pool_detail::slab_size % size;
+                }
+                // fresh blocks are linked in address order
+                size_t n = std::min(count, (size_t)(pool.end - pool.cursor) / size);
+                uint8_t* first = pool.cursor;
+                for (size_t i = 0; i + 1 < n; i++) {
+                    *(void**)(first + i * size) = first + (i + 1) * size;
+                }
+                *(void**)(first + (n - 1) * size) = head;
+                head = first;
+                pool.cursor += n * size;
+                count -= n;
+            }
+        }
+
+        void pool_resource::release(uint32_t size_class, void* head, void* tail) {
+            central& pool = _central[size_class];
+            std::lock_guard<std::mutex> guard(pool.lock);
+            *(void**)tail = pool.free;
+            pool.free = head;
+        }
+
+        pool_resource::stats pool_resource::statistics() const {
+            stats result;
+            {
+                std::lock_guard<std::mutex> guard(_slab_lock);
+                result.slabs = _slabs.size();
+            }
+            result.reserved = result.slabs * pool_detail::slab_size;
+            result.large = _large.load(std::memory_order_relaxed);
+            return result;
+        }
+
+        pool_resource& pool_resource::global() {
+            // left alive through exit, objects in static storage may still release into it
+            static pool_resource* pool = new pool_resource();
+            return *pool;
+        }
+
+        void ogldbg::message(GLenum, GLenum, GLuint, GLenum severity, GLsizei, const GLchar* message, const void*) {
+            switch(severity) {
+                case GL_DEBUG_SEVERITY_HIGH:
+                    if (_level > level::high) {
+                        LOG_ERROR("OpenGL Error: {}", message);
+                        if(_level == level::highassert) {
+                            OGE_ASSERT(false, "OpenGL Error: {}", message);
+                        }
+                    }
+                    break;
+                case GL_DEBUG_SEVERITY_MEDIUM:
+                    if (_level > level::medium) {
+                        LOG_WARN("OpenGL Error: {}", message);
+                    }
+                    break;
+                case GL_DEBUG_SEVERITY_LOW:
+                    if (_level > level::low) {
+                        LOG_INFO("OpenGL Error: {}", message);
+                    }
+                    break;
+                case GL_DEBUG_SEVERITY_NOTIFICATION:
+                    if (_level > level::notification) {
+                        LOG_TRACE("OpenGL Error: {}", message);
+                    }
+                    break;
+            }
+        }
+   
+        // shader
+
+        std::string read_file(const char* path) {
+            if (const asset_pack* pack = asset_pack::locate(path)) {
+                const asset_pack::entry* e = pack->find(path);
+                std::string data(e->size, '\0');
+                if (!pack->read(*e, (uint8_t*)data.data())) {
+                    LOG_ERROR("Corrupt packed file: {}", path);
+                    return "";
+                }
+                return data;
+            }
+
+            std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+            if (!file) {
+                LOG_ERROR("Failed to open file: {}", path);
+                return "";
+            }
+            std::streamoff size = file.tellg();
+            if (size < 0) {
+                LOG_ERROR("Failed to read file: {}", path);
+                return "";
+            }
+            std::string data((size_t)size, '\0');
+            file.seekg(0);
+            file.read(data.data(), data.size());
+            return data;
+        }
+
+        shader::shader(const char* vertex_path, const char* fragment_path) {
+
+            std::string vertex_source = read_file(vertex_path);
+            std::string fragment_source = read_file(fragment_path);
+
+            _id = compile_program(vertex_source.c_str(), fragment_source.c_str());
+
+        }
+
+        shader::shader(const shader_source& source) {
+            _id = compile_program(source.vertex.c_str(), source.fragment.c_str());
+        }
+
+        void shader::bind() const { glUseProgram(_id); }
+        void shader::unbind() const { glUseProgram(0); }
+
+        void shader::set_uniform(const char* name, const int& value) {
+            glUniform1i(get_uniform_location(name), value);
+        }
+
+        void shader::set_uniform(const char* name, const unsigned int& value) {
+            glUniform1ui(get_uniform_location(name), value);
+        }
+
+        void shader::set_uniform(const char* name, const float& value) {
+            glUniform1f(get_uniform_location(name), value);
+        }
+
+        void shader::set_uniform(const char* name, const double& value) {
+            glUniform1d(get_uniform_location(name), value);
+        }
+
+        void shader::set_uniform(const char* name, const vec2i value) {
+            glUniform2i(get_uniform_location(name), value.x, value.y);
+        }
+
+        void shader::set_uniform(const char* name, const vec2u& value) {
+            glUniform2ui(get_uniform_location(name), value.x, value.y);
+        }
+
+        void shader::set_uniform(const char* name, const vec2f& value) {
+            glUniform2f(get_uniform_location(name), value.x, value.y);
+        }
+
+        void shader::set_uniform(const char* name, const vec2d& value) {
+            glUniform2d(get_uniform_location(name), value.x, value.y);
+        }
+
+        void shader::set_uniform(const char* name, const vec3i& value) {
+            glUniform3i(get_uniform_location(name), value.x, value.y, value.z);
+        }
+
+        void shader::set_uniform(const char* name, const vec3u& value) {
+            glUniform3ui(get_uniform_location(name), value.x, value.y, value.z);
+        }
+
+        void shader::set_uniform(const char* name, const vec3f& value) {
+            glUniform3f(get_uniform_location(name), value.x, value.y, value.z);
+        }
+
+        void shader::set_uniform(const char* name, const vec3d& value) {
+            glUniform3d(get_uniform_location(name), value.x, value.y, value.z);
+        }
+
+        void shader::set_uniform(const char* name, const vec4i& value) {
+            glUniform4i(get_uniform_location(name), value.x, value.y, value.z, value.w);
+        }
+
+        void shader::set_uniform(const char* name, const vec4u& value) {
+            glUniform4ui(get_uniform_location(name), value.x, value.y, value.z, value.w);
+        }
+
+        void shader::set_uniform(const char* name, const vec4f& value) {
+            glUniform4f(get_uniform_location(name), value.x, value.y, value.z, value.w);
+        }
+
+        void shader::set_uniform(const char* name, const vec4d& value) {
+            glUniform4d(get_uniform_location(name), value.x, value.y, value.z, value.w);
+        }
+
+        void shader::set_uniform(const char* name, const glm::vec2& value) {
+            glUniform2f(get_uniform_location(name), value.x, value.y);
+        }
+
+        void shader::set_uniform(const char* name, const glm::vec3& value) {
+            glUniform3f(get_uniform_location(name), value.x, value.y, value.z);
+        }
+
+        void shader::set_uniform(const char* name, const glm::vec4& value) {
+            glUniform4f(get_uniform_location(name), value.x, value.y, value.z, value.w);
+        }
+
+        void shader::set_uniform(const char* name, const glm::mat2& value) {
+            glUniformMatrix2fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(value));
+        }
+
+        void shader::set_uniform(const char* name, const glm::mat3& value) {
+            glUniformMatrix3fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(value));
+        }
+
+        void shader::set_uniform(const char* name, const glm::mat4& value) {
+            glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(value));
+        }
+
+        int shader::get_uniform_location(const char* name) {
+            auto it = _uniform_location_cache.find(std::string_view(name));
+            if (it != _uniform_location_cache.end()) {
+                return it->second;
+            }
+            int location = glGetUniformLocation(_id, name);
+            if (location == -1) {
+                LOG_WARN("Uniform '{}' doesn't exist!", name);
+            }
+            _uniform_location_cache.emplace(name, location);
+            return location;
+        }
+
+        unsigned int shader::compile_shader(unsigned int type, const char* source) {
+            unsigned int id = glCreateShader(type);
+            glShaderSource(id, 1, &source, nullptr);
+            glCompileShader(id);
+
+            int result;
+            glGetShaderiv(id, GL_COMPILE_STATUS, &result);
+            if (result == GL_FALSE) {
+                int length;
+                glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+                char* message = (char*)alloca(length * sizeof(char));
+                glGetShaderInfoLog(id, length, &length, message);
+                LOG_ERROR("Failed to compile {} shader:\n{}", (type == GL_VERTEX_SHADER ? "vertex" : "fragment"), message);
+                glDeleteShader(id);
+                return 0;
+            }
+            return id;
+        }
+
+        unsigned int shader::compile_program(const char* vertex_source, const char* fragment_source) {
+            unsigned int program = glCreateProgram();
+            unsigned int vs = compile_shader(GL_VERTEX_SHADER, vertex_source);
+            unsigned int fs = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+            glAttachShader(program, vs);
+            glAttachShader(program, fs);
+            glLinkProgram(program);
+            glValidateProgram(program);
+
+            int result;
+            glGetProgramiv(program, GL_LINK_STATUS, &result);
+            if (result == GL_FALSE) {
+                int length;
+                glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+                char* message = (char*)alloca(length * sizeof(char));
+                glGetProgramInfoLog(program, length, &length, message);
+                LOG_ERROR("Failed to link shader program:\n{}", message);
+
+                glDeleteProgram(program);
+                glDeleteShader(vs);
+                glDeleteShader(fs);
+                
+                return 0;
+            }
+
+            glDeleteShader(vs);
+            glDeleteShader(fs);
+
+            return program;
+        }
+
+
+        // camera code
+
+        ortho_camera::ortho_camera( const glm::vec4& bounds ) 
+            : _projection(glm::ortho(bounds.x, bounds.y, bounds.z, bounds.w, -1.0f, 1.0f)),
+              _view(1.0f)
+        {
+            _view_projection = _projection * _view;
+        }
+
+        void ortho_camera::set_projection(const glm::vec4& bounds) {
+            _projection = glm::ortho(bounds.x, bounds.y, bounds.z, bounds.w, -1.0f, 1.0f);
+            update_view();
+        }
+
+        void ortho_camera::update_view() {
+            glm::mat4 transform = glm::translate(
+                glm::mat4(1.0f),
+                _position
+            ) * glm::rotate(
+                glm::mat4(1.0f),
+                glm::radians(_rotation),
+                glm::vec3(0, 0, 1)
+            );
+            _view = glm::inverse(transform);
+            _view_projection = _projection * _view;
+        }
+
+        presepctive_camera::presepctive_camera(float fov, float aspect_ratio, float near_clip, float far_clip) {
+            set_projection(fov, aspect_ratio, near_clip, far_clip);
+        }
+
+        void presepctive_camera::set_projection(float fov, float aspect_ratio, float near_clip, float far_clip) {
+            _projection = glm::perspective(glm::radians(fov), aspect_ratio, near_clip, far_clip);
+            update_view();
+        }
+
+        void presepctive_camera::update_view() {
+            glm::mat4 transform = glm::translate(
+                glm::mat4(1.0f),
+                _position
+            ) * glm::rotate(
+                glm::mat4(1.0f),
+                glm::radians(_rotation),
+                glm::vec3(0, 0, 1)
+            );
+            _view = glm::inverse(transform);
+            _view_projection = _projection * _view;
+        }
+
+        // instancing
+
+        static size_t gl_type_size(GLenum type) {
+            switch (type) {
+                case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+                case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: return 2;
+                case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+                case GL_INT_2_10_10_10_REV: case GL_UNSIGNED_INT_2_10_10_10_REV: return 4;
+                case GL_DOUBLE: return 8;
+            }
+            OGE_ASSERT(false, "Unknown GL type");
+            return 0;
+        }
+
+        static bool gl_type_packed(GLenum type) {
+            return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+        }
+
+        instance_buffer::instance_buffer(std::initializer_list<instance_attribute> layout)
+            : _mode(mode::attribute), _layout(layout)
+        {
+            for (const instance_attribute& attr : _layout) {
+                _stride += gl_type_packed(attr.type) ? 4 : gl_type_size(attr.type) * attr.components;
+            }
+            glGenBuffers(1, &_id);
+        }
+
+        instance_buffer::instance_buffer(size_t stride, mode m) : _stride(stride), _mode(m) {
+            glGenBuffers(1, &_id);
+        }
+
+        instance_buffer::~instance_buffer() {
+            glDeleteBuffers(1, &_id);
+        }
+
+        void instance_buffer::attach(unsigned int vao) const {
+            OGE_ASSERT(_mode == mode::attribute, "Only attribute instance buffers can be attached to a vao");
+
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, _id);
+
+            size_t offset = 0;
+            for (const instance_attribute& attr : _layout) {
+                // a mat4 is 4 vec4 columns on consecutive locations
+                int columns = attr.components == 16 ? 4 : 1;
+                int components = attr.components == 16 ? 4 : attr.components;
+                size_t column_size = gl_type_packed(attr.type) ? 4 : gl_type_size(attr.type) * components;
+
+                for (int c = 0; c < columns; c++) {
+                    unsigned int location = attr.location + c;
+                    glEnableVertexAttribArray(location);
+
+                    bool integer = !attr.normalized && attr.type != GL_FLOAT && attr.type != GL_HALF_FLOAT
+                        && attr.type != GL_DOUBLE && !gl_type_packed(attr.type);
+                    if (integer) {
+                        glVertexAttribIPointer(location, components, attr.type, (GLsizei)_stride, (void*)offset);
+                    } else if (attr.type == GL_DOUBLE) {
+                        glVertexAttribLPointer(location, components, attr.type, (GLsizei)_stride, (void*)offset);
+                    } else {
+                        glVertexAttribPointer(location, components, attr.type, attr.normalized, (GLsizei)_stride, (void*)offset);
+                    }
+                    glVertexAttribDivisor(location, 1);
+                    offset += column_size;
+                }
+            }
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        void instance_buffer::bind_base(unsigned int binding) const {
+            OGE_ASSERT(_mode == mode::storage, "Only storage instance buffers can be bound as SSBO");
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _id);
+        }
+
+        void instance_buffer::upload(const void* data, size_t count) {
+            GLenum target = _mode == mode::attribute ? GL_ARRAY_BUFFER : GL_SHADER_STORAGE_BUFFER;
+            glBindBuffer(target, _id);
+
+            if (count > _capacity) {
+                // grow geometrically so steadily growing crowds don't realloc every frame
+                _capacity = std::max(count, _capacity + _capacity / 2);
+            }
+            // orphan the old storage so we never wait on draws still reading it
+            glBufferData(target, _capacity * _stride, nullptr, GL_STREAM_DRAW);
+
+            if (count) {
+                glBufferSubData(target, 0, count * _stride, data);
+            }
+            _count = count;
+
+            glBindBuffer(target, 0);
+        }
+
+        void draw_elements_instanced(unsigned int vao, int index_count, size_t instance_count, GLenum index_type) {
+            if (!instance_count) {
+                return;
+            }
+            glBindVertexArray(vao);
+            glDrawElementsInstanced(GL_TRIANGLES, index_count, index_type, nullptr, (GLsizei)instance_count);
+        }
+
+        // 2d batch
+
+        namespace gl_detail {
+
+            // blending as the caller left it, for passes that need their own and must put it back
+            struct blend_state {
+                GLboolean enabled;
+                GLint src_rgb, dst_rgb, src_alpha, dst_alpha;
+
+                blend_state() {
+                    enabled = glIsEnabled(GL_BLEND);
+                    glGetIntegerv(GL_BLEND_SRC_RGB, &src_rgb);
+                    glGetIntegerv(GL_BLEND_DST_RGB, &dst_rgb);
+                    glGetIntegerv(GL_BLEND_SRC_ALPHA, &src_alpha);
+                    glGetIntegerv(GL_BLEND_DST_ALPHA, &dst_alpha);
+                }
+
+                void restore() const {
+                    glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+                    if (enabled) {
+                        glEnable(GL_BLEND);
+                    } else {
+                        glDisable(GL_BLEND);
+                    }
+                }
+            };
+
+        }
+
+        batch2d::batch2d(size_t max_quads)
+            : _shader("res/shaders/batch_vert.glsl", "res/shaders/batch_frag.glsl"),
+              _max_quads(max_quads)
+        {
+            _vertices.reserve(max_quads * 4);
+
+            glGenVertexArrays(1, &_vao);
+            glBindVertexArray(_vao);
+
+            glGenBuffers(1, &_vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+            glBufferData(GL_ARRAY_BUFFER, max_quads * 4 * sizeof(vertex), nullptr, GL_DYNAMIC_DRAW);
+
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, position));
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, uv));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, color));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, texture));
+            glEnableVertexAttribArray(3);
+
+            // quad indices never change, build them once
+            std::vector<unsigned int> indices(max_quads * 6);
+            for (unsigned int q = 0, v = 0; q < indices.size(); q += 6, v += 4) {
+                indices[q + 0] = v + 0; indices[q + 1] = v + 1; indices[q + 2] = v + 2;
+                indices[q + 3] = v + 2; indices[q + 4] = v + 3; indices[q + 5] = v + 0;
+            }
+
+            glGenBuffers(1, &_ibo);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+            unsigned int white = 0xffffffff;
+            glGenTextures(1, &_white);
+            glBindTexture(GL_TEXTURE_2D, _white);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            _textures[0] = _white;
+        }
+
+        batch2d::~batch2d() {
+            glDeleteVertexArrays(1, &_vao);
+            glDeleteBuffers(1, &_vbo);
+            glDeleteBuffers(1, &_ibo);
+            glDeleteTextures(1, &_white);
+        }
+
+        void batch2d::begin(const glm::mat4& view_projection) {
+            _stats = {};
+            _shader.bind();
+            _shader.set_uniform("u_view_projection", view_projection);
+        }
+
+        void batch2d::end() {
+            flush();
+        }
+
+        void batch2d::draw_quad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color) {
+            draw_quad(position, size, _white, { 0.0f, 0.0f }, { 1.0f, 1.0f }, color);
+        }
+
+        void batch2d::draw_quad(const glm::vec3& position, const glm::vec2& size, unsigned int texture,
+                                const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec4& color) {
+            if (_vertices.size() >= _max_quads * 4) {
+                flush();
+            }
+
+            unsigned int slot = 0;
+            while (slot < _texture_count && _textures[slot] != texture) {
+                slot++;
+            }
+            if (slot == _texture_count) {
+                if (_texture_count == max_textures) {
+                    flush();
+                    slot = _texture_count;
+                }
+                _textures[_texture_count++] = texture;
+            }
+
+            float tex = (float)slot;
+            _vertices.push_back({ { position.x,          position.y,          position.z }, { uv0.x, uv0.y }, color, tex });
+            _vertices.push_back({ { position.x,          position.y + size.y, position.z }, { uv0.x, uv1.y }, color, tex });
+            _vertices.push_back({ { position.x + size.x, position.y + size.y, position.z }, { uv1.x, uv1.y }, color, tex });
+            _vertices.push_back({ { position.x + size.x, position.y,          position.z }, { uv1.x, uv0.y }, color, tex });
+        }
+
+        void batch2d::flush() {
+            if (!_vertices.empty()) {
+                glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, _vertices.size() * sizeof(vertex), _vertices.data());
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+                for (unsigned int i = 0; i < _texture_count; i++) {
+                    glBindTextureUnit(i, _textures[i]);
+                }
+
+                // glyph coverage and sprite edges live in alpha, blend them over what's underneath
+                gl_detail::blend_state blend;
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+                _shader.bind();
+                glBindVertexArray(_vao);
+                glDrawElements(GL_TRIANGLES, (GLsizei)(_vertices.size() / 4 * 6), GL_UNSIGNED_INT, nullptr);
+                blend.restore();
+
+                _stats.draw_calls++;
+                _stats.quads += (unsigned int)(_vertices.size() / 4);
+            }
+
+            _vertices.clear();
+            _texture_count = 1;
+        }
+
+        // text
+
+        static unsigned short _next_font_id = 0;
+
+        font::font(const char* path) : _data(read_file(path)), _id(_next_font_id++) {
+            if (_data.empty()) {
+                return;
+            }
+            const unsigned char* data = reinterpret_cast<const unsigned char*>(_data.data());
+            _info = std::make_unique<stbtt_fontinfo>();
+            if (!stbtt_InitFont(_info.get(), data, stbtt_GetFontOffsetForIndex(data, 0))) {
+                LOG_ERROR("Failed to load font: {}", path);
+                _info.reset();
+                return;
+            }
+            stbtt_GetFontVMetrics(_info.get(), &_ascent, &_descent, &_line_gap);
+            int x0, y0, x1, y1;
+            stbtt_GetFontBoundingBox(_info.get(), &x0, &y0, &x1, &y1);
+            _box_width = x1 - x0;
+            _box_height = y1 - y0;
+        }
+
+        font::~font() {}
+
+        float font::scale_for(float pixel_height) const {
+            return stbtt_ScaleForPixelHeight(_info.get(), pixel_height);
+        }
+
+        float font::line_height(float pixel_height) const {
+            return (_ascent - _descent + _line_gap) * scale_for(pixel_height);
+        }
+
+        unsigned int font::max_glyph_extent(float pixel_height) const {
+            // +1 for the pixel stb's rounded bitmap boxes can add on either side
+            return (unsigned int)std::ceil(std::max(_box_width, _box_height) * scale_for(pixel_height)) + 1;
+        }
+
+        glyph_atlas::glyph_atlas(unsigned int size, unsigned int cell)
+            : _size(size), _cell(cell), _columns(size / cell)
+        {
+            _cells.reserve(_columns * _columns);
+            _scratch.resize(cell * cell);
+
+            glGenTextures(1, &_texture);
+            glBindTexture(GL_TEXTURE_2D, _texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            // sample coverage as (1, 1, 1, r) so the batch can treat it like any rgba texture
+            GLint swizzle[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        glyph_atlas::~glyph_atlas() {
+            glDeleteTextures(1, &_texture);
+        }
+
+        bool glyph_atlas::fit(unsigned int extent) {
+            if (extent + 2 <= _cell) {
+                return false;
+            }
+            GLint max_size;
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+            _cell = std::bit_ceil(extent + 2);
+            _size = std::min(std::max(_size, _cell * 8), (unsigned int)max_size);
+            _cell = std::min(_cell, _size);
+            _columns = _size / _cell;
+
+            _cells.clear();
+            _lru.clear();
+            _lookup.clear();
+            _cells.reserve(_columns * _columns);
+            _scratch.resize(_cell * _cell);
+
+            glBindTexture(GL_TEXTURE_2D, _texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, _size, _size, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return true;
+        }
+
+        const glyph_atlas::glyph* glyph_atlas::acquire(const font& fnt, float pixel_height, int glyph_index) {
+            uint64_t key = ((uint64_t)fnt.id() << 48)
+                         | ((uint64_t)(pixel_height * 4.0f) & 0xffff) << 32
+                         | (uint32_t)glyph_index;
+
+            auto it = _lookup.find(key);
+            if (it != _lookup.end()) {
+                cell& c = _cells[it->second];
+                _lru.splice(_lru.begin(), _lru, c.lru);
+                c.frame = _frame;
+                return &c.uv;
+            }
+
+            unsigned int index;
+            if (_cells.size() < (size_t)_columns * _columns) {
+                index = (unsigned int)_cells.size();
+                _cells.push_back({});
+                _lru.push_front(index);
+                _cells[index].lru = _lru.begin();
+            } else {
+                index = _lru.back();
+                // evicting a glyph that's already in this frame's batch would corrupt it
+                if (_cells[index].frame == _frame) {
+                    return nullptr;
+                }
+                _lookup.erase(_cells[index].key);
+                _lru.splice(_lru.begin(), _lru, _cells[index].lru);
+                _evictions++;
+            }
+
+            cell& c = _cells[index];
+            c.key = key;
+            c.frame = _frame;
+            _lookup[key] = index;
+
+            float scale = fnt.scale_for(pixel_height);
+            int x0, y0, x1, y1;
+            stbtt_GetGlyphBitmapBox(fnt.info(), glyph_index, scale, scale, &x0, &y0, &x1, &y1);
+            // one texel of padding keeps linear filtering from bleeding into neighbours
+            int w = std::min(x1 - x0, (int)_cell - 2);
+            int h = std::min(y1 - y0, (int)_cell - 2);
+
+            std::fill(_scratch.begin(), _scratch.end(), (unsigned char)0);
+            if (w > 0 && h > 0) {
+                stbtt_MakeGlyphBitmap(fnt.info(), _scratch.data() + _cell + 1, w, h, _cell, scale, scale, glyph_index);
+            }
+
+            unsigned int cx = (index % _columns) * _cell;
+            unsigned int cy = (index / _columns) * _cell;
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTextureSubImage2D(_texture, 0, cx, cy, _cell, _cell, GL_RED, GL_UNSIGNED_BYTE, _scratch.data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+            float inv = 1.0f / (float)_size;
+            c.uv.uv0 = { (cx + 1) * inv, (cy + 1) * inv };
+            c.uv.uv1 = { (cx + 1 + std::max(w, 0)) * inv, (cy + 1 + std::max(h, 0)) * inv };
+            return &c.uv;
+        }
+
+        size_t text_renderer::run_hash::operator()(const run_view& k) const {
+            size_t h = std::hash<std::string_view>()(k.text);
+            h ^= std::hash<float>()(k.size) + k.font + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+
+        text_renderer::text_renderer(batch2d& batch, unsigned int atlas_size, size_t max_cached_runs)
+            : _batch(batch), _atlas(atlas_size), _max_cached_runs(max_cached_runs)
+        {}
+
+        static uint32_t decode_utf8(std::string_view text, size_t& i) {
+            unsigned char c = text[i++];
+            if (c < 0x80) return c;
+
+            int extra = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+            uint32_t cp = c & (0x3f >> extra);
+            for (int n = 0; n < extra && i < text.size(); n++) {
+                cp = (cp << 6) | (text[i++] & 0x3f);
+            }
+            return extra ? cp : 0xfffd;
+        }
+
+        const text_renderer::run& text_renderer::layout(const font& fnt, float pixel_height, std::string_view text) {
+            auto it = _runs.find(run_view{ fnt.id(), pixel_height, text });
+            if (it != _runs.end()) {
+                _run_lru.splice(_run_lru.begin(), _run_lru, it->second.lru);
+                _stats.layout_hits++;
+                return it->second;
+            }
+            _stats.layout_misses++;
+
+            if (_runs.size() >= _max_cached_runs) {
+                _runs.erase(*_run_lru.back());
+                _run_lru.pop_back();
+            }
+
+            auto inserted = _runs.emplace(run_key{ fnt.id(), pixel_height, std::string(text) }, run{}).first;
+            run& r = inserted->second;
+            _run_lru.push_front(&inserted->first);
+            r.lru = _run_lru.begin();
+
+            float scale = fnt.scale_for(pixel_height);
+            float pen_x = 0.0f, pen_y = 0.0f, width = 0.0f;
+            int previous = 0;
+
+            for (size_t i = 0; i < text.size(); ) {
+                uint32_t cp = decode_utf8(text, i);
+                if (cp == '\n') {
+                    width = std::max(width, pen_x);
+                    pen_x = 0.0f;
+                    pen_y -= fnt.line_height(pixel_height);
+                    previous = 0;
+                    continue;
+                }
+
+                int glyph = stbtt_FindGlyphIndex(fnt.info(), (int)cp);
+                if (previous) {
+                    pen_x += stbtt_GetGlyphKernAdvance(fnt.info(), previous, glyph) * scale;
+                }
+
+                int x0, y0, x1, y1;
+                stbtt_GetGlyphBitmapBox(fnt.info(), glyph, scale, scale, &x0, &y0, &x1, &y1);
+                if (x1 > x0 && y1 > y0) {
+                    // stb boxes are y-down relative to the baseline, the world is y-up
+                    r.glyphs.push_back({ glyph, { pen_x + x0, pen_y - y1 }, { pen_x + x1, pen_y - y0 } });
+                }
+
+                int advance, bearing;
+                stbtt_GetGlyphHMetrics(fnt.info(), glyph, &advance, &bearing);
+                pen_x += advance * scale;
+                previous = glyph;
+            }
+
+            r.extent = { std::max(width, pen_x), fnt.line_height(pixel_height) - pen_y };
+            return r;
+        }
+
+        void text_renderer::draw(const font& fnt, float pixel_height, std::string_view text,
+                                 const glm::vec3& position, const glm::vec4& color, float scale) {
+            if (!fnt.valid() || text.empty()) {
+                return;
+            }
+
+            unsigned int extent = fnt.max_glyph_extent(pixel_height);
+            if (extent + 2 > _atlas.cell_size()) {
+                // quads already queued sample the current layout, draw them before it goes away
+                _batch.end();
+                _atlas.fit(extent);
+            }
+
+            const run& r = layout(fnt, pixel_height, text);
+            for (const placed_glyph& g : r.glyphs) {
+                const glyph_atlas::glyph* uv = _atlas.acquire(fnt, pixel_height, g.glyph_index);
+                if (!uv) {
+                    _stats.dropped_glyphs++;
+                    continue;
+                }
+                glm::vec3 pos = position + glm::vec3(g.min * scale, 0.0f);
+                _batch.draw_quad(pos, (g.max - g.min) * scale, _atlas.texture(), { uv->uv0.x, uv->uv1.y }, { uv->uv1.x, uv->uv0.y }, color);
+            }
+        }
+
+        glm::vec2 text_renderer::measure(const font& fnt, float pixel_height, std::string_view text) {
+            if (!fnt.valid() || text.empty()) {
+                return { 0.0f, 0.0f };
+            }
+            return layout(fnt, pixel_height, text).extent;
+        }
+
+        void text_renderer::next_frame() {
+            _atlas.next_frame();
+            _stats = {};
+        }
+
+        // tilemap
+
+        tilemap::tilemap(unsigned int atlas_texture, const glm::ivec2& atlas_tiles, float tile_size, int stream_margin)
+            : _shader("res/shaders/tilemap_vert.glsl", "res/shaders/tilemap_frag.glsl"),
+              _texture(atlas_texture), _atlas_tiles(atlas_tiles), _tile_size(tile_size), _stream_margin(stream_margin)
+        {
+            // every chunk shares the same quad index pattern
+            std::vector<unsigned int> indices(chunk_size * chunk_size * 6);
+            for (unsigned int q = 0, v = 0; q < indices.size(); q += 6, v += 4) {
+                indices[q + 0] = v + 0; indices[q + 1] = v + 1; indices[q + 2] = v + 2;
+                indices[q + 3] = v + 2; indices[q + 4] = v + 3; indices[q + 5] = v + 0;
+            }
+            glGenBuffers(1, &_ibo);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+
+        tilemap::~tilemap() {
+            for (auto& [key, ch] : _chunks) {
+                glDeleteVertexArrays(1, &ch.vao);
+                glDeleteBuffers(1, &ch.vbo);
+            }
+            glDeleteBuffers(1, &_ibo);
+        }
+
+        static int floor_div(int a, int b) {
+            return a >= 0 ? a / b : -((-a + b - 1) / b);
+        }
+
+        void tilemap::set_tile(const glm::ivec2& t, uint16_t id) {
+            glm::ivec2 c = { floor_div(t.x, chunk_size), floor_div(t.y, chunk_size) };
+            chunk& ch = load_chunk(c);
+            uint16_t& slot = ch.tiles[(t.y - c.y * chunk_size) * chunk_size + (t.x - c.x * chunk_size)];
+            if (slot != id) {
+                slot = id;
+                ch.version++;
+            }
+        }
+
+        uint16_t tilemap::tile(const glm::ivec2& t) const {
+            glm::ivec2 c = { floor_div(t.x, chunk_size), floor_div(t.y, chunk_size) };
+            auto it = _chunks.find(chunk_key(c));
+            if (it == _chunks.end()) {
+                return 0;
+            }
+            return it->second.tiles[(t.y - c.y * chunk_size) * chunk_size + (t.x - c.x * chunk_size)];
+        }
+
+        glm::ivec4 tilemap::visible_range(const ortho_camera& camera) const {
+            // world-space bounds of the ndc square, rotation included
+            glm::mat4 inv = glm::inverse(camera.view_projection());
+            glm::vec2 lo(std::numeric_limits<float>::max()), hi(std::numeric_limits<float>::lowest());
+            for (glm::vec2 ndc : { glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(-1, 1), glm::vec2(1, 1) }) {
+                glm::vec4 w = inv * glm::vec4(ndc, 0.0f, 1.0f);
+                lo = glm::min(lo, glm::vec2(w) / w.w);
+                hi = glm::max(hi, glm::vec2(w) / w.w);
+            }
+
+            float extent = _tile_size * chunk_size;
+            return {
+                (int)std::floor(lo.x / extent), (int)std::floor(lo.y / extent),
+                (int)std::floor(hi.x / extent), (int)std::floor(hi.y / extent)
+            };
+        }
+
+        tilemap::chunk& tilemap::load_chunk(const glm::ivec2& c) {
+            auto [it, inserted] = _chunks.try_emplace(chunk_key(c));
+            chunk& ch = it->second;
+            if (inserted) {
+                ch.tiles.assign(chunk_size * chunk_size, 0);
+                if (_loader) {
+                    _loader(c, ch.tiles);
+                }
+                ch.version = 1;
+            }
+            return ch;
+        }
+
+        void tilemap::unload_chunk(uint64_t key, chunk& ch) {
+            if (_unloader) {
+                _unloader(chunk_coord(key), ch.tiles);
+            }
+            glDeleteVertexArrays(1, &ch.vao);
+            glDeleteBuffers(1, &ch.vbo);
+        }
+
+        void tilemap::schedule_build(const glm::ivec2& c, chunk& ch) {
+            ch.building = true;
+
+            // the worker only sees a snapshot, so edits and unloads never race with it
+            std::vector<uint16_t> tiles = ch.tiles;
+            uint64_t version = ch.version;
+            glm::vec2 origin = glm::vec2(c) * (_tile_size * chunk_size);
+            glm::ivec2 atlas = _atlas_tiles;
+            float size = _tile_size;
+
+            ch.pending = thread_pool::global().submit([tiles = std::move(tiles), version, origin, atlas, size]() {
+                chunk_mesh mesh{ version, {} };
+                mesh.vertices.reserve(tiles.size() * 16);
+
+                glm::vec2 cell = 1.0f / glm::vec2(atlas);
+                for (int y = 0; y < chunk_size; y++) {
+                    for (int x = 0; x < chunk_size; x++) {
+                        uint16_t id = tiles[y * chunk_size + x];
+                        if (!id) {
+                            continue;
+                        }
+                        int index = id - 1;
+                        glm::vec2 uv0 = glm::vec2(index % atlas.x, index / atlas.x) * cell;
+                        glm::vec2 uv1 = uv0 + cell;
+                        glm::vec2 p0 = origin + glm::vec2(x, y) * size;
+                        glm::vec2 p1 = p0 + size;
+
+                        float quad[] = {
+                            p0.x, p0.y, uv0.x, uv1.y,
+                            p0.x, p1.y, uv0.x, uv0.y,
+                            p1.x, p1.y, uv1.x, uv0.y,
+                            p1.x, p0.y, uv1.x, uv1.y
+                        };
+                        mesh.vertices.insert(mesh.vertices.end(), std::begin(quad), std::end(quad));
+                    }
+                }
+                return mesh;
+            });
+        }
+
+        void tilemap::upload(chunk& ch, const chunk_mesh& mesh) {
+            if (!ch.vao) {
+                glGenVertexArrays(1, &ch.vao);
+                glBindVertexArray(ch.vao);
+
+                glGenBuffers(1, &ch.vbo);
+                glBindBuffer(GL_ARRAY_BUFFER, ch.vbo);
+                glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+                glEnableVertexAttribArray(1);
+
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+                glBindVertexArray(0);
+            } else {
+                glBindBuffer(GL_ARRAY_BUFFER, ch.vbo);
+            }
+
+            glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            ch.index_count = (int)(mesh.vertices.size() / 16 * 6);
+            ch.built_version = mesh.version;
+        }
+
+        void tilemap::on_update(const ortho_camera& camera) {
+            glm::ivec4 range = visible_range(camera);
+            glm::ivec4 load = range + glm::ivec4(-_stream_margin, -_stream_margin, _stream_margin, _stream_margin);
+            // unload one chunk further out than we load so panning along a border doesn't thrash
+            glm::ivec4 keep = load + glm::ivec4(-1, -1, 1, 1);
+
+            for (int y = load.y; y <= load.w; y++) {
+                for (int x = load.x; x <= load.z; x++) {
+                    load_chunk({ x, y });
+                }
+            }
+
+            _stats.pending_builds = 0;
+            for (auto it = _chunks.begin(); it != _chunks.end(); ) {
+                glm::ivec2 c = chunk_coord(it->first);
+                chunk& ch = it->second;
+
+                if (c.x < keep.x || c.x > keep.z || c.y < keep.y || c.y > keep.w) {
+                    unload_chunk(it->first, ch);
+                    it = _chunks.erase(it);
+                    continue;
+                }
+
+                if (ch.building && ch.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    chunk_mesh mesh = ch.pending.get();
+                    ch.building = false;
+                    upload(ch, mesh);
+                }
+
+                if (!ch.building && ch.built_version != ch.version) {
+                    schedule_build(c, ch);
+                }
+                _stats.pending_builds += ch.building;
+                ++it;
+            }
+            _stats.loaded_chunks = (unsigned int)_chunks.size();
+        }
+
+        void tilemap::draw(const ortho_camera& camera) {
+            glm::ivec4 range = visible_range(camera);
+
+            _shader.bind();
+            _shader.set_uniform("u_view_projection", camera.view_projection());
+            glBindTextureUnit(0, _texture);
+
+            _stats.visible_chunks = 0;
+            _stats.draw_calls = 0;
+            for (int y = range.y; y <= range.w; y++) {
+                for (int x = range.x; x <= range.z; x++) {
+                    auto it = _chunks.find(chunk_key({ x, y }));
+                    if (it == _chunks.end()) {
+                        continue;
+                    }
+                    _stats.visible_chunks++;
+                    if (!it->second.index_count) {
+                        continue;
+                    }
+                    glBindVertexArray(it->second.vao);
+                    glDrawElements(GL_TRIANGLES, it->second.index_count, GL_UNSIGNED_INT, nullptr);
+                    _stats.draw_calls++;
+                }
+            }
+            glBindVertexArray(0);
+        }
+
+        // render queue
+
+        uint64_t render_queue::make_key(uint8_t layer, bool translucent, uint16_t shader, uint16_t texture, float depth) {
+            uint64_t d = (uint64_t)(std::clamp(depth, 0.0f, 1.0f) * 0xffffff);
+            uint64_t key = (uint64_t)layer << 56 | (uint64_t)translucent << 55;
+            if (translucent) {
+                key |= (0xffffff - d) << 31 | (uint64_t)(shader & 0xfff) << 19 | (uint64_t)texture << 3;
+            } else {
+                key |= (uint64_t)(shader & 0xfff) << 43 | (uint64_t)texture << 27 | d << 3;
+            }
+            return key;
+        }
+
+        void render_queue::submit(uint64_t key, const command& cmd) {
+            _items.push_back({ key, (uint32_t)_commands.size() });
+            _commands.push_back(cmd);
+        }
+
+        void render_queue::sort() {
+            // lsd radix sort, 8 bits per pass; each thread histograms and scatters its
+            // own contiguous slice so the result stays stable
+            size_t n = _items.size();
+            _scratch.resize(n);
+
+            thread_pool& pool = thread_pool::global();
+            size_t slices = n < 16384 ? 1 : pool.size() + 1;
+            size_t grain = (n + slices - 1) / slices;
+            std::vector<std::array<size_t, 256>> histograms(slices);
+
+            item* src = _items.data();
+            item* dst = _scratch.data();
+            for (int shift = 0; shift < 64; shift += 8) {
+                for (std::array<size_t, 256>& h : histograms) {
+                    h.fill(0);
+                }
+                pool.parallel_for(n, grain, [&](size_t begin, size_t end) {
+                    std::array<size_t, 256>& h = histograms[begin / grain];
+                    for (size_t i = begin; i < end; i++) {
+                        h[(src[i].key >> shift) & 0xff]++;
+                    }
+                });
+
+                // every key agrees on this byte, the pass would be a plain copy
+                size_t first = (src[0].key >> shift) & 0xff;
+                size_t total = 0;
+                for (size_t s = 0; s < slices; s++) {
+                    total += histograms[s][first];
+                }
+                if (total == n) {
+                    continue;
+                }
+
+                size_t offset = 0;
+                for (size_t b = 0; b < 256; b++) {
+                    for (size_t s = 0; s < slices; s++) {
+                        size_t c = histograms[s][b];
+                        histograms[s][b] = offset;
+                        offset += c;
+                    }
+                }
+
+                pool.parallel_for(n, grain, [&](size_t begin, size_t end) {
+                    std::array<size_t, 256>& h = histograms[begin / grain];
+                    for (size_t i = begin; i < end; i++) {
+                        dst[h[(src[i].key >> shift) & 0xff]++] = src[i];
+                    }
+                });
+                std::swap(src, dst);
+            }
+
+            if (src != _items.data()) {
+                std::copy(src, src + n, _items.data());
+            }
+        }
+
+        size_t render_queue::count_changes(const std::vector<command>& commands, const item* order, size_t count,
+                                           size_t& programs, size_t& textures, size_t& vaos) {
+            programs = textures = vaos = 0;
+            const command* last = nullptr;
+            for (size_t i = 0; i < count; i++) {
+                const command& c = commands[order ? order[i].index : i];
+                programs += !last || last->program != c.program;
+                textures += !last || last->texture != c.texture;
+                vaos += !last || last->vao != c.vao;
+                last = &c;
+            }
+            return programs + textures + vaos;
+        }
+
+        int render_queue::transform_location(unsigned int program) {
+            auto it = _transform_locations.find(program);
+            if (it != _transform_locations.end()) {
+                return it->second;
+            }
+            return _transform_locations[program] = glGetUniformLocation(program, "u_transform");
+        }
+
+        void render_queue::flush() {
+            _stats = {};
+            _stats.commands = _commands.size();
+            if (_commands.empty()) {
+                return;
+            }
+
+            size_t p, t, v;
+            size_t unsorted = count_changes(_commands, nullptr, _commands.size(), p, t, v);
+            sort();
+            size_t sorted = count_changes(_commands, _items.data(), _items.size(), _stats.program_changes, _stats.texture_changes, _stats.vao_changes);
+            _stats.state_changes_saved = unsorted > sorted ? unsorted - sorted : 0;
+
+            const command* last = nullptr;
+            for (const item& it : _items) {
+                const command& c = _commands[it.index];
+                if (!last || last->program != c.program) {
+                    glUseProgram(c.program);
+                }
+                if (!last || last->texture != c.texture) {
+                    glBindTextureUnit(0, c.texture);
+                }
+                if (!last || last->vao != c.vao) {
+                    glBindVertexArray(c.vao);
+                }
+                int location = transform_location(c.program);
+                if (location != -1) {
+                    glProgramUniformMatrix4fv(c.program, location, 1, GL_FALSE, glm::value_ptr(c.transform));
+                }
+                glDrawElementsInstanced(GL_TRIANGLES, c.index_count, GL_UNSIGNED_INT, nullptr, c.instance_count);
+                last = &c;
+            }
+            glBindVertexArray(0);
+
+            _items.clear();
+            _commands.clear();
+        }
+
+        // culling
+
+        frustum::frustum(const glm::mat4& m) {
+            // gribb/hartmann: combine the rows of the clip matrix (glm is column-major)
+            glm::vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+            glm::vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+            glm::vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+            glm::vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+            planes[0] = r3 + r0;
+            planes[1] = r3 - r0;
+            planes[2] = r3 + r1;
+            planes[3] = r3 - r1;
+            planes[4] = r3 + r2;
+            planes[5] = r3 - r2;
+
+            for (glm::vec4& p : planes) {
+                p /= glm::length(glm::vec3(p));
+            }
+        }
+
+        bool frustum::contains(const glm::vec3& min, const glm::vec3& max) const {
+            glm::vec3 c = (min + max) * 0.5f, e = (max - min) * 0.5f;
+            for (const glm::vec4& p : planes) {
+                if (glm::dot(glm::vec3(p), c) + p.w + glm::dot(glm::abs(glm::vec3(p)), e) < 0.0f) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool frustum::contains(const glm::vec3& center, float radius) const {
+            for (const glm::vec4& p : planes) {
+                if (glm::dot(glm::vec3(p), center) + p.w + radius < 0.0f) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void aabb_soa::push_back(const glm::vec3& min, const glm::vec3& max) {
+            min_x.push_back(min.x); min_y.push_back(min.y); min_z.push_back(min.z);
+            max_x.push_back(max.x); max_y.push_back(max.y); max_z.push_back(max.z);
+        }
+
+        void aabb_soa::clear() {
+            min_x.clear(); min_y.clear(); min_z.clear();
+            max_x.clear(); max_y.clear(); max_z.clear();
+        }
+
+        void sphere_soa::push_back(const glm::vec3& center, float r) {
+            x.push_back(center.x); y.push_back(center.y); z.push_back(center.z);
+            radius.push_back(r);
+        }
+
+        void sphere_soa::clear() {
+            x.clear(); y.clear(); z.clear(); radius.clear();
+        }
+
+        static inline uint32_t emit_mask(uint32_t mask, uint32_t base, uint32_t* out) {
+            uint32_t n = 0;
+            while (mask) {
+                out[n++] = base + std::countr_zero(mask);
+                mask &= mask - 1;
+            }
+            return n;
+        }
+
+        // each slice writes its survivors at its own start in `visible`, then the
+        // slices are packed down in order so the output stays deterministic
+        template<typename K>
+        static size_t cull_slices(size_t count, std::vector<uint32_t>& visible, const K& kernel) {
+            constexpr size_t grain = 16384;
+            visible.resize(count);
+            frame_vector<size_t> found((count + grain - 1) / grain, frame_arena::resource());
+
+            thread_pool::global().parallel_for(count, grain, [&](size_t begin, size_t end) {
+                found[begin / grain] = kernel(begin, end, visible.data() + begin);
+            });
+
+            size_t total = 0;
+            for (size_t s = 0; s < found.size(); s++) {
+                std::copy_n(visible.begin() + s * grain, found[s], visible.begin() + total);
+                total += found[s];
+            }
+            visible.resize(total);
+            return total;
+        }
+
+        size_t cull(const frustum& f, const aabb_soa& b, std::vector<uint32_t>& visible) {
+            return cull_slices(b.size(), visible, [&](size_t begin, size_t end, uint32_t* out) -> size_t {
+                size_t n = 0, i = begin;
+        #if defined(__AVX2__)
+                __m256 half = _mm256_set1_ps(0.5f);
+                __m256 sign = _mm256_set1_ps(-0.0f);
+                for (; i + 8 <= end; i += 8) {
+                    __m256 minx = _mm256_loadu_ps(&b.min_x[i]), maxx = _mm256_loadu_ps(&b.max_x[i]);
+                    __m256 miny = _mm256_loadu_ps(&b.min_y[i]), maxy = _mm256_loadu_ps(&b.max_y[i]);
+                    __m256 minz = _mm256_loadu_ps(&b.min_z[i]), maxz = _mm256_loadu_ps(&b.max_z[i]);
+                    __m256 cx = _mm256_mul_ps(_mm256_add_ps(minx, maxx), half), ex = _mm256_mul_ps(_mm256_sub_ps(maxx, minx), half);
+                    __m256 cy = _mm256_mul_ps(_mm256_add_ps(miny, maxy), half), ey = _mm256_mul_ps(_mm256_sub_ps(maxy, miny), half);
+                    __m256 cz = _mm256_mul_ps(_mm256_add_ps(minz, maxz), half), ez = _mm256_mul_ps(_mm256_sub_ps(maxz, minz), half);
+
+                    __m256 outside = _mm256_setzero_ps();
+                    for (const glm::vec4& p : f.planes) {
+                        __m256 px = _mm256_set1_ps(p.x), py = _mm256_set1_ps(p.y), pz = _mm256_set1_ps(p.z);
+                        __m256 d = OGE_FMADD256(px, cx, OGE_FMADD256(py, cy, OGE_FMADD256(pz, cz, _mm256_set1_ps(p.w))));
+                        __m256 r = OGE_FMADD256(_mm256_andnot_ps(sign, px), ex,
+                                   OGE_FMADD256(_mm256_andnot_ps(sign, py), ey, _mm256_mul_ps(_mm256_andnot_ps(sign, pz), ez)));
+                        outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+                    }
+                    n += emit_mask(~_mm256_movemask_ps(outside) & 0xff, (uint32_t)i, out + n);
+                }
+        #elif defined(__SSE2__) || defined(_M_X64)
+                __m128 half = _mm_set1_ps(0.5f);
+                __m128 sign = _mm_set1_ps(-0.0f);
+                for (; i + 4 <= end; i += 4) {
+                    __m128 minx = _mm_loadu_ps(&b.min_x[i]), maxx = _mm_loadu_ps(&b.max_x[i]);
+                    __m128 miny = _mm_loadu_ps(&b.min_y[i]), maxy = _mm_loadu_ps(&b.max_y[i]);
+                    __m128 minz = _mm_loadu_ps(&b.min_z[i]), maxz = _mm_loadu_ps(&b.max_z[i]);
+                    __m128 cx = _mm_mul_ps(_mm_add_ps(minx, maxx), half), ex = _mm_mul_ps(_mm_sub_ps(maxx, minx), half);
+                    __m128 cy = _mm_mul_ps(_mm_add_ps(miny, maxy), half), ey = _mm_mul_ps(_mm_sub_ps(maxy, miny), half);
+                    __m128 cz = _mm_mul_ps(_mm_add_ps(minz, maxz), half), ez = _mm_mul_ps(_mm_sub_ps(maxz, minz), half);
+
+                    __m128 outside = _mm_setzero_ps();
+                    for (const glm::vec4& p : f.planes) {
+                        __m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y), pz = _mm_set1_ps(p.z);
+                        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)), _mm_add_ps(_mm_mul_ps(pz, cz), _mm_set1_ps(p.w)));
+                        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, px), ex), _mm_mul_ps(_mm_andnot_ps(sign, py), ey)),
+                                              _mm_mul_ps(_mm_andnot_ps(sign, pz), ez));
+                        outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+                    }
+                    n += emit_mask(~_mm_movemask_ps(outside) & 0xf, (uint32_t)i, out + n);
+                }
+        #endif
+                for (; i < end; i++) {
+                    if (f.contains({ b.min_x[i], b.min_y[i], b.min_z[i] }, { b.max_x[i], b.max_y[i], b.max_z[i] })) {
+                        out[n++] = (uint32_t)i;
+                    }
+                }
+                return n;
+            });
+        }
+
+        size_t cull(const frustum& f, const sphere_soa& s, std::vector<uint32_t>& visible) {
+            return cull_slices(s.size(), visible, [&](size_t begin, size_t end, uint32_t* out) -> size_t {
+                size_t n = 0, i = begin;
+        #if defined(__AVX2__)
+                for (; i + 8 <= end; i += 8) {
+                    __m256 x = _mm256_loadu_ps(&s.x[i]), y = _mm256_loadu_ps(&s.y[i]), z = _mm256_loadu_ps(&s.z[i]);
+                    __m256 nr = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&s.radius[i]));
+
+                    __m256 outside = _mm256_setzero_ps();
+                    for (const glm::vec4& p : f.planes) {
+                        __m256 d = OGE_FMADD256(_mm256_set1_ps(p.x), x, OGE_FMADD256(_mm256_set1_ps(p.y), y,
+                                   OGE_FMADD256(_mm256_set1_ps(p.z), z, _mm256_set1_ps(p.w))));
+                        outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, nr, _CMP_LT_OQ));
+                    }
+                    n += emit_mask(~_mm256_movemask_ps(outside) & 0xff, (uint32_t)i, out + n);
+                }
+        #elif defined(__SSE2__) || defined(_M_X64)
+                for (; i + 4 <= end; i += 4) {
+                    __m128 x = _mm_loadu_ps(&s.x[i]), y = _mm_loadu_ps(&s.y[i]), z = _mm_loadu_ps(&s.z[i]);
+                    __m128 nr = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&s.radius[i]));
+
+                    __m128 outside = _mm_setzero_ps();
+                    for (const glm::vec4& p : f.planes) {
+                        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x), x), _mm_mul_ps(_mm_set1_ps(p.y), y)),
+                                              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.z), z), _mm_set1_ps(p.w)));
+                        outside = _mm_or_ps(outside, _mm_cmplt_ps(d, nr));
+                    }
+                    n += emit_mask(~_mm_movemask_ps(outside) & 0xf, (uint32_t)i, out + n);
+                }
+        #endif
+                for (; i < end; i++) {
+                    if (f.contains({ s.x[i], s.y[i], s.z[i] }, s.radius[i])) {
+                        out[n++] = (uint32_t)i;
+                    }
+                }
+                return n;
+            });
+        }
+
+        // particles
+
+        particle_emitter::particle_emitter(size_t capacity, const settings& s)
+            : _settings(s), _capacity(capacity),
+              _x(capacity), _y(capacity), _z(capacity), _vx(capacity), _vy(capacity), _vz(capacity),
+              _life(capacity), _inv_lifetime(capacity), _color(capacity),
+              _dead(capacity), _instances(capacity),
+              _shader("res/shaders/particle_vert.glsl", "res/shaders/particle_frag.glsl"),
+              _instance_buffer({ { 1, 4 }, { 2, 4, GL_UNSIGNED_BYTE, true } })
+        {
+            float corners[] = { -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f };
+
+            glGenVertexArrays(1, &_vao);
+            glBindVertexArray(_vao);
+            glGenBuffers(1, &_vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            _instance_buffer.attach(_vao);
+        }
+
+        particle_emitter::~particle_emitter() {
+            glDeleteVertexArrays(1, &_vao);
+            glDeleteBuffers(1, &_vbo);
+        }
+
+        float particle_emitter::random(float lo, float hi) {
+            // xorshift32, plenty for spawn jitter
+            _seed ^= _seed << 13;
+            _seed ^= _seed >> 17;
+            _seed ^= _seed << 5;
+            return lo + (hi - lo) * (float)(_seed >> 8) * (1.0f / 16777216.0f);
+        }
+
+        void particle_emitter::emit(size_t count) {
+            const settings& s = _settings;
+            uint32_t color = glm::packUnorm4x8(s.color);
+
+            count = std::min(count, _capacity - _count);
+            for (size_t i = _count; i < _count + count; i++) {
+                _x[i] = s.position.x; _y[i] = s.position.y; _z[i] = s.position.z;
+                _vx[i] = random(s.velocity_min.x, s.velocity_max.x);
+                _vy[i] = random(s.velocity_min.y, s.velocity_max.y);
+                _vz[i] = random(s.velocity_min.z, s.velocity_max.z);
+                _life[i] = random(s.lifetime_min, s.lifetime_max);
+                _inv_lifetime[i] = 1.0f / _life[i];
+                _color[i] = color;
+            }
+            _count += count;
+        }
+
+        size_t particle_emitter::integrate(size_t begin, size_t end, float dt, uint32_t* dead) {
+            const glm::vec3 g = _settings.gravity * dt;
+            size_t n = 0, i = begin;
+        #if defined(__AVX2__)
+            __m256 vdt = _mm256_set1_ps(dt), zero = _mm256_setzero_ps();
+            __m256 gx = _mm256_set1_ps(g.x), gy = _mm256_set1_ps(g.y), gz = _mm256_set1_ps(g.z);
+            for (; i + 8 <= end; i += 8) {
+                __m256 vx = _mm256_add_ps(_mm256_loadu_ps(&_vx[i]), gx);
+                __m256 vy = _mm256_add_ps(_mm256_loadu_ps(&_vy[i]), gy);
+                __m256 vz = _mm256_add_ps(_mm256_loadu_ps(&_vz[i]), gz);
+                _mm256_storeu_ps(&_vx[i], vx);
+                _mm256_storeu_ps(&_vy[i], vy);
+                _mm256_storeu_ps(&_vz[i], vz);
+                _mm256_storeu_ps(&_x[i], OGE_FMADD256(vx, vdt, _mm256_loadu_ps(&_x[i])));
+                _mm256_storeu_ps(&_y[i], OGE_FMADD256(vy, vdt, _mm256_loadu_ps(&_y[i])));
+                _mm256_storeu_ps(&_z[i], OGE_FMADD256(vz, vdt, _mm256_loadu_ps(&_z[i])));
+
+                __m256 life = _mm256_sub_ps(_mm256_loadu_ps(&_life[i]), vdt);
+                _mm256_storeu_ps(&_life[i], life);
+                n += emit_mask(_mm256_movemask_ps(_mm256_cmp_ps(life, zero, _CMP_LE_OQ)), (uint32_t)i, dead + n);
+            }
+        #endif
+            for (; i < end; i++) {
+                _vx[i] += g.x; _vy[i] += g.y; _vz[i] += g.z;
+                _x[i] += _vx[i] * dt; _y[i] += _vy[i] * dt; _z[i] += _vz[i] * dt;
+                _life[i] -= dt;
+                if (_life[i] <= 0.0f) {
+                    dead[n++] = (uint32_t)i;
+                }
+            }
+            return n;
+        }
+
+        void particle_emitter::move(size_t from, size_t to) {
+            _x[to] = _x[from]; _y[to] = _y[from]; _z[to] = _z[from];
+            _vx[to] = _vx[from]; _vy[to] = _vy[from]; _vz[to] = _vz[from];
+            _life[to] = _life[from]; _inv_lifetime[to] = _inv_lifetime[from];
+            _color[to] = _color[from];
+        }
+
+        void particle_emitter::compact(const uint32_t* dead, size_t count) {
+            // `dead` is ascending: fill the lowest holes with the highest survivors
+            size_t lo = 0, hi = count;
+            while (lo < hi) {
+                if (dead[hi - 1] == _count - 1) {
+                    hi--;
+                    _count--;
+                    continue;
+                }
+                move(_count - 1, dead[lo++]);
+                _count--;
+            }
+        }
+
+        void particle_emitter::on_update(const float& dt) {
+            _spawn_accumulator += _settings.rate * dt;
+            size_t spawn = (size_t)_spawn_accumulator;
+            _spawn_accumulator -= (float)spawn;
+
+            constexpr size_t grain = 65536;
+            std::vector<size_t> found((_count + grain - 1) / grain);
+            thread_pool::global().parallel_for(_count, grain, [&](size_t begin, size_t end) {
+                found[begin / grain] = integrate(begin, end, dt, _dead.data() + begin);
+            });
+
+            // pack the per-slice dead lists, they stay ascending
+            size_t total = 0;
+            for (size_t s = 0; s < found.size(); s++) {
+                std::copy_n(_dead.begin() + s * grain, found[s], _dead.begin() + total);
+                total += found[s];
+            }
+            compact(_dead.data(), total);
+
+            emit(spawn);
+        }
+
+        void particle_emitter::draw(const ortho_camera& camera) {
+            draw(camera.view(), camera.view_projection());
+        }
+
+        void particle_emitter::draw(const presepctive_camera& camera) {
+            draw(camera.view(), camera.view_projection());
+        }
+
+        void particle_emitter::draw(const glm::mat4& view, const glm::mat4& view_projection) {
+            if (!_count) {
+                return;
+            }
+
+            thread_pool::global().parallel_for(_count, 65536, [&](size_t begin, size_t end) {
+                float size = _settings.size;
+                for (size_t i = begin; i < end; i++) {
+                    // fade alpha out over the particle's life
+                    uint32_t a = (uint32_t)((_color[i] >> 24) * std::clamp(_life[i] * _inv_lifetime[i], 0.0f, 1.0f));
+                    _instances[i] = { { _x[i], _y[i], _z[i], size }, (_color[i] & 0x00ffffff) | a << 24 };
+                }
+            });
+            _instance_buffer.upload(_instances.data(), _count);
+
+            _shader.bind();
+            _shader.set_uniform("u_view_projection", view_projection);
+            // camera basis for billboarding, the rows of the view rotation
+            _shader.set_uniform("u_camera_right", glm::vec3(view[0][0], view[1][0], view[2][0]));
+            _shader.set_uniform("u_camera_up", glm::vec3(view[0][1], view[1][1], view[2][1]));
+            _shader.set_uniform("u_textured", _settings.texture ? 1 : 0);
+            if (_settings.texture) {
+                glBindTextureUnit(0, _settings.texture);
+            }
+
+            gl_detail::blend_state blend;
+            GLboolean depth_write;
+            glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_write);
+
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, _settings.additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+            glDepthMask(GL_FALSE);
+
+            glBindVertexArray(_vao);
+            glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, (GLsizei)_count);
+            glBindVertexArray(0);
+
+            glDepthMask(depth_write);
+            blend.restore();
+        }
+
+        // debug draw
+
+        #if OGE_DEBUG_DRAW
+
+        namespace debug_detail {
+
+            struct vertex {
+                glm::vec3 position;
+                uint32_t color;
+            };
+
+            struct label {
+                glm::vec3 position;
+                uint32_t color;
+                std::string text;
+            };
+
+            struct buffer {
+                std::mutex mutex;
+                std::vector<vertex> lines[2];
+                std::vector<label> labels;
+            };
+
+            struct renderer {
+                std::unique_ptr<shader> program;
+                unsigned int vao = 0, vbo = 0;
+                size_t capacity = 0;
+
+                std::vector<vertex> merged;
+                std::vector<label> labels;
+
+                batch2d* batch = nullptr;
+                text_renderer* text = nullptr;
+                const font* fnt = nullptr;
+                float pixel_height = 16.0f;
+            };
+
+            static std::mutex registry_mutex;
+            static std::vector<std::shared_ptr<buffer>> registry;
+            static renderer state;
+
+            static buffer& local() {
+                thread_local std::shared_ptr<buffer> buf;
+                if (!buf) {
+                    buf = std::make_shared<buffer>();
+                    std::lock_guard<std::mutex> lock(registry_mutex);
+                    registry.push_back(buf);
+                }
+                return *buf;
+            }
+        }
+
+        void debug_draw::line(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color, bool depth_test) {
+            debug_detail::buffer& buf = debug_detail::local();
+            uint32_t c = glm::packUnorm4x8(color);
+            std::lock_guard<std::mutex> lock(buf.mutex);
+            buf.lines[depth_test].push_back({ a, c });
+            buf.lines[depth_test].push_back({ b, c });
+        }
+
+        void debug_draw::aabb(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color, bool depth_test) {
+            glm::vec3 c[8];
+            for (int i = 0; i < 8; i++) {
+                c[i] = { i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z };
+            }
+            // the 12 edges join corners that differ in exactly one axis bit
+            for (int i = 0; i < 8; i++) {
+                for (int bit = 1; bit < 8; bit <<= 1) {
+                    if (!(i & bit)) {
+                        line(c[i], c[i | bit], color, depth_test);
+                    }
+                }
+            }
+        }
+
+        void debug_draw::circle(const glm::vec3& center, const glm::vec3& normal, float radius, const glm::vec4& color, bool depth_test) {
+            constexpr int segments = 32;
+            glm::vec3 n = glm::normalize(normal);
+            glm::vec3 u = glm::normalize(glm::cross(n, std::abs(n.y) < 0.99f ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0)));
+            glm::vec3 v = glm::cross(n, u);
+
+            glm::vec3 previous = center + u * radius;
+            for (int i = 1; i <= segments; i++) {
+                float a = glm::two_pi<float>() * i / segments;
+                glm::vec3 p = center + (u * std::cos(a) + v * std::sin(a)) * radius;
+                line(previous, p, color, depth_test);
+                previous = p;
+            }
+        }
+
+        void debug_draw::frustum(const glm::mat4& view_projection, const glm::vec4& color, bool depth_test) {
+            glm::mat4 inv = glm::inverse(view_projection);
+            glm::vec3 c[8];
+            for (int i = 0; i < 8; i++) {
+                glm::vec4 p = inv * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+                c[i] = glm::vec3(p) / p.w;
+            }
+            for (int i = 0; i < 8; i++) {
+                for (int bit = 1; bit < 8; bit <<= 1) {
+                    if (!(i & bit)) {
+                        line(c[i], c[i | bit], color, depth_test);
+                    }
+                }
+            }
+        }
+
+        void debug_draw::text3d(const glm::vec3& position, std::string_view text, const glm::vec4& color) {
+            debug_detail::buffer& buf = debug_detail::local();
+            std::lock_guard<std::mutex> lock(buf.mutex);
+            buf.labels.push_back({ position, glm::packUnorm4x8(color), std::string(text) });
+        }
+
+        void debug_draw::set_text(batch2d* batch, text_renderer* text, const font* fnt, float pixel_height) {
+            debug_detail::state.batch = batch;
+            debug_detail::state.text = text;
+            debug_detail::state.fnt = fnt;
+            debug_detail::state.pixel_height = pixel_height;
+        }
+
+        void debug_draw::flush(const glm::mat4& view_projection) {
+            using namespace debug_detail;
+
+            // depth tested lines first, overlay_start lines after them in the same buffer
+            state.merged.clear();
+            state.labels.clear();
+            size_t overlay_start = 0;
+            {
+                std::lock_guard<std::mutex> registry_lock(registry_mutex);
+                for (int pass = 1; pass >= 0; pass--) {
+                    if (pass == 0) {
+                        overlay_start = state.merged.size();
+                    }
+                    for (auto& buf : registry) {
+                        std::lock_guard<std::mutex> lock(buf->mutex);
+                        state.merged.insert(state.merged.end(), buf->lines[pass].begin(), buf->lines[pass].end());
+                        buf->lines[pass].clear();
+                    }
+                }
+                for (auto& buf : registry) {
+                    std::lock_guard<std::mutex> lock(buf->mutex);
+                    std::move(buf->labels.begin(), buf->labels.end(), std::back_inserter(state.labels));
+                    buf->labels.clear();
+                }
+            }
+
+            if (!state.merged.empty()) {
+                if (!state.program) {
+                    state.program = std::make_unique<shader>("res/shaders/debug_vert.glsl", "res/shaders/debug_frag.glsl");
+
+                    glGenVertexArrays(1, &state.vao);
+                    glBindVertexArray(state.vao);
+                    glGenBuffers(1, &state.vbo);
+                    glBindBuffer(GL_ARRAY_BUFFER, state.vbo);
+                    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, position));
+                    glEnableVertexAttribArray(0);
+                    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex), (void*)offsetof(vertex, color));
+                    glEnableVertexAttribArray(1);
+                    glBindVertexArray(0);
+                }
+
+                glBindBuffer(GL_ARRAY_BUFFER, state.vbo);
+                state.capacity = std::max(state.capacity, state.merged.size());
+                glBufferData(GL_ARRAY_BUFFER, state.capacity * sizeof(vertex), nullptr, GL_STREAM_DRAW);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, state.merged.size() * sizeof(vertex), state.merged.data());
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+                state.program->bind();
+                state.program->set_uniform("u_view_projection", view_projection);
+                glBindVertexArray(state.vao);
+
+                GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+                if (overlay_start) {
+                    glEnable(GL_DEPTH_TEST);
+                    glDrawArrays(GL_LINES, 0, (GLsizei)overlay_start);
+                }
+                if (state.merged.size() > overlay_start) {
+                    glDisable(GL_DEPTH_TEST);
+                    glDrawArrays(GL_LINES, (GLint)overlay_start, (GLsizei)(state.merged.size() - overlay_start));
+                }
+                if (depth) {
+                    glEnable(GL_DEPTH_TEST);
+                } else {
+                    glDisable(GL_DEPTH_TEST);
+                }
+                glBindVertexArray(0);
+            }
+
+            if (!state.labels.empty() && state.batch && state.text && state.fnt) {
+                // labels are laid out in window pixels, origin bottom left
+                const utils::vec2u& size = core::application::get().get_window().size();
+                state.batch->begin(glm::ortho(0.0f, (float)size.x, 0.0f, (float)size.y));
+                for (const label& l : state.labels) {
+                    glm::vec4 clip = view_projection * glm::vec4(l.position, 1.0f);
+                    if (clip.w <= 0.0f) {
+                        continue;
+                    }
+                    glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                    glm::vec3 screen = { (ndc.x * 0.5f + 0.5f) * size.x, (ndc.y * 0.5f + 0.5f) * size.y, 0.0f };
+                    state.text->draw(*state.fnt, state.pixel_height, l.text, screen, glm::unpackUnorm4x8(l.color));
+                }
+                state.batch->end();
+            }
+        }
+
+        void debug_draw::shutdown() {
+            using namespace debug_detail;
+            if (state.program) {
+                glDeleteVertexArrays(1, &state.vao);
+                glDeleteBuffers(1, &state.vbo);
+                state.program.reset();
+            }
+        }
+
+        #endif
+
+        // render targets
+
+        bool is_depth_format(GLenum format) {
+            switch (format) {
+                case GL_DEPTH_COMPONENT16: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32: case GL_DEPTH_COMPONENT32F:
+                case GL_DEPTH24_STENCIL8: case GL_DEPTH32F_STENCIL8:
+                    return true;
+            }
+            return false;
+        }
+
+        framebuffer::framebuffer(const std::vector<unsigned int>& colors, unsigned int depth, GLenum depth_format) {
+            glCreateFramebuffers(1, &_id);
+
+            std::vector<GLenum> buffers;
+            for (size_t i = 0; i < colors.size(); i++) {
+                glNamedFramebufferTexture(_id, GL_COLOR_ATTACHMENT0 + (GLenum)i, colors[i], 0);
+                buffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)i);
+            }
+            if (buffers.empty()) {
+                glNamedFramebufferDrawBuffer(_id, GL_NONE);
+            } else {
+                glNamedFramebufferDrawBuffers(_id, (GLsizei)buffers.size(), buffers.data());
+            }
+
+            if (depth) {
+                bool stencil = depth_format == GL_DEPTH24_STENCIL8 || depth_format == GL_DEPTH32F_STENCIL8;
+                glNamedFramebufferTexture(_id, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, depth, 0);
+            }
+
+            if (glCheckNamedFramebufferStatus(_id, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                LOG_ERROR("Framebuffer {} is incomplete", _id);
+            }
+        }
+
+        framebuffer::~framebuffer() {
+            glDeleteFramebuffers(1, &_id);
+        }
+
+        void framebuffer::bind() const { glBindFramebuffer(GL_FRAMEBUFFER, _id); }
+        void framebuffer::unbind() const { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+        render_target_pool::render_target_pool(unsigned int granularity, unsigned int max_idle_frames)
+            : _granularity(granularity), _max_idle_frames(max_idle_frames)
+        {}
+
+        render_target_pool::~render_target_pool() {
+            for (const entry& e : _free) {
+                glDeleteTextures(1, &e.t.texture);
+            }
+        }
+
+        render_target_pool::target render_target_pool::acquire(const texture_desc& desc) {
+            texture_desc physical = desc;
+            physical.width = (desc.width + _granularity - 1) / _granularity * _granularity;
+            physical.height = (desc.height + _granularity - 1) / _granularity * _granularity;
+
+            for (size_t i = 0; i < _free.size(); i++) {
+                if (_free[i].t.physical == physical) {
+                    target t = _free[i].t;
+                    _free[i] = _free.back();
+                    _free.pop_back();
+                    return t;
+                }
+            }
+
+            target t = { 0, physical };
+            glCreateTextures(GL_TEXTURE_2D, 1, &t.texture);
+            glTextureStorage2D(t.texture, 1, physical.format, physical.width, physical.height);
+            glTextureParameteri(t.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(t.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(t.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(t.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            _allocated++;
+            return t;
+        }
+
+        void render_target_pool::release(const target& t) {
+            _free.push_back({ t, _frame });
+        }
+
+        std::vector<unsigned int> render_target_pool::next_frame() {
+            std::vector<unsigned int> deleted;
+            for (size_t i = 0; i < _free.size(); ) {
+                if (_frame - _free[i].last_used > _max_idle_frames) {
+                    deleted.push_back(_free[i].t.texture);
+                    glDeleteTextures(1, &_free[i].t.texture);
+                    _free[i] = _free.back();
+                    _free.pop_back();
+                    _allocated--;
+                } else {
+                    i++;
+                }
+            }
+            _frame++;
+            return deleted;
+        }
+
+        render_graph::resource render_graph::builder::create(const char* name, const texture_desc& desc) {
+            resource r = (resource)_graph._resources.size();
+            _graph._resources.push_back({ name, desc });
+            return write(r);
+        }
+
+        render_graph::resource render_graph::builder::read(resource r) {
+            _graph._passes[_pass].reads.push_back(r);
+            return r;
+        }
+
+        render_graph::resource render_graph::builder::write(resource r) {
+            _graph._passes[_pass].writes.push_back(r);
+            _graph._resources[r].writers.push_back(_pass);
+            return r;
+        }
+
+        void render_graph::builder::side_effect() {
+            _graph._passes[_pass].side_effect = true;
+        }
+
+        unsigned int render_graph::context::texture(resource r) const {
+            return _graph._resources[r].physical.texture;
+        }
+
+        const texture_desc& render_graph::context::desc(resource r) const {
+            return _graph._resources[r].desc;
+        }
+
+        glm::vec2 render_graph::context::uv_scale(resource r) const {
+            const resource_node& n = _graph._resources[r];
+            if (n.imported) {
+                return { 1.0f, 1.0f };
+            }
+            return { (float)n.desc.width / n.physical.physical.width, (float)n.desc.height / n.physical.physical.height };
+        }
+
+        render_graph::~render_graph() {
+            _framebuffers.clear();
+        }
+
+        render_graph::resource render_graph::import(const char* name, unsigned int texture, const texture_desc& desc) {
+            resource r = (resource)_resources.size();
+            resource_node node = { name, desc };
+            node.imported = true;
+            node.physical = { texture, desc };
+            _resources.push_back(node);
+            return r;
+        }
+
+        render_graph::resource render_graph::import_backbuffer(unsigned int width, unsigned int height) {
+            resource r = import("backbuffer", 0, { width, height, GL_RGBA8 });
+            _resources[r].backbuffer = true;
+            return r;
+        }
+
+        void render_graph::add_pass(const char* name, const setup_fn& setup, const execute_fn& execute) {
+            _passes.push_back({ name, execute });
+            builder b(*this, (uint32_t)_passes.size() - 1);
+            setup(b);
+        }
+
+        void render_graph::compile() {
+            for (pass_node& p : _passes) {
+                p.ref_count = (uint32_t)p.writes.size();
+                for (resource w : p.writes) {
+                    // anything leaving the graph must be produced
+                    if (_resources[w].imported) {
+                        p.side_effect = true;
+                    }
+                }
+                for (resource r : p.reads) {
+                    _resources[r].ref_count++;
+                }
+            }
+
+            // peel off passes whose outputs nobody reads, walking back through their inputs
+            std::vector<resource> unreferenced;
+            for (resource r = 0; r < _resources.size(); r++) {
+                if (!_resources[r].ref_count) {
+                    unreferenced.push_back(r);
+                }
+            }
+            while (!unreferenced.empty()) {
+                resource r = unreferenced.back();
+                unreferenced.pop_back();
+                for (uint32_t w : _resources[r].writers) {
+                    pass_node& p = _passes[w];
+                    if (p.ref_count && --p.ref_count == 0 && !p.side_effect) {
+                        p.culled = true;
+                        for (resource in : p.reads) {
+                            if (--_resources[in].ref_count == 0) {
+                                unreferenced.push_back(in);
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (uint32_t i = 0; i < _passes.size(); i++) {
+                if (_passes[i].culled) {
+                    continue;
+                }
+                for (const auto* list : { &_passes[i].reads, &_passes[i].writes }) {
+                    for (resource r : *list) {
+                        _resources[r].first_pass = std::min(_resources[r].first_pass, i);
+                        _resources[r].last_pass = std::max(_resources[r].last_pass, i);
+                    }
+                }
+            }
+        }
+
+        unsigned int render_graph::framebuffer_for(const pass_node& pass) {
+            std::vector<unsigned int> colors;
+            unsigned int depth = 0;
+            GLenum depth_format = GL_DEPTH_COMPONENT24;
+            std::vector<unsigned int> key;
+
+            for (resource w : pass.writes) {
+                const resource_node& n = _resources[w];
+                if (n.backbuffer) {
+                    return 0;
+                }
+                if (is_depth_format(n.desc.format)) {
+                    depth = n.physical.texture;
+                    depth_format = n.desc.format;
+                } else {
+                    colors.push_back(n.physical.texture);
+                }
+                key.push_back(n.physical.texture | (is_depth_format(n.desc.format) ? 0x80000000u : 0u));
+            }
+            if (key.empty()) {
+                return 0;
+            }
+
+            auto it = _framebuffers.find(key);
+            if (it == _framebuffers.end()) {
+                it = _framebuffers.emplace(key, std::make_unique<framebuffer>(colors, depth, depth_format)).first;
+            }
+            return it->second->id();
+        }
+
+        void render_graph::execute() {
+            compile();
+
+            _stats = {};
+            _stats.passes = (unsigned int)_passes.size();
+
+            for (uint32_t i = 0; i < _passes.size(); i++) {
+                pass_node& p = _passes[i];
+                if (p.culled) {
+                    _stats.culled_passes++;
+                    continue;
+                }
+
+                for (resource w : p.writes) {
+                    resource_node& n = _resources[w];
+                    if (!n.imported && n.first_pass == i) {
+                        n.physical = _pool.acquire(n.desc);
+                        _stats.transient_targets++;
+                    }
+                }
+
+                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_for(p));
+                if (!p.writes.empty()) {
+                    const texture_desc& d = _resources[p.writes.front()].desc;
+                    glViewport(0, 0, d.width, d.height);
+                }
+
+                p.execute(context(*this));
+
+                // whatever this pass was the last user of goes back to the pool for later passes
+                for (const auto* list : { &p.reads, &p.writes }) {
+                    for (resource r : *list) {
+                        resource_node& n = _resources[r];
+                        if (!n.imported && n.last_pass == i && n.physical.texture) {
+                            _pool.release(n.physical);
+                            n.physical.texture = 0;
+                        }
+                    }
+                }
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // framebuffers that point at deleted textures are useless now
+            for (unsigned int deleted : _pool.next_frame()) {
+                for (auto it = _framebuffers.begin(); it != _framebuffers.end(); ) {
+                    bool stale = std::any_of(it->first.begin(), it->first.end(), [deleted](unsigned int a) {
+                        return (a & 0x7fffffffu) == deleted;
+                    });
+                    it = stale ? _framebuffers.erase(it) : std::next(it);
+                }
+            }
+            _stats.pooled_targets = (unsigned int)_pool.allocated();
+
+            _resources.clear();
+            _passes.clear();
+        }
+
+        // meshes
+
+        namespace simplify_detail {
+
+            struct quadric {
+                // symmetric 4x4: a2 ab ac ad b2 bc bd c2 cd d2
+                double q[10] = {};
+
+                static quadric plane(const glm::dvec3& n, double d, double w) {
+                    quadric r;
+                    r.q[0] = w * n.x * n.x; r.q[1] = w * n.x * n.y; r.q[2] = w * n.x * n.z; r.q[3] = w * n.x * d;
+                    r.q[4] = w * n.y * n.y; r.q[5] = w * n.y * n.z; r.q[6] = w * n.y * d;
+                    r.q[7] = w * n.z * n.z; r.q[8] = w * n.z * d;
+                    r.q[9] = w * d * d;
+                    return r;
+                }
+
+                quadric& operator+=(const quadric& o) {
+                    for (int i = 0; i < 10; i++) q[i] += o.q[i];
+                    return *this;
+                }
+
+                double error(const glm::dvec3& p) const {
+                    return q[0] * p.x * p.x + 2 * q[1] * p.x * p.y + 2 * q[2] * p.x * p.z + 2 * q[3] * p.x
+                         + q[4] * p.y * p.y + 2 * q[5] * p.y * p.z + 2 * q[6] * p.y
+                         + q[7] * p.z * p.z + 2 * q[8] * p.z
+                         + q[9];
+                }
+            };
+
+            struct collapse {
+                double cost;
+                uint32_t from, to;
+                uint32_t from_version, to_version;
+
+                bool operator>(const collapse& o) const { return cost > o.cost; }
+            };
+        }
+
+        std::vector<uint32_t> simplify(const mesh_data& mesh, const std::vector<uint32_t>& source,
+                                       size_t target_triangles, float max_error, float* result_error) {
+            using namespace simplify_detail;
+
+            const std::vector<glm::vec3>& pos = mesh.positions;
+            size_t vcount = pos.size();
+            std::vector<uint32_t> indices = source;
+            size_t live = indices.size() / 3;
+
+            std::vector<quadric> quadrics(vcount);
+            std::vector<std::vector<uint32_t>> vertex_triangles(vcount);
+            std::vector<bool> removed(live, false);
+
+            // edge use counts find the open boundary, which gets a perpendicular plane
+            // so the silhouette of open meshes doesn't collapse inwards
+            std::unordered_map<uint64_t, int> edge_uses;
+            auto edge_key = [](uint32_t a, uint32_t b) { return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a; };
+
+            for (size_t t = 0; t < live; t++) {
+                uint32_t a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+                glm::dvec3 pa = pos[a], pb = pos[b], pc = pos[c];
+                glm::dvec3 n = glm::cross(pb - pa, pc - pa);
+                double area = glm::length(n);
+                if (area > 0.0) {
+                    n /= area;
+                    quadric q = quadric::plane(n, -glm::dot(n, pa), area * 0.5);
+                    quadrics[a] += q; quadrics[b] += q; quadrics[c] += q;
+                }
+                for (uint32_t v : { a, b, c }) {
+                    vertex_triangles[v].push_back((uint32_t)t);
+                }
+                edge_uses[edge_key(a, b)]++; edge_uses[edge_key(b, c)]++; edge_uses[edge_key(c, a)]++;
+            }
+
+            for (size_t t = 0; t < live; t++) {
+                for (int e = 0; e < 3; e++) {
+                    uint32_t a = indices[t * 3 + e], b = indices[t * 3 + (e + 1) % 3], c = indices[t * 3 + (e + 2) % 3];
+                    if (edge_uses[edge_key(a, b)] != 1) {
+                        continue;
+                    }
+                    glm::dvec3 pa = pos[a], pb = pos[b], pc = pos[c];
+                    glm::dvec3 edge = pb - pa;
+                    glm::dvec3 face = glm::cross(edge, pc - pa);
+                    glm::dvec3 n = glm::cross(edge, face);
+                    double len = glm::length(n);
+                    if (len > 0.0) {
+                        n /= len;
+                        quadric q = quadric::plane(n, -glm::dot(n, pa), glm::dot(edge, edge) * 10.0);
+                        quadrics[a] += q; quadrics[b] += q;
+                    }
+                }
+            }
+
+            std::vector<uint32_t> remap(vcount), version(vcount, 0);
+            for (uint32_t v = 0; v < vcount; v++) {
+                remap[v] = v;
+            }
+
+            std::priority_queue<collapse, std::vector<collapse>, std::greater<collapse>> heap;
+            auto push_edge = [&](uint32_t a, uint32_t b) {
+                quadric q = quadrics[a];
+                q += quadrics[b];
+                double ab = q.error(pos[b]), ba = q.error(pos[a]);
+                if (ab <= ba) {
+                    heap.push({ ab, a, b, version[a], version[b] });
+                } else {
+                    heap.push({ ba, b, a, version[b], version[a] });
+                }
+            };
+            for (auto& [key, uses] : edge_uses) {
+                push_edge((uint32_t)(key >> 32), (uint32_t)key);
+            }
+
+            // moving `from` onto `to` must not flip any surviving triangle around `from`
+            auto flips = [&](uint32_t from, uint32_t to) {
+                for (uint32_t t : vertex_triangles[from]) {
+                    if (removed[t]) continue;
+                    uint32_t* tri = &indices[t * 3];
+                    if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+                    glm::vec3 p[3], q[3];
+                    for (int k = 0; k < 3; k++) {
+                        p[k] = pos[tri[k]];
+                        q[k] = tri[k] == from ? pos[to] : p[k];
+                    }
+                    glm::vec3 n0 = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 n1 = glm::cross(q[1] - q[0], q[2] - q[0]);
+                    if (glm::dot(n0, n1) <= 0.0f) return true;
+                }
+                return false;
+            };
+
+            double worst = 0.0;
+            while (live > target_triangles && !heap.empty()) {
+                collapse c = heap.top();
+                heap.pop();
+
+                if (c.from_version != version[c.from] || c.to_version != version[c.to]) continue;
+                if (remap[c.from] != c.from || remap[c.to] != c.to) continue;
+                if (c.cost > max_error) break;
+                if (flips(c.from, c.to)) continue;
+
+                worst = std::max(worst, c.cost);
+                remap[c.from] = c.to;
+                quadrics[c.to] += quadrics[c.from];
+                version[c.to]++;
+
+                std::vector<uint32_t> neighbours;
+                for (uint32_t t : vertex_triangles[c.from]) {
+                    if (removed[t]) continue;
+                    uint32_t* tri = &indices[t * 3];
+                    for (int k = 0; k < 3; k++) {
+                        if (tri[k] == c.from) tri[k] = c.to;
+                    }
+                    if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0]) {
+                        removed[t] = true;
+                        live--;
+                    } else {
+                        vertex_triangles[c.to].push_back(t);
+                    }
+                }
+                vertex_triangles[c.from].clear();
+
+                for (uint32_t t : vertex_triangles[c.to]) {
+                    if (removed[t]) continue;
+                    for (int k = 0; k < 3; k++) {
+                        uint32_t v = indices[t * 3 + k];
+                        if (v != c.to) neighbours.push_back(v);
+                    }
+                }
+                std::sort(neighbours.begin(), neighbours.end());
+                neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+                for (uint32_t n : neighbours) {
+                    push_edge(c.to, n);
+                }
+            }
+
+            std::vector<uint32_t> result;
+            result.reserve(live * 3);
+            for (size_t t = 0; t < removed.size(); t++) {
+                if (!removed[t]) {
+                    result.insert(result.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+                }
+            }
+            if (result_error) {
+                *result_error = (float)worst;
+            }
+            return result;
+        }
+
+        mesh_lods generate_lods(const mesh_data& mesh, unsigned int count, float ratio) {
+            mesh_lods lods;
+            lods.indices = mesh.indices;
+            lods.levels.push_back({ 0, (uint32_t)mesh.indices.size(), 0.0f });
+
+            std::vector<uint32_t> current = mesh.indices;
+            for (unsigned int i = 1; i < count; i++) {
+                size_t target = (size_t)(current.size() / 3 * ratio);
+                float error = 0.0f;
+                std::vector<uint32_t> next = simplify(mesh, current, target, std::numeric_limits<float>::max(), &error);
+                // stop once the simplifier can't make meaningful progress
+                if (next.size() >= current.size() * 0.95f || next.empty()) {
+                    break;
+                }
+                lods.levels.push_back({ (uint32_t)lods.indices.size(), (uint32_t)next.size(), std::max(error, lods.levels.back().error) });
+                lods.indices.insert(lods.indices.end(), next.begin(), next.end());
+                current = std::move(next);
+            }
+            return lods;
+        }
+
+        lod_selector::lod_selector(std::vector<float> thresholds, float hysteresis)
+            : _thresholds(std::move(thresholds)), _hysteresis(hysteresis)
+        {}
+
+        unsigned int lod_selector::select(float projected, unsigned int current) const {
+            // only switch once we're clearly past a boundary, so objects sitting right
+            // on a threshold don't pop back and forth every frame
+            unsigned int level = std::min<unsigned int>(current, (unsigned int)_thresholds.size());
+            while (level < _thresholds.size() && projected < _thresholds[level] * (1.0f - _hysteresis)) {
+                level++;
+            }
+            while (level > 0 && projected > _thresholds[level - 1] * (1.0f + _hysteresis)) {
+                level--;
+            }
+            return level;
+        }
+
+        unsigned int lod_selector::select(const presepctive_camera& camera, const glm::vec3& center, float radius, unsigned int current) const {
+            // projected diameter over viewport height; projection[1][1] is cot(fov / 2)
+            float distance = std::max(glm::length(center - camera.position()), 1e-4f);
+            float projected = radius * camera.projection()[1][1] / distance;
+            return select(projected, current);
+        }
+
+        void lod_selector::select(const presepctive_camera& camera, const sphere_soa& bounds, std::vector<uint8_t>& levels) const {
+            levels.resize(bounds.size(), 0);
+            glm::vec3 eye = camera.position();
+            float scale = camera.projection()[1][1];
+
+            thread_pool::global().parallel_for(bounds.size(), 16384, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    glm::vec3 d = glm::vec3(bounds.x[i], bounds.y[i], bounds.z[i]) - eye;
+                    float projected = bounds.radius[i] * scale / std::max(glm::length(d), 1e-4f);
+                    levels[i] = (uint8_t)select(projected, levels[i]);
+                }
+            });
+        }
+
+        // occlusion
+
+        occlusion_culler::occlusion_culler(unsigned int width, unsigned int height)
+            : _width(width), _height(height), _stride((width + 7) & ~7u)
+        {
+            unsigned int w = width, h = height;
+            _levels.emplace_back((size_t)_stride * height, 1.0f);
+            _level_sizes.push_back({ w, h });
+            while (w > 1 || h > 1) {
+                w = std::max(1u, (w + 1) / 2);
+                h = std::max(1u, (h + 1) / 2);
+                _levels.emplace_back((size_t)w * h, 1.0f);
+                _level_sizes.push_back({ w, h });
+            }
+        }
+
+        void occlusion_culler::begin(const glm::mat4& view_projection) {
+            _view_projection = view_projection;
+            _vertices.clear();
+            _indices.clear();
+            _stats = {};
+        }
+
+        void occlusion_culler::add_occluder(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const glm::mat4& model) {
+            uint32_t base = (uint32_t)_vertices.size();
+            glm::mat4 mvp = _view_projection * model;
+            for (const glm::vec3& p : positions) {
+                glm::vec4 clip = mvp * glm::vec4(p, 1.0f);
+                if (clip.w <= 1e-5f || clip.z < -clip.w) {
+                    // behind the eye or in front of the near plane, flag it so triangles using
+                    // it are skipped rather than rasterized with depths nearer than anything real
+                    _vertices.push_back({ 0.0f, 0.0f, 0.0f, -1.0f });
+                    continue;
+                }
+                glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                _vertices.push_back({ (ndc.x * 0.5f + 0.5f) * _width, (ndc.y * 0.5f + 0.5f) * _height, ndc.z * 0.5f + 0.5f, clip.w });
+            }
+            for (uint32_t i : indices) {
+                _indices.push_back(base + i);
+            }
+            _stats.occluder_triangles += indices.size() / 3;
+        }
+
+        void occlusion_culler::rasterize(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, int y_begin, int y_end) {
+            // winding doesn't matter for occluders, orient every triangle the same way
+            glm::vec4 a = v0, b = v1, c = v2;
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area < 0.0f) {
+                std::swap(b, c);
+                area = -area;
+            }
+            if (area < 1e-8f) {
+                return;
+            }
+
+            int x0 = std::max(0, (int)std::floor(std::min({ a.x, b.x, c.x })));
+            int x1 = std::min((int)_width - 1, (int)std::ceil(std::max({ a.x, b.x, c.x })));
+            int y0 = std::max(y_begin, (int)std::floor(std::min({ a.y, b.y, c.y })));
+            int y1 = std::min(y_end - 1, (int)std::ceil(std::max({ a.y, b.y, c.y })));
+            if (x0 > x1 || y0 > y1) {
+                return;
+            }
+
+            // edge functions e(x, y) = A x + B y + C, positive inside
+            float inv = 1.0f / area;
+            float a0 = b.y - c.y, b0 = c.x - b.x, c0 = b.x * c.y - b.y * c.x;
+            float a1 = c.y - a.y, b1 = a.x - c.x, c1 = c.x * a.y - c.y * a.x;
+            float a2 = a.y - b.y, b2 = b.x - a.x, c2 = a.x * b.y - a.y * b.x;
+            // depth is affine in screen space after the divide
+            float dz_a = (a.z * a0 + b.z * a1 + c.z * a2) * inv;
+            float dz_b = (a.z * b0 + b.z * b1 + c.z * b2) * inv;
+            float dz_c = (a.z * c0 + b.z * c1 + c.z * c2) * inv;
+
+            std::vector<float>& depth = _levels[0];
+            for (int y = y0; y <= y1; y++) {
+                float py = y + 0.5f;
+                float* row = depth.data() + (size_t)y * _stride;
+                int x = x0;
+        #if defined(__AVX2__)
+                x &= ~7;
+                __m256 step = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+                __m256 va0 = _mm256_set1_ps(a0), va1 = _mm256_set1_ps(a1), va2 = _mm256_set1_ps(a2), vdz = _mm256_set1_ps(dz_a);
+                __m256 r0 = _mm256_set1_ps(b0 * py + c0), r1 = _mm256_set1_ps(b1 * py + c1), r2 = _mm256_set1_ps(b2 * py + c2);
+                __m256 rz = _mm256_set1_ps(dz_b * py + dz_c);
+                for (; x <= x1; x += 8) {
+                    __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), step);
+                    __m256 e0 = OGE_FMADD256(va0, px, r0);
+                    __m256 e1 = OGE_FMADD256(va1, px, r1);
+                    __m256 e2 = OGE_FMADD256(va2, px, r2);
+                    __m256 inside = _mm256_cmp_ps(_mm256_min_ps(e0, _mm256_min_ps(e1, e2)), _mm256_setzero_ps(), _CMP_GE_OQ);
+                    if (_mm256_movemask_ps(inside)) {
+                        __m256 z = OGE_FMADD256(vdz, px, rz);
+                        __m256 old = _mm256_loadu_ps(row + x);
+                        _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+                    }
+                }
+        #endif
+                for (; x <= x1; x++) {
+                    float px = x + 0.5f;
+                    if (a0 * px + b0 * py + c0 >= 0.0f && a1 * px + b1 * py + c1 >= 0.0f && a2 * px + b2 * py + c2 >= 0.0f) {
+                        row[x] = std::min(row[x], dz_a * px + dz_b * py + dz_c);
+                    }
+                }
+            }
+        }
+
+        void occlusion_culler::finish() {
+            std::vector<float>& depth = _levels[0];
+            std::fill(depth.begin(), depth.end(), 1.0f);
+
+            // horizontal bands, every worker walks all triangles but only writes its rows
+            constexpr int band = 16;
+            thread_pool::global().parallel_for((_height + band - 1) / band, 1, [&](size_t begin, size_t end) {
+                for (size_t b = begin; b < end; b++) {
+                    int y_begin = (int)b * band, y_end = std::min((int)_height, y_begin + band);
+                    for (size_t t = 0; t + 2 < _indices.size(); t += 3) {
+                        const glm::vec4& v0 = _vertices[_indices[t]];
+                        const glm::vec4& v1 = _vertices[_indices[t + 1]];
+                        const glm::vec4& v2 = _vertices[_indices[t + 2]];
+                        // near-clipped triangles are dropped, losing an occluder is always safe
+                        if (v0.w < 0.0f || v1.w < 0.0f || v2.w < 0.0f) {
+                            continue;
+                        }
+                        rasterize(v0, v1, v2, y_begin, y_end);
+                    }
+                }
+            });
+
+            // each texel of level n + 1 keeps the farthest depth of its 2x2 footprint
+            for (size_t l = 1; l < _levels.size(); l++) {
+                glm::uvec2 src = _level_sizes[l - 1], dst = _level_sizes[l];
+                size_t src_stride = l == 1 ? _stride : src.x;
+                const std::vector<float>& s = _levels[l - 1];
+                std::vector<float>& d = _levels[l];
+                for (unsigned int y = 0; y < dst.y; y++) {
+                    unsigned int sy0 = std::min(y * 2, src.y - 1), sy1 = std::min(y * 2 + 1, src.y - 1);
+                    for (unsigned int x = 0; x < dst.x; x++) {
+                        unsigned int sx0 = std::min(x * 2, src.x - 1), sx1 = std::min(x * 2 + 1, src.x - 1);
+                        d[y * dst.x + x] = std::max(std::max(s[sy0 * src_stride + sx0], s[sy0 * src_stride + sx1]),
+                                                    std::max(s[sy1 * src_stride + sx0], s[sy1 * src_stride + sx1]));
+                    }
+                }
+            }
+        }
+
+        bool occlusion_culler::occluded(const glm::vec3& min, const glm::vec3& max) const {
+            glm::vec2 lo(std::numeric_limits<float>::max()), hi(std::numeric_limits<float>::lowest());
+            float nearest = 1.0f;
+            for (int i = 0; i < 8; i++) {
+                glm::vec4 clip = _view_projection * glm::vec4(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f);
+                if (clip.w <= 1e-5f) {
+                    // straddles the eye plane, can't be judged from the depth buffer
+                    return false;
+                }
+                glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                glm::vec2 screen = { (ndc.x * 0.5f + 0.5f) * _width, (ndc.y * 0.5f + 0.5f) * _height };
+                lo = glm::min(lo, screen);
+                hi = glm::max(hi, screen);
+                nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+            }
+
+            lo = glm::max(lo, glm::vec2(0.0f));
+            hi = glm::min(hi, glm::vec2((float)_width - 1.0f, (float)_height - 1.0f));
+            if (lo.x > hi.x || lo.y > hi.y) {
+                // off screen; the frustum test owns that decision
+                return false;
+            }
+
+            // pick the level where the rect spans at most 2x2 texels
+            float extent = std::max(hi.x - lo.x, hi.y - lo.y);
+            unsigned int l = std::min((unsigned int)_levels.size() - 1, (unsigned int)std::max(0.0f, std::ceil(std::log2(std::max(extent, 1.0f)))));
+            glm::uvec2 size = _level_sizes[l];
+            size_t stride = l == 0 ? _stride : size.x;
+            unsigned int x0 = std::min(size.x - 1, (unsigned int)lo.x >> l), x1 = std::min(size.x - 1, (unsigned int)hi.x >> l);
+            unsigned int y0 = std::min(size.y - 1, (unsigned int)lo.y >> l), y1 = std::min(size.y - 1, (unsigned int)hi.y >> l);
+
+            float farthest = 0.0f;
+            for (unsigned int y = y0; y <= y1; y++) {
+                for (unsigned int x = x0; x <= x1; x++) {
+                    farthest = std::max(farthest, _levels[l][y * stride + x]);
+                }
+            }
+            return nearest > farthest;
+        }
+
+        size_t occlusion_culler::test(const aabb_soa& b, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& visible) {
+            size_t count = candidates.size();
+            size_t total = cull_slices(count, visible, [&](size_t begin, size_t end, uint32_t* out) -> size_t {
+                size_t n = 0;
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t c = candidates[i];
+                    if (!occluded({ b.min_x[c], b.min_y[c], b.min_z[c] }, { b.max_x[c], b.max_y[c], b.max_z[c] })) {
+                        out[n++] = c;
+                    }
+                }
+                return n;
+            });
+            _stats.tested += count;
+            _stats.culled += count - total;
+            return total;
+        }
+
+        // clustered lighting
+
+        light_clusters::light_clusters(const glm::uvec3& grid, unsigned int max_per_cluster)
+            : _grid(grid), _max_per_cluster(max_per_cluster),
+              _light_buffer(sizeof(light)), _cluster_buffer(sizeof(glm::uvec2)), _index_buffer(sizeof(uint32_t))
+        {
+            _clusters.resize((size_t)grid.x * grid.y * grid.z);
+            _slices.resize(grid.z);
+        }
+
+        void light_clusters::build_bounds(const glm::mat4& projection) {
+            _projection = projection;
+            // glm::perspective, so near/far and the half-extents come straight out of the matrix
+            _near = projection[3][2] / (projection[2][2] - 1.0f);
+            _far = projection[3][2] / (projection[2][2] + 1.0f);
+            float tan_x = 1.0f / projection[0][0], tan_y = 1.0f / projection[1][1];
+
+            _bounds_min.resize(_clusters.size());
+            _bounds_max.resize(_clusters.size());
+            for (unsigned int z = 0; z < _grid.z; z++) {
+                float d0 = _near * std::pow(_far / _near, (float)z / _grid.z);
+                float d1 = _near * std::pow(_far / _near, (float)(z + 1) / _grid.z);
+                for (unsigned int y = 0; y < _grid.y; y++) {
+                    for (unsigned int x = 0; x < _grid.x; x++) {
+                        glm::vec2 lo = { (2.0f * x / _grid.x - 1.0f) * tan_x, (2.0f * y / _grid.y - 1.0f) * tan_y };
+                        glm::vec2 hi = { (2.0f * (x + 1) / _grid.x - 1.0f) * tan_x, (2.0f * (y + 1) / _grid.y - 1.0f) * tan_y };
+                        // the tile widens with depth, so take the extremes of both slice planes
+                        glm::vec2 mn = glm::min(lo * d0, lo * d1), mx = glm::max(hi * d0, hi * d1);
+                        size_t i = ((size_t)z * _grid.y + y) * _grid.x + x;
+                        _bounds_min[i] = { mn, -d1 };
+                        _bounds_max[i] = { mx, -d0 };
+                    }
+                }
+            }
+        }
+
+        void light_clusters::assign_slice(unsigned int z, std::vector<uint32_t>& out, size_t& dropped) {
+            out.clear();
+            size_t first = (size_t)z * _grid.x * _grid.y;
+            float z_lo = _bounds_min[first].z, z_hi = _bounds_max[first].z;
+
+            // lights overlapping the slice depth range, padded to the simd width with empty spheres
+            std::pmr::memory_resource* frame = frame_arena::resource();
+            frame_vector<uint32_t> candidates(frame);
+            for (uint32_t i = 0; i < _r.size(); i++) {
+                if (_z[i] + _r[i] >= z_lo && _z[i] - _r[i] <= z_hi) {
+                    candidates.push_back(i);
+                }
+            }
+            size_t padded = (candidates.size() + 7) & ~size_t(7);
+            frame_vector<float> cx(padded, 0.0f, frame), cy(padded, 0.0f, frame), cz(padded, 0.0f, frame), cr(padded, -1.0f, frame);
+            for (size_t i = 0; i < candidates.size(); i++) {
+                uint32_t l = candidates[i];
+                cx[i] = _x[l]; cy[i] = _y[l]; cz[i] = _z[l]; cr[i] = _r[l];
+            }
+
+            frame_vector<uint32_t> hits(padded, frame);
+            for (size_t c = first; c < first + (size_t)_grid.x * _grid.y; c++) {
+                const glm::vec3& mn = _bounds_min[c];
+                const glm::vec3& mx = _bounds_max[c];
+                uint32_t n = 0;
+                size_t i = 0;
+
+                // squared distance from the sphere center to the box against radius^2
+        #if defined(__AVX2__)
+                __m256 min_x = _mm256_set1_ps(mn.x), min_y = _mm256_set1_ps(mn.y), min_z = _mm256_set1_ps(mn.z);
+                __m256 max_x = _mm256_set1_ps(mx.x), max_y = _mm256_set1_ps(mx.y), max_z = _mm256_set1_ps(mx.z);
+                __m256 zero = _mm256_setzero_ps();
+                for (; i < padded; i += 8) {
+                    __m256 x = _mm256_loadu_ps(&cx[i]), y = _mm256_loadu_ps(&cy[i]), z = _mm256_loadu_ps(&cz[i]), r = _mm256_loadu_ps(&cr[i]);
+                    __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(min_x, x), _mm256_sub_ps(x, max_x)), zero);
+                    __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(min_y, y), _mm256_sub_ps(y, max_y)), zero);
+                    __m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(min_z, z), _mm256_sub_ps(z, max_z)), zero);
+                    __m256 d = OGE_FMADD256(dx, dx, OGE_FMADD256(dy, dy, _mm256_mul_ps(dz, dz)));
+                    __m256 inside = _mm256_and_ps(_mm256_cmp_ps(d, _mm256_mul_ps(r, r), _CMP_LE_OQ), _mm256_cmp_ps(r, zero, _CMP_GE_OQ));
+                    n += emit_mask(_mm256_movemask_ps(inside), (uint32_t)i, hits.data() + n);
+                }
+        #elif defined(__SSE2__) || defined(_M_X64)
+                __m128 min_x = _mm_set1_ps(mn.x), min_y = _mm_set1_ps(mn.y), min_z = _mm_set1_ps(mn.z);
+                __m128 max_x = _mm_set1_ps(mx.x), max_y = _mm_set1_ps(mx.y), max_z = _mm_set1_ps(mx.z);
+                __m128 zero = _mm_setzero_ps();
+                for (; i < padded; i += 4) {
+                    __m128 x = _mm_loadu_ps(&cx[i]), y = _mm_loadu_ps(&cy[i]), z = _mm_loadu_ps(&cz[i]), r = _mm_loadu_ps(&cr[i]);
+                    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_x, x), _mm_sub_ps(x, max_x)), zero);
+                    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_y, y), _mm_sub_ps(y, max_y)), zero);
+                    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_z, z), _mm_sub_ps(z, max_z)), zero);
+                    __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    __m128 inside = _mm_and_ps(_mm_cmple_ps(d, _mm_mul_ps(r, r)), _mm_cmpge_ps(r, zero));
+                    n += emit_mask(_mm_movemask_ps(inside), (uint32_t)i, hits.data() + n);
+                }
+        #endif
+                for (; i < padded; i++) {
+                    glm::vec3 p = { cx[i], cy[i], cz[i] };
+                    glm::vec3 d = glm::max(glm::max(mn - p, p - mx), glm::vec3(0.0f));
+                    if (cr[i] >= 0.0f && glm::dot(d, d) <= cr[i] * cr[i]) {
+                        hits[n++] = (uint32_t)i;
+                    }
+                }
+
+                // spot lights also have to reach the cluster's bounding sphere with their cone
+                glm::vec3 center = (mn + mx) * 0.5f;
+                float extent = glm::length(mx - center);
+                uint32_t offset = (uint32_t)out.size(), count = 0;
+                for (uint32_t h = 0; h < n; h++) {
+                    uint32_t l = candidates[hits[h]];
+                    const glm::vec4& spot = _spot[l];
+                    if (spot.w > -1.0f) {
+                        glm::vec3 v = center - glm::vec3(_x[l], _y[l], _z[l]);
+                        float along = glm::dot(v, glm::vec3(spot));
+                        float across = std::sqrt(std::max(0.0f, glm::dot(v, v) - along * along));
+                        float sin_cone = std::sqrt(std::max(0.0f, 1.0f - spot.w * spot.w));
+                        if (spot.w * across - along * sin_cone > extent || along < -extent) {
+                            continue;
+                        }
+                    }
+                    if (count == _max_per_cluster) {
+                        dropped++;
+                        continue;
+                    }
+                    out.push_back(l);
+                    count++;
+                }
+                _clusters[c] = { offset, count };
+            }
+        }
+
+        void light_clusters::update(const presepctive_camera& camera, const std::vector<light>& lights) {
+            if (camera.projection() != _projection) {
+                build_bounds(camera.projection());
+            }
+
+            size_t count = lights.size();
+            _x.resize(count); _y.resize(count); _z.resize(count); _r.resize(count);
+            _spot.resize(count);
+
+            const glm::mat4& view = camera.view();
+            thread_pool& pool = thread_pool::global();
+            pool.parallel_for(count, 1024, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    const light& l = lights[i];
+                    glm::vec3 p = view * glm::vec4(l.position, 1.0f);
+                    _x[i] = p.x; _y[i] = p.y; _z[i] = p.z; _r[i] = l.radius;
+                    _spot[i] = l.spot_cos > -1.0f
+                        ? glm::vec4(glm::normalize(glm::vec3(view * glm::vec4(l.direction, 0.0f))), l.spot_cos)
+                        : glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+                }
+            });
+
+            frame_vector<size_t> dropped(_grid.z, 0, frame_arena::resource());
+            pool.parallel_for(_grid.z, 1, [&](size_t begin, size_t end) {
+                for (size_t z = begin; z < end; z++) {
+                    assign_slice((unsigned int)z, _slices[z], dropped[z]);
+                }
+            });
+
+            // slices filled their own lists, rebase the offsets onto one index buffer
+            _indices.clear();
+            size_t per_slice = (size_t)_grid.x * _grid.y;
+            for (unsigned int z = 0; z < _grid.z; z++) {
+                uint32_t base = (uint32_t)_indices.size();
+                for (size_t c = z * per_slice; c < (z + 1) * per_slice; c++) {
+                    _clusters[c].x += base;
+                }
+                _indices.insert(_indices.end(), _slices[z].begin(), _slices[z].end());
+            }
+
+            _stats.lights = count;
+            _stats.assignments = _indices.size();
+            _stats.dropped = 0;
+            for (size_t d : dropped) {
+                _stats.dropped += d;
+            }
+
+            // empty buffers still get one element so the bindings stay valid
+            static const light none = { {}, -1.0f };
+            if (count) {
+                _light_buffer.upload(lights);
+            } else {
+                _light_buffer.upload(&none, 1);
+            }
+            _cluster_buffer.upload(_clusters);
+            if (_indices.empty()) {
+                _indices.push_back(0);
+            }
+            _index_buffer.upload(_indices);
+        }
+
+        void light_clusters::bind(shader& s, const glm::vec2& viewport) const {
+            _light_buffer.bind_base(0);
+            _cluster_buffer.bind_base(1);
+            _index_buffer.bind_base(2);
+
+            // slice = log(depth) * scale - bias, inverse of the exponential split in build_bounds
+            float scale = _grid.z / std::log(_far / _near);
+            s.bind();
+            s.set_uniform("u_cluster_grid", vec3u{ _grid.x, _grid.y, _grid.z });
+            s.set_uniform("u_cluster_size", glm::vec2(viewport.x / _grid.x, viewport.y / _grid.y));
+            s.set_uniform("u_cluster_scale", scale);
+            s.set_uniform("u_cluster_bias", std::log(_near) * scale);
+        }
+
+        // vertex layouts
+
+        uint32_t pack_octahedral(const glm::vec3& n) {
+            glm::vec2 p = glm::vec2(n) / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+            if (n.z < 0.0f) {
+                // fold the lower hemisphere over the diagonals
+                glm::vec2 s = { p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f };
+                p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * s;
+            }
+            return glm::packSnorm2x16(p);
+        }
+
+        glm::vec3 unpack_octahedral(uint32_t packed) {
+            glm::vec2 p = glm::unpackSnorm2x16(packed);
+            glm::vec3 n = { p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y) };
+            float t = std::max(-n.z, 0.0f);
+            n.x += n.x >= 0.0f ? -t : t;
+            n.y += n.y >= 0.0f ? -t : t;
+            return glm::normalize(n);
+        }
+
+        uint32_t pack_tangent(const glm::vec4& t) {
+            // y loses its lowest bit to the handedness
+            uint32_t packed = pack_octahedral(glm::vec3(t)) & ~0x10000u;
+            if ((packed >> 16) == 0x8000u) {
+                // -32767 rounded down to -32768, which a normalized fetch clamps to -1.0 along
+                // with -32767 and the shader would read the other handedness, step inwards
+                packed += 0x20000u;
+            }
+            return t.w < 0.0f ? packed | 0x10000u : packed;
+        }
+
+        glm::vec4 unpack_tangent(uint32_t packed) {
+            return glm::vec4(unpack_octahedral(packed & ~0x10000u), packed & 0x10000u ? -1.0f : 1.0f);
+        }
+
+        vertex_layout::vertex_layout(std::initializer_list<vertex_attribute> attributes) : _attributes(attributes) {
+            for (const vertex_attribute& attr : _attributes) {
+                _offsets.push_back(_stride);
+                _stride += format_size(attr.format);
+            }
+        }
+
+        size_t vertex_layout::format_size(vertex_format format) {
+            switch (format) {
+                case vertex_format::float2: return 8;
+                case vertex_format::float3: return 12;
+                case vertex_format::float4: return 16;
+                case vertex_format::half2: return 4;
+                case vertex_format::half4: return 8;
+                case vertex_format::octahedral: return 4;
+                case vertex_format::octahedral_tangent: return 4;
+                case vertex_format::unorm8x4: return 4;
+            }
+            return 0;
+        }
+
+        void vertex_layout::attach(unsigned int vao, unsigned int vbo) const {
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+            for (size_t i = 0; i < _attributes.size(); i++) {
+                int components = 0;
+                GLenum type = GL_FLOAT;
+                bool normalized = false;
+                switch (_attributes[i].format) {
+                    case vertex_format::float2: components = 2; break;
+                    case vertex_format::float3: components = 3; break;
+                    case vertex_format::float4: components = 4; break;
+                    case vertex_format::half2: components = 2; type = GL_HALF_FLOAT; break;
+                    case vertex_format::half4: components = 4; type = GL_HALF_FLOAT; break;
+                    case vertex_format::octahedral:
+                    case vertex_format::octahedral_tangent: components = 2; type = GL_SHORT; normalized = true; break;
+                    case vertex_format::unorm8x4: components = 4; type = GL_UNSIGNED_BYTE; normalized = true; break;
+                }
+
+                unsigned int location = _attributes[i].location;
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, components, type, normalized, (GLsizei)_stride, (void*)_offsets[i]);
+            }
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        void vertex_layout::encode(const glm::vec4& value, size_t attribute, void* vertex) const {
+            uint8_t* out = (uint8_t*)vertex + _offsets[attribute];
+            switch (_attributes[attribute].format) {
+                case vertex_format::float2: std::memcpy(out, &value, 8); break;
+                case vertex_format::float3: std::memcpy(out, &value, 12); break;
+                case vertex_format::float4: std::memcpy(out, &value, 16); break;
+                case vertex_format::half2: {
+                    uint32_t packed = glm::packHalf2x16(glm::vec2(value));
+                    std::memcpy(out, &packed, 4);
+                    break;
+                }
+                case vertex_format::half4: {
+                    uint64_t packed = glm::packHalf4x16(value);
+                    std::memcpy(out, &packed, 8);
+                    break;
+                }
+                case vertex_format::octahedral: {
+                    uint32_t packed = pack_octahedral(glm::vec3(value));
+                    std::memcpy(out, &packed, 4);
+                    break;
+                }
+                case vertex_format::octahedral_tangent: {
+                    uint32_t packed = pack_tangent(value);
+                    std::memcpy(out, &packed, 4);
+                    break;
+                }
+                case vertex_format::unorm8x4: {
+                    uint32_t packed = glm::packUnorm4x8(value);
+                    std::memcpy(out, &packed, 4);
+                    break;
+                }
+            }
+        }
+
+        glm::vec4 vertex_layout::decode(const void* vertex, size_t attribute) const {
+            const uint8_t* in = (const uint8_t*)vertex + _offsets[attribute];
+            glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+            uint32_t packed32;
+            uint64_t packed64;
+            switch (_attributes[attribute].format) {
+                case vertex_format::float2: std::memcpy(&value, in, 8); break;
+                case vertex_format::float3: std::memcpy(&value, in, 12); break;
+                case vertex_format::float4: std::memcpy(&value, in, 16); break;
+                case vertex_format::half2:
+                    std::memcpy(&packed32, in, 4);
+                    value = glm::vec4(glm::unpackHalf2x16(packed32), 0.0f, 1.0f);
+                    break;
+                case vertex_format::half4:
+                    std::memcpy(&packed64, in, 8);
+                    value = glm::unpackHalf4x16(packed64);
+                    break;
+                case vertex_format::octahedral:
+                    std::memcpy(&packed32, in, 4);
+                    value = glm::vec4(unpack_octahedral(packed32), 0.0f);
+                    break;
+                case vertex_format::octahedral_tangent:
+                    std::memcpy(&packed32, in, 4);
+                    value = unpack_tangent(packed32);
+                    break;
+                case vertex_format::unorm8x4:
+                    std::memcpy(&packed32, in, 4);
+                    value = glm::unpackUnorm4x8(packed32);
+                    break;
+            }
+            return value;
+        }
+
+        std::vector<uint8_t> vertex_layout::pack(const mesh_data& mesh) const {
+            size_t count = mesh.vertex_count();
+            std::vector<uint8_t> data(count * _stride);
+
+            thread_pool::global().parallel_for(count, 4096, [&](size_t begin, size_t end) {
+                for (size_t v = begin; v < end; v++) {
+                    uint8_t* vertex = data.data() + v * _stride;
+                    for (size_t a = 0; a < _attributes.size(); a++) {
+                        glm::vec4 value;
+                        switch (_attributes[a].semantic) {
+                            case vertex_semantic::position:
+                                value = glm::vec4(mesh.positions[v], 1.0f);
+                                break;
+                            case vertex_semantic::normal:
+                                value = v < mesh.normals.size() ? glm::vec4(mesh.normals[v], 0.0f) : glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+                                break;
+                            case vertex_semantic::tangent:
+                                value = v < mesh.tangents.size() ? mesh.tangents[v] : glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+                                break;
+                            case vertex_semantic::uv:
+                                value = v < mesh.uvs.size() ? glm::vec4(mesh.uvs[v], 0.0f, 0.0f) : glm::vec4(0.0f);
+                                break;
+                            case vertex_semantic::color:
+                                value = v < mesh.colors.size() ? mesh.colors[v] : glm::vec4(1.0f);
+                                break;
+                        }
+                        encode(value, a, vertex);
+                    }
+                }
+            });
+            return data;
+        }
+
+        // mesh optimization
+
+        vertex_cache_stats analyze_vertex_cache(const std::vector<uint32_t>& indices, size_t vertex_count, unsigned int cache_size) {
+            vertex_cache_stats stats;
+            if (indices.empty()) {
+                return stats;
+            }
+
+            // a vertex is in the fifo while fewer than cache_size misses happened since it entered
+            std::vector<size_t> entered(vertex_count, 0);
+            size_t misses = 0;
+            std::vector<bool> used(vertex_count, false);
+            size_t unique = 0;
+            for (uint32_t v : indices) {
+                if (!used[v]) {
+                    used[v] = true;
+                    unique++;
+                }
+                if (entered[v] == 0 || misses - entered[v] >= cache_size) {
+                    misses++;
+                    entered[v] = misses;
+                }
+            }
+
+            stats.acmr = (float)misses / (indices.size() / 3);
+            stats.atvr = (float)misses / unique;
+            return stats;
+        }
+
+        vertex_fetch_stats analyze_vertex_fetch(const std::vector<uint32_t>& indices, size_t vertex_count, size_t vertex_size) {
+            constexpr size_t line = 64, lines = 256;
+            vertex_fetch_stats stats;
+            if (indices.empty()) {
+                return stats;
+            }
+
+            std::array<size_t, lines> cache;
+            cache.fill(std::numeric_limits<size_t>::max());
+            std::vector<size_t> entered(vertex_count, 0);
+            std::vector<bool> used(vertex_count, false);
+            size_t misses = 0, unique = 0;
+            for (uint32_t v : indices) {
+                if (!used[v]) {
+                    used[v] = true;
+                    unique++;
+                }
+                // only post-transform cache misses go to memory
+                if (entered[v] != 0 && misses - entered[v] < 16) {
+                    continue;
+                }
+                entered[v] = ++misses;
+
+                for (size_t l = v * vertex_size / line; l <= ((v + 1) * vertex_size - 1) / line; l++) {
+                    if (cache[l % lines] != l) {
+                        cache[l % lines] = l;
+                        stats.bytes_fetched += line;
+                    }
+                }
+            }
+
+            stats.overfetch = (float)stats.bytes_fetched / (unique * vertex_size);
+            return stats;
+        }
+
+        size_t deduplicate_vertices(mesh_data& mesh) {
+            size_t count = mesh.vertex_count();
+
+            // flatten every present stream into one record per vertex
+            size_t width = 3;
+            bool normals = mesh.normals.size() == count, uvs = mesh.uvs.size() == count;
+            bool tangents = mesh.tangents.size() == count, colors = mesh.colors.size() == count;
+            width += (normals ? 3 : 0) + (uvs ? 2 : 0) + (tangents ? 4 : 0) + (colors ? 4 : 0);
+
+            std::vector<float> records(count * width);
+            thread_pool::global().parallel_for(count, 4096, [&](size_t begin, size_t end) {
+                for (size_t v = begin; v < end; v++) {
+                    float* r = records.data() + v * width;
+                    std::memcpy(r, &mesh.positions[v], 12); r += 3;
+                    if (normals) { std::memcpy(r, &mesh.normals[v], 12); r += 3; }
+                    if (uvs) { std::memcpy(r, &mesh.uvs[v], 8); r += 2; }
+                    if (tangents) { std::memcpy(r, &mesh.tangents[v], 16); r += 4; }
+                    if (colors) { std::memcpy(r, &mesh.colors[v], 16); }
+                }
+            });
+
+            auto hash = [&](size_t v) {
+                // fnv-1a over the raw bits
+                uint64_t h = 14695981039346656037ull;
+                const uint8_t* b = (const uint8_t*)(records.data() + v * width);
+                for (size_t i = 0; i < width * sizeof(float); i++) {
+                    h = (h ^ b[i]) * 1099511628211ull;
+                }
+                return h;
+            };
+
+            // open addressing over vertex indices
+            size_t capacity = std::bit_ceil(std::max<size_t>(count * 2, 16));
+            std::vector<uint32_t> table(capacity, UINT32_MAX);
+            std::vector<uint32_t> remap(count);
+            uint32_t unique = 0;
+            for (size_t v = 0; v < count; v++) {
+                size_t slot = hash(v) & (capacity - 1);
+                while (true) {
+                    uint32_t other = table[slot];
+                    if (other == UINT32_MAX) {
+                        table[slot] = (uint32_t)v;
+                        remap[v] = unique++;
+                        break;
+                    }
+                    if (std::memcmp(records.data() + other * width, records.data() + v * width, width * sizeof(float)) == 0) {
+                        remap[v] = remap[other];
+                        break;
+                    }
+                    slot = (slot + 1) & (capacity - 1);
+                }
+            }
+
+            if (unique == count) {
+                return count;
+            }
+
+            // first occurrences keep their relative order, so remap[v] <= v and this can go in place
+            for (size_t v = 0; v < count; v++) {
+                uint32_t r = remap[v];
+                mesh.positions[r] = mesh.positions[v];
+                if (normals) mesh.normals[r] = mesh.normals[v];
+                if (uvs) mesh.uvs[r] = mesh.uvs[v];
+                if (tangents) mesh.tangents[r] = mesh.tangents[v];
+                if (colors) mesh.colors[r] = mesh.colors[v];
+            }
+            mesh.positions.resize(unique);
+            if (normals) mesh.normals.resize(unique);
+            if (uvs) mesh.uvs.resize(unique);
+            if (tangents) mesh.tangents.resize(unique);
+            if (colors) mesh.colors.resize(unique);
+
+            for (uint32_t& i : mesh.indices) {
+                i = remap[i];
+            }
+            return unique;
+        }
+
+        namespace optimize_detail {
+
+            constexpr int cache_size = 32;
+
+            static float vertex_score(int cache_position, uint32_t remaining) {
+                if (remaining == 0) {
+                    return -1.0f;
+                }
+                float score = 0.0f;
+                if (cache_position >= 0) {
+                    // the last triangle's vertices get a fixed score so the next one doesn't just reuse them
+                    score = cache_position < 3 ? 0.75f : std::pow(1.0f - (float)(cache_position - 3) / (cache_size - 3), 1.5f);
+                }
+                // favor vertices with few triangles left, they would otherwise be orphaned
+                return score + 2.0f / std::sqrt((float)remaining);
+            }
+
+        }
+
+        void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count) {
+            using namespace optimize_detail;
+
+            size_t triangles = indices.size() / 3;
+            if (triangles == 0) {
+                return;
+            }
+
+            // vertex -> triangle adjacency
+            std::vector<uint32_t> offsets(vertex_count + 1, 0), remaining(vertex_count, 0);
+            for (uint32_t v : indices) {
+                offsets[v + 1]++;
+            }
+            for (size_t v = 0; v < vertex_count; v++) {
+                remaining[v] = offsets[v + 1];
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<uint32_t> adjacency(indices.size());
+            {
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++) {
+                    adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+                }
+            }
+
+            std::vector<int> position(vertex_count, -1);
+            std::vector<float> score(vertex_count);
+            for (size_t v = 0; v < vertex_count; v++) {
+                score[v] = vertex_score(-1, remaining[v]);
+            }
+            std::vector<float> triangle_score(triangles);
+            for (size_t t = 0; t < triangles; t++) {
+                triangle_score[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+            }
+
+            std::vector<bool> emitted(triangles, false);
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            std::vector<uint32_t> cache, next;
+            cache.reserve(cache_size + 3);
+            next.reserve(cache_size + 3);
+
+            size_t cursor = 0;
+            int64_t best = std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin();
+
+            for (size_t done = 0; done < triangles; done++) {
+                if (best < 0) {
+                    // nothing in the cache has work left, take the next unemitted triangle
+                    while (emitted[cursor]) {
+                        cursor++;
+                    }
+                    best = (int64_t)cursor;
+                }
+
+                uint32_t tri[3] = { indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2] };
+                emitted[best] = true;
+                result.insert(result.end(), tri, tri + 3);
+
+                // drop the triangle from its vertices' adjacency
+                for (uint32_t v : tri) {
+                    uint32_t* begin = adjacency.data() + offsets[v];
+                    uint32_t* end = begin + remaining[v];
+                    *std::find(begin, end, (uint32_t)best) = *(end - 1);
+                    remaining[v]--;
+                }
+
+                // the triangle's vertices move to the front, the rest shift back
+                next.assign(tri, tri + 3);
+                for (uint32_t v : cache) {
+                    if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                        next.push_back(v);
+                    }
+                }
+                for (size_t i = 0; i < next.size(); i++) {
+                    uint32_t v = next[i];
+                    position[v] = i < (size_t)cache_size ? (int)i : -1;
+                    score[v] = vertex_score(position[v], remaining[v]);
+                }
+                if (next.size() > (size_t)cache_size) {
+                    next.resize(cache_size);
+                }
+                std::swap(cache, next);
+
+                // rescore triangles touching the cache and pick the best of them
+                best = -1;
+                float best_score = -1.0f;
+                for (uint32_t v : cache) {
+                    for (uint32_t a = offsets[v]; a < offsets[v] + remaining[v]; a++) {
+                        uint32_t t = adjacency[a];
+                        float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                        triangle_score[t] = s;
+                        if (s > best_score) {
+                            best_score = s;
+                            best = t;
+                        }
+                    }
+                }
+            }
+
+            indices.swap(result);
+        }
+
+        void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions) {
+            size_t triangles = indices.size() / 3;
+            if (triangles < 2) {
+                return;
+            }
+
+            // only the vertex span these indices reference is touched, so calling this per
+            // submesh of a shared vertex array stays linear in the submesh
+            auto [lo, hi] = std::minmax_element(indices.begin(), indices.end());
+            uint32_t first = *lo, last = *hi;
+
+            // a triangle missing the cache on all three vertices starts a new cluster,
+            // reordering whole clusters leaves the cache behavior within them intact
+            std::vector<uint32_t> starts;
+            std::vector<size_t> entered(last - first + 1, 0);
+            size_t misses = 0;
+            for (size_t t = 0; t < triangles; t++) {
+                int tri_misses = 0;
+                for (int k = 0; k < 3; k++) {
+                    uint32_t v = indices[t * 3 + k] - first;
+                    if (entered[v] == 0 || misses - entered[v] >= 16) {
+                        entered[v] = ++misses;
+                        tri_misses++;
+                    }
+                }
+                if (tri_misses == 3 || t == 0) {
+                    starts.push_back((uint32_t)t);
+                }
+            }
+            starts.push_back((uint32_t)triangles);
+
+            glm::vec3 mesh_center(0.0f);
+            for (uint32_t v = first; v <= last; v++) {
+                mesh_center += positions[v];
+            }
+            mesh_center /= (float)(last - first + 1);
+
+            // clusters facing away from the center are likely on the silhouette and occlude the rest
+            size_t clusters = starts.size() - 1;
+            std::vector<float> sort_key(clusters);
+            thread_pool::global().parallel_for(clusters, 256, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; c++) {
+                    glm::vec3 centroid(0.0f), normal(0.0f);
+                    float area = 0.0f;
+                    for (uint32_t t = starts[c]; t < starts[c + 1]; t++) {
+                        const glm::vec3& a = positions[indices[t * 3]];
+                        const glm::vec3& b = positions[indices[t * 3 + 1]];
+                        const glm::vec3& d = positions[indices[t * 3 + 2]];
+                        glm::vec3 n = glm::cross(b - a, d - a);
+                        float w = glm::length(n);
+                        centroid += (a + b + d) * (w / 3.0f);
+                        normal += n;
+                        area += w;
+                    }
+                    centroid = area > 0.0f ? centroid / area : centroid;
+                    float len = glm::length(normal);
+                    sort_key[c] = len > 0.0f ? glm::dot(centroid - mesh_center, normal / len) : 0.0f;
+                }
+            });
+
+            std::vector<uint32_t> order(clusters);
+            for (uint32_t c = 0; c < clusters; c++) {
+                order[c] = c;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sort_key[a] > sort_key[b]; });
+
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            for (uint32_t c : order) {
+                result.insert(result.end(), indices.begin() + starts[c] * 3, indices.begin() + starts[c + 1] * 3);
+            }
+            indices.swap(result);
+        }
+
+        size_t optimize_vertex_fetch(mesh_data& mesh) {
+            size_t count = mesh.vertex_count();
+            std::vector<uint32_t> remap(count, UINT32_MAX);
+            uint32_t next = 0;
+            for (uint32_t& i : mesh.indices) {
+                if (remap[i] == UINT32_MAX) {
+                    remap[i] = next++;
+                }
+                i = remap[i];
+            }
+
+            auto reorder = [&](auto& stream) {
+                if (stream.size() != count) {
+                    return;
+                }
+                std::remove_reference_t<decltype(stream)> sorted(next);
+                for (size_t v = 0; v < count; v++) {
+                    if (remap[v] != UINT32_MAX) {
+                        sorted[remap[v]] = stream[v];
+                    }
+                }
+                stream.swap(sorted);
+            };
+            reorder(mesh.positions);
+            reorder(mesh.normals);
+            reorder(mesh.uvs);
+            reorder(mesh.tangents);
+            reorder(mesh.colors);
+            return next;
+        }
+
+        index_data pack_indices(const std::vector<uint32_t>& indices, size_t vertex_count) {
+            index_data result;
+            result.count = indices.size();
+            if (vertex_count <= 65536) {
+                result.type = GL_UNSIGNED_SHORT;
+                result.data.resize(indices.size() * sizeof(uint16_t));
+                uint16_t* out = (uint16_t*)result.data.data();
+                for (size_t i = 0; i < indices.size(); i++) {
+                    out[i] = (uint16_t)indices[i];
+                }
+            } else {
+                result.type = GL_UNSIGNED_INT;
+                result.data.resize(indices.size() * sizeof(uint32_t));
+                std::memcpy(result.data.data(), indices.data(), result.data.size());
+            }
+            return result;
+        }
+
+        mesh_optimize_report optimize_mesh(mesh_data& mesh, size_t vertex_size) {
+            mesh_optimize_report report;
+            report.vertices_before = mesh.vertex_count();
+            report.cache_before = analyze_vertex_cache(mesh.indices, mesh.vertex_count());
+            report.fetch_before = analyze_vertex_fetch(mesh.indices, mesh.vertex_count(), vertex_size);
+
+            deduplicate_vertices(mesh);
+            optimize_vertex_cache(mesh.indices, mesh.vertex_count());
+            optimize_overdraw(mesh.indices, mesh.positions);
+            optimize_vertex_fetch(mesh);
+
+            report.vertices_after = mesh.vertex_count();
+            report.cache_after = analyze_vertex_cache(mesh.indices, mesh.vertex_count());
+            report.fetch_after = analyze_vertex_fetch(mesh.indices, mesh.vertex_count(), vertex_size);
+
+            LOG_INFO("mesh optimized: {} -> {} vertices, acmr {:.3f} -> {:.3f}, overfetch {:.3f} -> {:.3f}",
+                report.vertices_before, report.vertices_after, report.cache_before.acmr, report.cache_after.acmr,
+                report.fetch_before.overfetch, report.fetch_after.overfetch);
+            return report;
+        }
+
+        // memory mapped files
+
+        mapped_file::mapped_file(const char* path) {
+        #if defined(_WIN32)
+            HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                LOG_ERROR("Failed to open file: {}", path);
+                return;
+            }
+            LARGE_INTEGER size;
+            GetFileSizeEx(file, &size);
+            _size = (size_t)size.QuadPart;
+            if (_size) {
+                _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                _data = _mapping ? (const uint8_t*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            }
+            CloseHandle(file);
+        #else
+            int file = ::open(path, O_RDONLY);
+            if (file < 0) {
+                LOG_ERROR("Failed to open file: {}", path);
+                return;
+            }
+            struct stat st;
+            fstat(file, &st);
+            _size = (size_t)st.st_size;
+            if (_size) {
+                void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+                _data = data == MAP_FAILED ? nullptr : (const uint8_t*)data;
+            }
+            ::close(file);
+        #endif
+            if (_size && !_data) {
+                LOG_ERROR("Failed to map file: {}", path);
+                close();
+                return;
+            }
+            _open = true;
+        }
+
+        mapped_file::~mapped_file() {
+            close();
+        }
+
+        mapped_file::mapped_file(mapped_file&& other) noexcept
+            : _data(other._data), _size(other._size), _open(other._open), _mapping(other._mapping)
+        {
+            other._data = nullptr;
+            other._mapping = nullptr;
+            other._size = 0;
+            other._open = false;
+        }
+
+        mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+                close();
+                std::swap(_data, other._data);
+                std::swap(_size, other._size);
+                std::swap(_open, other._open);
+                std::swap(_mapping, other._mapping);
+            }
+            return *this;
+        }
+
+        void mapped_file::close() {
+        #if defined(_WIN32)
+            if (_data) {
+                UnmapViewOfFile(_data);
+            }
+            if (_mapping) {
+                CloseHandle(_mapping);
+            }
+        #else
+            if (_data) {
+                munmap((void*)_data, _size);
+            }
+        #endif
+            _data = nullptr;
+            _mapping = nullptr;
+            _size = 0;
+            _open = false;
+        }
+
+        // asset packs
+
+        namespace pack_detail {
+
+            constexpr uint32_t magic = 0x4b41504f;   // "OPAK"
+            constexpr uint32_t version = 1;
+            constexpr size_t alignment = 4096;
+            constexpr uint32_t raw_block = 0x80000000u;
+
+            struct header {
+                uint32_t magic, version;
+                uint32_t entry_count, block_size;
+                uint64_t toc_offset;
+                uint64_t names_offset, names_size;
+                uint8_t reserved[24];
+            };
+            static_assert(sizeof(header) == 64 && sizeof(asset_pack::entry) == 48);
+
+            struct mounts {
+                std::mutex mutex;
+                std::vector<std::unique_ptr<asset_pack>> packs;
+            };
+
+            static mounts& registry() {
+                static mounts m;
+                return m;
+            }
+
+            static inline size_t align(size_t value) {
+                return (value + alignment - 1) & ~(alignment - 1);
+            }
+
+            // lz4 block format: token, literals, 16-bit offset, match length. greedy with one
+            // hash probe, which keeps cooking fast and loses a few percent to lz4hc
+            static size_t lz4_compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+                constexpr size_t last_literals = 5, match_guard = 12;
+                uint8_t* out = dst;
+                uint8_t* out_end = dst + capacity;
+
+                auto length = [&](size_t value) {
+                    while (value >= 255) {
+                        *out++ = 255;
+                        value -= 255;
+                    }
+                    *out++ = (uint8_t)value;
+                };
+                auto sequence = [&](size_t literal_start, size_t literals, size_t offset, size_t match) {
+                    size_t need = 1 + literals + literals / 255 + 1 + (match ? 3 + match / 255 : 0);
+                    if ((size_t)(out_end - out) < need) {
+                        return false;
+                    }
+                    uint8_t* token = out++;
+                    *token = (uint8_t)(std::min<size_t>(literals, 15) << 4);
+                    if (literals >= 15) {
+                        length(literals - 15);
+                    }
+                    std::memcpy(out, src + literal_start, literals);
+                    out += literals;
+                    if (match) {
+                        *out++ = (uint8_t)offset;
+                        *out++ = (uint8_t)(offset >> 8);
+                        *token |= (uint8_t)std::min<size_t>(match - 4, 15);
+                        if (match - 4 >= 15) {
+                            length(match - 4 - 15);
+                        }
+                    }
+                    return true;
+                };
+
+                size_t anchor = 0;
+                if (size > match_guard) {
+                    std::vector<int32_t> table(1 << 12, -1);
+                    size_t i = 0;
+                    while (i + match_guard <= size) {
+                        uint32_t seq;
+                        std::memcpy(&seq, src + i, 4);
+                        uint32_t h = (seq * 2654435761u) >> 20;
+                        int32_t candidate = table[h];
+                        table[h] = (int32_t)i;
+                        if (candidate < 0 || i - candidate > 65535 || std::memcmp(src + candidate, src + i, 4) != 0) {
+                            i++;
+                            continue;
+                        }
+                        size_t m = (size_t)candidate;
+                        while (i > anchor && m > 0 && src[i - 1] == src[m - 1]) {
+                            i--;
+                            m--;
+                        }
+                        size_t match = 4, limit = size - last_literals - i;
+                        while (match < limit && src[i + match] == src[m + match]) {
+                            match++;
+                        }
+                        if (!sequence(anchor, i - anchor, i - m, match)) {
+                            return 0;
+                        }
+                        i += match;
+                        anchor = i;
+                    }
+                }
+                if (!sequence(anchor, size - anchor, 0, 0)) {
+                    return 0;
+                }
+                return out - dst;
+            }
+
+            static bool lz4_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t out_size) {
+                const uint8_t* in = src;
+                const uint8_t* in_end = src + size;
+                uint8_t* out = dst;
+                uint8_t* out_end = dst + out_size;
+
+                auto length = [&](size_t& value) {
+                    uint8_t b;
+                    do {
+                        if (in >= in_end) {
+                            return false;
+                        }
+                        b = *in++;
+                        value += b;
+                    } while (b == 255);
+                    return true;
+                };
+
+                while (in < in_end) {
+                    uint8_t token = *in++;
+                    size_t literals = token >> 4;
+                    if (literals == 15 && !length(literals)) {
+                        return false;
+                    }
+                    if ((size_t)(in_end - in) < literals || (size_t)(out_end - out) < literals) {
+                        return false;
+                    }
+                    std::memcpy(out, in, literals);
+                    in += literals;
+                    out += literals;
+                    if (in == in_end) {
+                        break;
+                    }
+
+                    if (in_end - in < 2) {
+                        return false;
+                    }
+                    size_t offset = in[0] | (size_t)in[1] << 8;
+                    in += 2;
+                    size_t match = (token & 15) + 4;
+                    if ((token & 15) == 15 && !length(match)) {
+                        return false;
+                    }
+                    if (offset == 0 || offset > (size_t)(out - dst) || (size_t)(out_end - out) < match) {
+                        return false;
+                    }
+                    const uint8_t* from = out - offset;
+                    size_t i = 0;
+                    if (offset >= 8) {
+                        for (; i + 8 <= match; i += 8) {
+                            std::memcpy(out + i, from + i, 8);
+                        }
+                    }
+                    for (; i < match; i++) {
+                        out[i] = from[i];
+                    }
+                    out += match;
+                }
+                return out == out_end;
+            }
+
+        }
+
+        asset_pack::asset_pack(const char* path) : _file(path) {
+            if (!_file.valid()) {
+                return;
+            }
+            const uint8_t* data = _file.data();
+            size_t size = _file.size();
+            pack_detail::header h;
+            if (size < sizeof(h)) {
+                LOG_ERROR("Not an asset pack: {}", path);
+                _file = mapped_file();
+                return;
+            }
+            std::memcpy(&h, data, sizeof(h));
+            if (h.magic != pack_detail::magic || h.version != pack_detail::version || !h.block_size ||
+                h.toc_offset % alignof(entry) || h.toc_offset > size || (size - h.toc_offset) / sizeof(entry) < h.entry_count ||
+                h.names_offset > size || size - h.names_offset < h.names_size) {
+                LOG_ERROR("Not an asset pack: {}", path);
+                _file = mapped_file();
+                return;
+            }
+
+            const entry* entries = (const entry*)(data + h.toc_offset);
+            for (uint32_t i = 0; i < h.entry_count; i++) {
+                const entry& e = entries[i];
+                if (e.offset > size || size - e.offset < e.stored_size || e.name_offset > h.names_size || h.names_size - e.name_offset < e.name_size) {
+                    LOG_ERROR("Corrupt entry {} in asset pack: {}", i, path);
+                    _file = mapped_file();
+                    return;
+                }
+            }
+            _entries = h.entry_count ? entries : nullptr;
+            _count = h.entry_count;
+            _block_size = h.block_size;
+            _names = (const char*)data + h.names_offset;
+            _names_size = h.names_size;
+        }
+
+        const asset_pack::entry* asset_pack::find(std::string_view name) const {
+            std::string key = normalize(name);
+            uint64_t h = hash(key);
+            const entry* it = std::lower_bound(_entries, _entries + _count, h, [](const entry& e, uint64_t value) { return e.hash < value; });
+            for (; it != _entries + _count && it->hash == h; ++it) {
+                if (this->name(*it) == key) {
+                    return it;
+                }
+            }
+            return nullptr;
+        }
+
+        std::string_view asset_pack::name(const entry& e) const {
+            return { _names + e.name_offset, e.name_size };
+        }
+
+        std::span<const uint8_t> asset_pack::view(const entry& e) const {
+            // the mount only checked stored_size against the file, a raw entry must match it exactly
+            if ((e.flags & compressed) || e.stored_size != e.size) {
+                return {};
+            }
+            return { _file.data() + e.offset, (size_t)e.size };
+        }
+
+        bool asset_pack::read(const entry& e, uint8_t* dst) const {
+            const uint8_t* src = _file.data() + e.offset;
+            if (!(e.flags & compressed)) {
+                if (e.stored_size != e.size) {
+                    return false;
+                }
+                std::memcpy(dst, src, e.size);
+                return true;
+            }
+
+            size_t blocks = (size_t)((e.size + _block_size - 1) / _block_size);
+            if (e.stored_size < blocks * 4) {
+                return false;
+            }
+            const uint8_t* payload = src + blocks * 4;
+            size_t payload_size = e.stored_size - blocks * 4;
+            std::atomic<bool> ok = true;
+            thread_pool::global().parallel_for(blocks, 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end && ok.load(std::memory_order_relaxed); i++) {
+                    uint32_t first = 0, last;
+                    if (i) {
+                        std::memcpy(&first, src + (i - 1) * 4, 4);
+                    }
+                    std::memcpy(&last, src + i * 4, 4);
+                    bool raw = last & pack_detail::raw_block;
+                    first &= ~pack_detail::raw_block;
+                    last &= ~pack_detail::raw_block;
+                    size_t out_size = std::min<size_t>(_block_size, e.size - i * _block_size);
+                    if (first > last || last > payload_size) {
+                        ok = false;
+                    } else if (raw) {
+                        if (last - first != out_size) {
+                            ok = false;
+                        } else {
+                            std::memcpy(dst + i * _block_size, payload + first, out_size);
+                        }
+                    } else if (!pack_detail::lz4_decompress(payload + first, last - first, dst + i * _block_size, out_size)) {
+                        ok = false;
+                    }
+                }
+            });
+            return ok;
+        }
+
+        std::string asset_pack::normalize(std::string_view name) {
+            std::string out(name);
+            std::replace(out.begin(), out.end(), '\\', '/');
+            while (out.starts_with("./")) {
+                out.erase(0, 2);
+            }
+            return out;
+        }
+
+        uint64_t asset_pack::hash(std::string_view name) {
+            // fnv-1a
+            uint64_t h = 0xcbf29ce484222325ull;
+            for (char c : name) {
+                h = (h ^ (uint8_t)c) * 0x100000001b3ull;
+            }
+            return h;
+        }
+
+        bool asset_pack::mount(const char* path) {
+            auto pack = std::make_unique<asset_pack>(path);
+            if (!pack->valid()) {
+                return false;
+            }
+            LOG_INFO("Mounted asset pack {} ({} files)", path, pack->entries().size());
+            pack_detail::mounts& m = pack_detail::registry();
+            std::lock_guard<std::mutex> lock(m.mutex);
+            m.packs.insert(m.packs.begin(), std::move(pack));
+            return true;
+        }
+
+        void asset_pack::unmount_all() {
+            pack_detail::mounts& m = pack_detail::registry();
+            std::lock_guard<std::mutex> lock(m.mutex);
+            m.packs.clear();
+        }
+
+        const asset_pack* asset_pack::locate(std::string_view name) {
+            pack_detail::mounts& m = pack_detail::registry();
+            std::lock_guard<std::mutex> lock(m.mutex);
+            for (const std::unique_ptr<asset_pack>& pack : m.packs) {
+                if (pack->find(name)) {
+                    return pack.get();
+                }
+            }
+            return nullptr;
+        }
+
+        asset_pack_builder::asset_pack_builder(size_t block_size) : _block_size(std::clamp<size_t>(block_size, 4096, 1 << 22)) {}
+
+        void asset_pack_builder::add(std::string_view name, std::vector<uint8_t> data, bool compress) {
+            _files[asset_pack::normalize(name)] = { std::move(data), compress };
+        }
+
+        bool asset_pack_builder::add_file(std::string_view name, const char* path, bool compress) {
+            mapped_file file(path);
+            if (!file.valid()) {
+                return false;
+            }
+            add(name, std::vector<uint8_t>(file.data(), file.data() + file.size()), compress);
+            return true;
+        }
+
+        size_t asset_pack_builder::add_directory(const char* dir, bool compress) {
+            std::error_code error;
+            std::filesystem::path root(dir);
+            size_t added = 0;
+            for (auto it = std::filesystem::recursive_directory_iterator(root, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+                if (!it->is_regular_file()) {
+                    continue;
+                }
+                std::string name = (root / std::filesystem::relative(it->path(), root)).generic_string();
+                if (add_file(name, it->path().string().c_str(), compress)) {
+                    added++;
+                }
+            }
+            if (error) {
+                LOG_ERROR("Failed to scan {}: {}", dir, error.message());
+            }
+            return added;
+        }
+
+        bool asset_pack_builder::write(const char* path) const {
+            struct packed {
+                const std::string* name;
+                const std::vector<uint8_t>* data;
+                std::vector<uint8_t> stored;   // block table + blocks, empty when stored raw
+            };
+            std::vector<packed> files;
+            files.reserve(_files.size());
+            for (const auto& [name, file] : _files) {
+                files.push_back({ &name, &file.data, {} });
+            }
+
+            // every block of every file is one job
+            std::vector<std::pair<size_t, size_t>> jobs;
+            for (size_t f = 0; f < files.size(); f++) {
+                if (_files.at(*files[f].name).compress) {
+                    for (size_t b = 0; b * _block_size < files[f].data->size(); b++) {
+                        jobs.push_back({ f, b });
+                    }
+                }
+            }
+            std::vector<std::vector<uint8_t>> blocks(jobs.size());
+            thread_pool::global().parallel_for(jobs.size(), 4, [&](size_t begin, size_t end) {
+                for (size_t j = begin; j < end; j++) {
+                    const std::vector<uint8_t>& data = *files[jobs[j].first].data;
+                    size_t first = jobs[j].second * _block_size, size = std::min(_block_size, data.size() - first);
+                    blocks[j].resize(size);
+                    size_t packed_size = pack_detail::lz4_compress(data.data() + first, size, blocks[j].data(), size - 1);
+                    blocks[j].resize(packed_size);   // empty: incompressible, kept raw
+                }
+            });
+
+            for (size_t j = 0, f; j < jobs.size(); j = f) {
+                size_t file = jobs[j].first;
+                for (f = j; f < jobs.size() && jobs[f].first == file; f++) {}
+                const std::vector<uint8_t>& data = *files[file].data;
+                size_t count = f - j;
+                std::vector<uint8_t> stored(count * 4);
+                for (size_t b = 0; b < count; b++) {
+                    const std::vector<uint8_t>& block = blocks[j + b];
+                    size_t first = b * _block_size, size = std::min(_block_size, data.size() - first);
+                    if (block.empty()) {
+                        stored.insert(stored.end(), data.begin() + first, data.begin() + first + size);
+                    } else {
+                        stored.insert(stored.end(), block.begin(), block.end());
+                    }
+                    uint32_t end = (uint32_t)(stored.size() - count * 4) | (block.empty() ? pack_detail::raw_block : 0);
+                    std::memcpy(stored.data() + b * 4, &end, 4);
+                }
+                if (stored.size() < data.size() - data.size() / 8) {
+                    files[file].stored = std::move(stored);
+                }
+            }
+
+            std::vector<asset_pack::entry> toc;
+            std::string names;
+            size_t offset = pack_detail::align(sizeof(pack_detail::header));
+            size_t raw = 0;
+            for (const packed& file : files) {
+                bool packed_file = !file.stored.empty();
+                size_t stored = packed_file ? file.stored.size() : file.data->size();
+                toc.push_back({ asset_pack::hash(*file.name), offset, file.data->size(), stored,
+                                (uint32_t)names.size(), (uint32_t)file.name->size(), packed_file ? asset_pack::compressed : 0u, 0 });
+                names += *file.name;
+                offset = pack_detail::align(offset + stored);
+                raw += file.data->size();
+            }
+
+            pack_detail::header h = {};
+            h.magic = pack_detail::magic;
+            h.version = pack_detail::version;
+            h.entry_count = (uint32_t)toc.size();
+            h.block_size = (uint32_t)_block_size;
+            h.toc_offset = offset;
+            h.names_offset = offset + toc.size() * sizeof(asset_pack::entry);
+            h.names_size = names.size();
+
+            // payloads are written in name order, the toc is searched in hash order
+            std::vector<asset_pack::entry> sorted = toc;
+            std::sort(sorted.begin(), sorted.end(), [](const asset_pack::entry& a, const asset_pack::entry& b) { return a.hash < b.hash; });
+
+            std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!out) {
+                LOG_ERROR("Failed to create asset pack: {}", path);
+                return false;
+            }
+            std::vector<char> padding(pack_detail::alignment, 0);
+            size_t written = 0;
+            auto emit = [&](const void* data, size_t size) {
+                out.write((const char*)data, size);
+                written += size;
+            };
+            auto pad = [&]() {
+                emit(padding.data(), pack_detail::align(written) - written);
+            };
+            emit(&h, sizeof(h));
+            for (size_t i = 0; i < files.size(); i++) {
+                pad();
+                const std::vector<uint8_t>& payload = files[i].stored.empty() ? *files[i].data : files[i].stored;
+                emit(payload.data(), payload.size());
+            }
+            pad();
+            emit(sorted.data(), sorted.size() * sizeof(asset_pack::entry));
+            emit(names.data(), names.size());
+            if (!out) {
+                LOG_ERROR("Failed to write asset pack: {}", path);
+                return false;
+            }
+            LOG_INFO("Wrote asset pack {}: {} files, {} KiB -> {} KiB", path, files.size(), raw / 1024, written / 1024);
+            return true;
+        }
+
+        // float parsing
+
+        static inline bool is_digit(char c) {
+            return (unsigned char)(c - '0') < 10;
+        }
+
+        // length of the digit run at p, 16 bytes per step while there is room
+        static size_t digit_run(const char* p, const char* end) {
+            size_t n = 0;
+        #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+            __m128i below = _mm_set1_epi8('0' - 1), above = _mm_set1_epi8('9' + 1);
+            while (end - p - (ptrdiff_t)n >= 16) {
+                __m128i c = _mm_loadu_si128((const __m128i*)(p + n));
+                __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(c, below), _mm_cmplt_epi8(c, above));
+                uint32_t stop = ~(uint32_t)_mm_movemask_epi8(digits) & 0xffff;
+                if (stop) {
+                    return n + std::countr_zero(stop);
+                }
+                n += 16;
+            }
+        #endif
+            while (p + n < end && is_digit(p[n])) {
+                n++;
+            }
+            return n;
+        }
+
+        // eight ascii digits to their value with swar multiplies
+        static inline uint64_t parse_eight_digits(const char* p) {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            v -= 0x3030303030303030ull;
+            v = (v * 10 + (v >> 8)) & 0x00ff00ff00ff00ffull;
+            v = (v * 100 + (v >> 16)) & 0x0000ffff0000ffffull;
+            v = (v * 10000 + (v >> 32)) & 0x00000000ffffffffull;
+            return v;
+        }
+
+        static inline uint64_t accumulate_digits(const char* p, size_t n, uint64_t value) {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                value = value * 100000000ull + parse_eight_digits(p + i);
+            }
+            for (; i < n; i++) {
+                value = value * 10 + (uint64_t)(p[i] - '0');
+            }
+            return value;
+        }
+
+        static bool parse_double(const char*& p, const char* end, double& out) {
+            const char* start = p;
+            const char* s = p;
+            bool negative = false;
+            if (s < end && (*s == '-' || *s == '+')) {
+                negative = *s == '-';
+                s++;
+            }
+
+            const char* int_begin = s;
+            size_t int_digits = digit_run(s, end);
+            s += int_digits;
+            const char* frac_begin = s;
+            size_t frac_digits = 0;
+            if (s < end && *s == '.') {
+                frac_begin = ++s;
+                frac_digits = digit_run(s, end);
+                s += frac_digits;
+            }
+            if (int_digits + frac_digits == 0) {
+                return false;
+            }
+
+            int exponent = 0;
+            if (s < end && (*s == 'e' || *s == 'E')) {
+                const char* e = s + 1;
+                bool exp_negative = false;
+                if (e < end && (*e == '-' || *e == '+')) {
+                    exp_negative = *e == '-';
+                    e++;
+                }
+                size_t exp_digits = digit_run(e, end);
+                if (exp_digits) {
+                    exponent = (int)std::min<uint64_t>(accumulate_digits(e, exp_digits, 0), 100000);
+                    exponent = exp_negative ? -exponent : exponent;
+                    s = e + exp_digits;
+                }
+            }
+
+            // clinger's fast path: an exact mantissa times an exact power of ten rounds once
+            static constexpr double powers[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+            int scale = exponent - (int)frac_digits;
+            if (int_digits + frac_digits <= 19 && scale >= -22 && scale <= 22) {
+                uint64_t mantissa = accumulate_digits(frac_begin, frac_digits, accumulate_digits(int_begin, int_digits, 0));
+                if (mantissa <= (1ull << 53)) {
+                    double value = (double)mantissa;
+                    value = scale < 0 ? value / powers[-scale] : value * powers[scale];
+                    out = negative ? -value : value;
+                    p = s;
+                    return true;
+                }
+            }
+
+            // long mantissas and big exponents take the exact path
+            const char* from = *start == '+' ? start + 1 : start;
+            std::from_chars_result r = std::from_chars(from, s, out);
+            if (r.ec != std::errc()) {
+                return false;
+            }
+            p = s;
+            return true;
+        }
+
+        bool parse_float(const char*& p, const char* end, float& out) {
+            double value;
+            if (!parse_double(p, end, value)) {
+                return false;
+            }
+            out = (float)value;
+            return true;
+        }
+
+        // model import
+
+        namespace obj_detail {
+
+            // negative (relative) indices are stored as chunk-local positions offset by `relative`
+            // until every chunk knows how many elements came before it
+            constexpr int64_t relative = 1ll << 40;
+            constexpr int64_t none = -1;
+
+            struct corner {
+                int64_t v, vt, vn;
+            };
+
+            struct chunk {
+                std::vector<glm::vec3> positions, normals;
+                std::vector<glm::vec2> uvs;
+                std::vector<glm::vec4> colors;
+                std::vector<corner> corners;
+                std::vector<size_t> groups;   // local triangle index where a new o/g/usemtl starts
+                bool failed = false;
+            };
+
+            static inline void skip_spaces(const char*& p, const char* end) {
+                while (p < end && (*p == ' ' || *p == '\t')) {
+                    p++;
+                }
+            }
+
+            static inline bool parse_index(const char*& p, const char* end, int64_t& out) {
+                bool negative = p < end && *p == '-';
+                const char* s = negative ? p + 1 : p;
+                size_t n = digit_run(s, end);
+                if (!n) {
+                    return false;
+                }
+                int64_t value = (int64_t)accumulate_digits(s, n, 0);
+                out = negative ? -value : value;
+                p = s + n;
+                return true;
+            }
+
+            static int64_t resolve_local(int64_t index, size_t local_count) {
+                // 1-based absolute, or relative to the elements read so far
+                return index > 0 ? index - 1 : relative + (int64_t)local_count + index;
+            }
+
+            static void parse_chunk(const char* p, const char* end, chunk& out) {
+                std::vector<corner> polygon;
+                while (p < end) {
+                    const char* line_end = (const char*)std::memchr(p, '\n', end - p);
+                    line_end = line_end ? line_end : end;
+                    skip_spaces(p, line_end);
+
+                    if (p + 1 < line_end && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+                        p += 2;
+                        glm::vec3 v(0.0f);
+                        for (int i = 0; i < 3; i++) {
+                            skip_spaces(p, line_end);
+                            parse_float(p, line_end, v[i]);
+                        }
+                        out.positions.push_back(v);
+
+                        // some exporters append an rgb vertex color
+                        glm::vec4 c(1.0f);
+                        skip_spaces(p, line_end);
+                        if (parse_float(p, line_end, c.r)) {
+                            skip_spaces(p, line_end);
+                            parse_float(p, line_end, c.g);
+                            skip_spaces(p, line_end);
+                            parse_float(p, line_end, c.b);
+                            out.colors.resize(out.positions.size() - 1, glm::vec4(1.0f));
+                            out.colors.push_back(c);
+                        }
+                    } else if (p + 2 < line_end && p[0] == 'v' && p[1] == 't') {
+                        p += 2;
+                        glm::vec2 uv(0.0f);
+                        for (int i = 0; i < 2; i++) {
+                            skip_spaces(p, line_end);
+                            parse_float(p, line_end, uv[i]);
+                        }
+                        out.uvs.push_back(uv);
+                    } else if (p + 2 < line_end && p[0] == 'v' && p[1] == 'n') {
+                        p += 2;
+                        glm::vec3 n(0.0f);
+                        for (int i = 0; i < 3; i++) {
+                            skip_spaces(p, line_end);
+                            parse_float(p, line_end, n[i]);
+                        }
+                        out.normals.push_back(n);
+                    } else if (p + 1 < line_end && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+                        p += 2;
+                        polygon.clear();
+                        while (true) {
+                            skip_spaces(p, line_end);
+                            int64_t v, vt = 0, vn = 0;
+                            if (!parse_index(p, line_end, v)) {
+                                break;
+                            }
+                            // a written 0 would alias a real element, obj counts from 1
+                            bool zero = v == 0;
+                            if (p < line_end && *p == '/') {
+                                p++;
+                                zero |= parse_index(p, line_end, vt) && vt == 0;
+                                if (p < line_end && *p == '/') {
+                                    p++;
+                                    zero |= parse_index(p, line_end, vn) && vn == 0;
+                                }
+                            }
+                            if (zero) {
+                                out.failed = true;
+                                break;
+                            }
+                            polygon.push_back({
+                                resolve_local(v, out.positions.size()),
+                                vt ? resolve_local(vt, out.uvs.size()) : none,
+                                vn ? resolve_local(vn, out.normals.size()) : none
+                            });
+                        }
+                        if (polygon.size() < 3) {
+                            out.failed = true;
+                        }
+                        // convex fan
+                        for (size_t i = 2; i < polygon.size(); i++) {
+                            out.corners.push_back(polygon[0]);
+                            out.corners.push_back(polygon[i - 1]);
+                            out.corners.push_back(polygon[i]);
+                        }
+                    } else if (p < line_end && (*p == 'o' || *p == 'g' || std::string_view(p, line_end - p).starts_with("usemtl"))) {
+                        out.groups.push_back(out.corners.size() / 3);
+                    }
+
+                    p = line_end + 1;
+                }
+                if (!out.colors.empty()) {
+                    out.colors.resize(out.positions.size(), glm::vec4(1.0f));
+                }
+            }
+
+        }
+
+        static bool import_obj(const char* path, model_data& out) {
+            using namespace obj_detail;
+
+            mapped_file file(path);
+            if (!file.valid()) {
+                return false;
+            }
+            const char* begin = (const char*)file.data();
+            const char* end = begin + file.size();
+
+            // split on line boundaries into ~4 MiB chunks
+            constexpr size_t chunk_size = 4 << 20;
+            std::vector<const char*> cuts = { begin };
+            while (end - cuts.back() > (ptrdiff_t)chunk_size) {
+                const char* cut = cuts.back() + chunk_size;
+                const char* nl = (const char*)std::memchr(cut, '\n', end - cut);
+                if (!nl) {
+                    break;
+                }
+                cuts.push_back(nl + 1);
+            }
+            cuts.push_back(end);
+
+            size_t chunk_count = cuts.size() - 1;
+            std::vector<chunk> chunks(chunk_count);
+            thread_pool& pool = thread_pool::global();
+            pool.parallel_for(chunk_count, 1, [&](size_t b, size_t e) {
+                for (size_t c = b; c < e; c++) {
+                    parse_chunk(cuts[c], cuts[c + 1], chunks[c]);
+                }
+            });
+
+            // elements before each chunk, for the relative indices
+            std::vector<size_t> v_base(chunk_count + 1, 0), vt_base(chunk_count + 1, 0), vn_base(chunk_count + 1, 0), tri_base(chunk_count + 1, 0);
+            bool colors = false;
+            for (size_t c = 0; c < chunk_count; c++) {
+                if (chunks[c].failed) {
+                    LOG_ERROR("Malformed face in: {}", path);
+                    return false;
+                }
+                v_base[c + 1] = v_base[c] + chunks[c].positions.size();
+                vt_base[c + 1] = vt_base[c] + chunks[c].uvs.size();
+                vn_base[c + 1] = vn_base[c] + chunks[c].normals.size();
+                tri_base[c + 1] = tri_base[c] + chunks[c].corners.size() / 3;
+                colors |= !chunks[c].colors.empty();
+            }
+
+            std::vector<corner> corners(tri_base[chunk_count] * 3);
+            std::atomic<bool> out_of_range = false;
+            pool.parallel_for(chunk_count, 1, [&](size_t b, size_t e) {
+                for (size_t c = b; c < e; c++) {
+                    auto absolute = [&](int64_t i, size_t base, size_t total) {
+                        if (i == none) {
+                            return none;
+                        }
+                        int64_t a = i >= relative / 2 ? (int64_t)base + (i - relative) : i;
+                        if (a < 0 || a >= (int64_t)total) {
+                            out_of_range = true;
+                            return (int64_t)0;
+                        }
+                        return a;
+                    };
+                    corner* dst = corners.data() + tri_base[c] * 3;
+                    for (const corner& k : chunks[c].corners) {
+                        *dst++ = {
+                            absolute(k.v, v_base[c], v_base[chunk_count]),
+                            absolute(k.vt, vt_base[c], vt_base[chunk_count]),
+                            absolute(k.vn, vn_base[c], vn_base[chunk_count])
+                        };
+                    }
+                }
+            });
+            if (out_of_range) {
+                LOG_ERROR("Face index out of range in: {}", path);
+                return false;
+            }
+
+            std::vector<glm::vec3> positions, normals;
+            std::vector<glm::vec2> uvs;
+            std::vector<glm::vec4> vertex_colors;
+            positions.reserve(v_base[chunk_count]);
+            for (chunk& c : chunks) {
+                positions.insert(positions.end(), c.positions.begin(), c.positions.end());
+                normals.insert(normals.end(), c.normals.begin(), c.normals.end());
+                uvs.insert(uvs.end(), c.uvs.begin(), c.uvs.end());
+                if (colors) {
+                    c.colors.resize(c.positions.size(), glm::vec4(1.0f));
+                    vertex_colors.insert(vertex_colors.end(), c.colors.begin(), c.colors.end());
+                }
+            }
+
+            // one vertex per distinct (v, vt, vn)
+            mesh_data& mesh = out.mesh;
+            mesh = {};
+            mesh.indices.resize(corners.size());
+            size_t capacity = std::bit_ceil(std::max<size_t>(corners.size() * 2, 16));
+            std::vector<uint32_t> table(capacity, UINT32_MAX);
+            bool has_uvs = !uvs.empty(), has_normals = !normals.empty();
+            for (size_t i = 0; i < corners.size(); i++) {
+                const corner& k = corners[i];
+                uint64_t h = ((uint64_t)k.v * 0x9e3779b97f4a7c15ull) ^ ((uint64_t)k.vt * 0xc2b2ae3d27d4eb4full) ^ ((uint64_t)k.vn * 0x165667b19e3779f9ull);
+                size_t slot = (h ^ (h >> 29)) & (capacity - 1);
+                while (true) {
+                    uint32_t first = table[slot];
+                    if (first == UINT32_MAX) {
+                        uint32_t v = (uint32_t)mesh.positions.size();
+                        table[slot] = (uint32_t)i;
+                        mesh.positions.push_back(positions[k.v]);
+                        if (has_uvs) mesh.uvs.push_back(k.vt == none ? glm::vec2(0.0f) : uvs[k.vt]);
+                        if (has_normals) mesh.normals.push_back(k.vn == none ? glm::vec3(0.0f) : normals[k.vn]);
+                        if (colors) mesh.colors.push_back(vertex_colors[k.v]);
+                        mesh.indices[i] = v;
+                        break;
+                    }
+                    const corner& o = corners[first];
+                    if (o.v == k.v && o.vt == k.vt && o.vn == k.vn) {
+                        mesh.indices[i] = mesh.indices[first];
+                        break;
+                    }
+                    slot = (slot + 1) & (capacity - 1);
+                }
+            }
+
+            // submeshes from o/g/usemtl, empty groups collapse
+            std::vector<size_t> starts = { 0 };
+            for (size_t c = 0; c < chunk_count; c++) {
+                for (size_t g : chunks[c].groups) {
+                    starts.push_back(tri_base[c] + g);
+                }
+            }
+            starts.push_back(tri_base[chunk_count]);
+            out.submeshes.clear();
+            for (size_t i = 0; i + 1 < starts.size(); i++) {
+                if (starts[i + 1] > starts[i]) {
+                    out.submeshes.push_back({ (uint32_t)starts[i] * 3, (uint32_t)(starts[i + 1] - starts[i]) * 3 });
+                }
+            }
+            return true;
+        }
+
+        namespace gltf_detail {
+
+            struct json {
+                enum class kind { null, boolean, number, string, array, object };
+
+                kind type = kind::null;
+                double number = 0.0;
+                bool boolean = false;
+                std::string string;
+                std::vector<json> array;
+                std::vector<std::pair<std::string, json>> object;
+
+                const json* find(std::string_view key) const {
+                    for (const auto& [k, v] : object) {
+                        if (k == key) {
+                            return &v;
+                        }
+                    }
+                    return nullptr;
+                }
+
+                double num(std::string_view key, double fallback) const {
+                    const json* v = find(key);
+                    return v && v->type == kind::number ? v->number : fallback;
+                }
+
+                size_t size() const { return array.size(); }
+            };
+
+            struct json_parser {
+                const char* p;
+                const char* end;
+                bool failed = false;
+
+                void skip() {
+                    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+                        p++;
+                    }
+                }
+
+                bool expect(char c) {
+                    skip();
+                    if (p < end && *p == c) {
+                        p++;
+                        return true;
+                    }
+                    failed = true;
+                    return false;
+                }
+
+                std::string parse_string() {
+                    std::string s;
+                    if (!expect('"')) {
+                        return s;
+                    }
+                    while (p < end && *p != '"') {
+                        if (*p == '\\' && p + 1 < end) {
+                            p++;
+                            switch (*p) {
+                                case 'n': s += '\n'; break;
+                                case 't': s += '\t'; break;
+                                case 'r': s += '\r'; break;
+                                case 'b': s += '\b'; break;
+                                case 'f': s += '\f'; break;
+                                case 'u': {
+                                    // names only, keep the bmp code point as utf-8
+                                    unsigned int cp = 0;
+                                    for (int i = 0; i < 4 && p + 1 < end; i++) {
+                                        char h = *++p;
+                                        cp = cp * 16 + (is_digit(h) ? h - '0' : (h | 0x20) - 'a' + 10);
+                                    }
+                                    if (cp < 0x80) {
+                                        s += (char)cp;
+                                    } else if (cp < 0x800) {
+                                        s += (char)(0xc0 | (cp >> 6));
+                                        s += (char)(0x80 | (cp & 0x3f));
+                                    } else {
+                                        s += (char)(0xe0 | (cp >> 12));
+                                        s += (char)(0x80 | ((cp >> 6) & 0x3f));
+                                        s += (char)(0x80 | (cp & 0x3f));
+                                    }
+                                    break;
+                                }
+                                default: s += *p; break;
+                            }
+                            p++;
+                        } else {
+                            s += *p++;
+                        }
+                    }
+                    expect('"');
+                    return s;
+                }
+
+                json parse_value(int depth = 0) {
+                    json v;
+                    skip();
+                    if (p >= end || depth > 64) {
+                        failed = true;
+                        return v;
+                    }
+                    if (*p == '{') {
+                        p++;
+                        v.type = json::kind::object;
+                        skip();
+                        if (p < end && *p == '}') {
+                            p++;
+                            return v;
+                        }
+                        while (!failed) {
+                            std::string key = parse_string();
+                            expect(':');
+                            v.object.emplace_back(std::move(key), parse_value(depth + 1));
+                            skip();
+                            if (p < end && *p == ',') {
+                                p++;
+                                continue;
+                            }
+                            expect('}');
+                            break;
+                        }
+                    } else if (*p == '[') {
+                        p++;
+                        v.type = json::kind::array;
+                        skip();
+                        if (p < end && *p == ']') {
+                            p++;
+                            return v;
+                        }
+                        while (!failed) {
+                            v.array.push_back(parse_value(depth + 1));
+                            skip();
+                            if (p < end && *p == ',') {
+                                p++;
+                                continue;
+                            }
+                            expect(']');
+                            break;
+                        }
+                    } else if (*p == '"') {
+                        v.type = json::kind::string;
+                        v.string = parse_string();
+                    } else if (std::string_view(p, end - p).starts_with("true")) {
+                        v.type = json::kind::boolean;
+                        v.boolean = true;
+                        p += 4;
+                    } else if (std::string_view(p, end - p).starts_with("false")) {
+                        v.type = json::kind::boolean;
+                        p += 5;
+                    } else if (std::string_view(p, end - p).starts_with("null")) {
+                        p += 4;
+                    } else {
+                        v.type = json::kind::number;
+                        if (!parse_double(p, end, v.number)) {
+                            failed = true;
+                        }
+                    }
+                    return v;
+                }
+            };
+
+            struct span {
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+            };
+
+            struct document {
+                json root;
+                std::vector<span> buffers;
+                std::vector<mapped_file> files;
+                std::vector<std::vector<uint8_t>> decoded;
+            };
+
+            static std::vector<uint8_t> decode_base64(std::string_view s) {
+                std::vector<uint8_t> out;
+                out.reserve(s.size() * 3 / 4);
+                uint32_t bits = 0;
+                int count = 0;
+                for (char c : s) {
+                    int v = c >= 'A' && c <= 'Z' ? c - 'A'
+                          : c >= 'a' && c <= 'z' ? c - 'a' + 26
+                          : c >= '0' && c <= '9' ? c - '0' + 52
+                          : c == '+' ? 62 : c == '/' ? 63 : -1;
+                    if (v < 0) {
+                        continue;
+                    }
+                    bits = (bits << 6) | (uint32_t)v;
+                    if (++count == 4) {
+                        out.push_back((uint8_t)(bits >> 16));
+                        out.push_back((uint8_t)(bits >> 8));
+                        out.push_back((uint8_t)bits);
+                        bits = 0;
+                        count = 0;
+                    }
+                }
+                if (count == 3) {
+                    out.push_back((uint8_t)(bits >> 10));
+                    out.push_back((uint8_t)(bits >> 2));
+                } else if (count == 2) {
+                    out.push_back((uint8_t)(bits >> 4));
+                }
+                return out;
+            }
+
+            static std::string decode_uri(std::string_view uri) {
+                std::string s;
+                for (size_t i = 0; i < uri.size(); i++) {
+                    unsigned int c = 0;
+                    if (uri[i] == '%' && i + 2 < uri.size()
+                        && std::from_chars(uri.data() + i + 1, uri.data() + i + 3, c, 16).ptr == uri.data() + i + 3) {
+                        s += (char)c;
+                        i += 2;
+                    } else {
+                        s += uri[i];
+                    }
+                }
+                return s;
+            }
+
+            static int component_count(const std::string& type) {
+                if (type == "SCALAR") return 1;
+                if (type == "VEC2") return 2;
+                if (type == "VEC3") return 3;
+                if (type == "VEC4") return 4;
+                if (type == "MAT4") return 16;
+                return 0;
+            }
+
+            static size_t component_size(int component_type) {
+                switch (component_type) {
+                    case 5120: case 5121: return 1;
+                    case 5122: case 5123: return 2;
+                    case 5125: case 5126: return 4;
+                }
+                return 0;
+            }
+
+            static float read_component(const uint8_t* p, int component_type, bool normalized) {
+                switch (component_type) {
+                    case 5120: { int8_t v; std::memcpy(&v, p, 1); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+                    case 5121: return normalized ? *p / 255.0f : *p;
+                    case 5122: { int16_t v; std::memcpy(&v, p, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+                    case 5123: { uint16_t v; std::memcpy(&v, p, 2); return normalized ? v / 65535.0f : v; }
+                    case 5125: { uint32_t v; std::memcpy(&v, p, 4); return (float)v; }
+                    case 5126: { float v; std::memcpy(&v, p, 4); return v; }
+                }
+                return 0.0f;
+            }
+
+            // resolves an accessor to its first element and stride; false if it points outside its buffer
+            struct accessor_view {
+                const uint8_t* data = nullptr;
+                size_t count = 0, stride = 0;
+                int components = 0, component_type = 0;
+                bool normalized = false;
+            };
+
+            static bool view_accessor(const document& doc, size_t index, accessor_view& out) {
+                const json* accessors = doc.root.find("accessors");
+                const json* views = doc.root.find("bufferViews");
+                if (!accessors || index >= accessors->size()) {
+                    return false;
+                }
+                const json& a = accessors->array[index];
+                const json* type = a.find("type");
+                out.count = (size_t)a.num("count", 0);
+                out.component_type = (int)a.num("componentType", 0);
+                out.components = type ? component_count(type->string) : 0;
+                const json* normalized = a.find("normalized");
+                out.normalized = normalized && normalized->boolean;
+                size_t element = component_size(out.component_type) * out.components;
+                if (!element || a.find("sparse")) {
+                    LOG_WARN("Unsupported glTF accessor {}", index);
+                    return false;
+                }
+
+                const json* view_index = a.find("bufferView");
+                if (!view_index) {
+                    // no view means all zeros, a stride of 0 reads the same zeroed element every time
+                    static const uint8_t zeros[16 * 4] = {};
+                    out.data = zeros;
+                    out.stride = 0;
+                    return true;
+                }
+                if (!views || view_index->type != json::kind::number || view_index->number < 0.0 || view_index->number >= (double)views->size()) {
+                    return false;
+                }
+                const json& v = views->array[(size_t)view_index->number];
+                size_t buffer = (size_t)v.num("buffer", 0);
+                size_t offset = (size_t)v.num("byteOffset", 0) + (size_t)a.num("byteOffset", 0);
+                out.stride = (size_t)v.num("byteStride", (double)element);
+                if (buffer >= doc.buffers.size()) {
+                    return false;
+                }
+                const span& b = doc.buffers[buffer];
+                if (out.count && offset + (out.count - 1) * out.stride + element > b.size) {
+                    return false;
+                }
+                out.data = b.data + offset;
+                return true;
+            }
+
+            template<int N>
+            static bool read_vectors(const document& doc, const json& attributes, const char* name, std::vector<glm::vec<N, float>>& out, float fill) {
+                const json* index = attributes.find(name);
+                accessor_view view;
+                if (!index || !view_accessor(doc, (size_t)index->number, view)) {
+                    return false;
+                }
+                out.resize(view.count);
+                size_t size = component_size(view.component_type);
+                for (size_t i = 0; i < view.count; i++) {
+                    const uint8_t* p = view.data + i * view.stride;
+                    for (int c = 0; c < N; c++) {
+                        out[i][c] = c < view.components ? read_component(p + c * size, view.component_type, view.normalized) : fill;
+                    }
+                }
+                return true;
+            }
+
+            static glm::mat4 local_transform(const json& node) {
+                if (const json* m = node.find("matrix"); m && m->size() == 16) {
+                    glm::mat4 r;
+                    for (int i = 0; i < 16; i++) {
+                        r[i / 4][i % 4] = (float)m->array[i].number;
+                    }
+                    return r;
+                }
+                glm::vec3 t(0.0f), s(1.0f);
+                glm::quat q(1.0f, 0.0f, 0.0f, 0.0f);
+                if (const json* v = node.find("translation"); v && v->size() == 3) {
+                    t = { v->array[0].number, v->array[1].number, v->array[2].number };
+                }
+                if (const json* v = node.find("rotation"); v && v->size() == 4) {
+                    q = glm::quat((float)v->array[3].number, (float)v->array[0].number, (float)v->array[1].number, (float)v->array[2].number);
+                }
+                if (const json* v = node.find("scale"); v && v->size() == 3) {
+                    s = { v->array[0].number, v->array[1].number, v->array[2].number };
+                }
+                return glm::translate(glm::mat4(1.0f), t) * glm::mat4_cast(q) * glm::scale(glm::mat4(1.0f), s);
+            }
+
+            struct instance {
+                size_t mesh;
+                glm::mat4 transform;
+            };
+
+            static void collect_instances(const json& nodes, size_t index, const glm::mat4& parent, std::vector<instance>& out, int depth) {
+                if (index >= nodes.size() || depth > 64) {
+                    return;
+                }
+                const json& node = nodes.array[index];
+                glm::mat4 world = parent * local_transform(node);
+                if (const json* m = node.find("mesh")) {
+                    out.push_back({ (size_t)m->number, world });
+                }
+                if (const json* children = node.find("children")) {
+                    for (const json& c : children->array) {
+                        collect_instances(nodes, (size_t)c.number, world, out, depth + 1);
+                    }
+                }
+            }
+
+            static bool load_primitive(const document& doc, const json& primitive, const glm::mat4& transform, mesh_data& out) {
+                const json* attributes = primitive.find("attributes");
+                if (!attributes || primitive.num("mode", 4) != 4) {
+                    LOG_WARN("Skipping non-triangle glTF primitive");
+                    return false;
+                }
+                if (!read_vectors<3>(doc, *attributes, "POSITION", out.positions, 0.0f)) {
+                    return false;
+                }
+                size_t count = out.positions.size();
+                read_vectors<3>(doc, *attributes, "NORMAL", out.normals, 0.0f);
+                read_vectors<2>(doc, *attributes, "TEXCOORD_0", out.uvs, 0.0f);
+                read_vectors<4>(doc, *attributes, "TANGENT", out.tangents, 1.0f);
+                read_vectors<4>(doc, *attributes, "COLOR_0", out.colors, 1.0f);
+                // a short stream is as good as a missing one
+                if (out.normals.size() != count) out.normals.clear();
+                if (out.uvs.size() != count) out.uvs.clear();
+                if (out.tangents.size() != count) out.tangents.clear();
+                if (out.colors.size() != count) out.colors.clear();
+
+                if (const json* indices = primitive.find("indices")) {
+                    accessor_view view;
+                    if (!view_accessor(doc, (size_t)indices->number, view) || view.components != 1) {
+                        return false;
+                    }
+                    out.indices.resize(view.count);
+                    size_t size = component_size(view.component_type);
+                    for (size_t i = 0; i < view.count; i++) {
+                        uint32_t v = 0;
+                        std::memcpy(&v, view.data + i * view.stride, size);
+                        if (v >= count) {
+                            return false;
+                        }
+                        out.indices[i] = v;
+                    }
+                } else {
+                    out.indices.resize(count);
+                    for (size_t i = 0; i < count; i++) {
+                        out.indices[i] = (uint32_t)i;
+                    }
+                }
+
+                glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+                for (glm::vec3& p : out.positions) {
+                    p = glm::vec3(transform * glm::vec4(p, 1.0f));
+                }
+                // zero-filled accessors stay zero instead of normalizing into NaN
+                auto safe_normalize = [](const glm::vec3& v) {
+                    float length = glm::length(v);
+                    return length > 0.0f ? v / length : v;
+                };
+                for (glm::vec3& n : out.normals) {
+                    n = safe_normalize(normal_matrix * n);
+                }
+                // mirrored instances flip the winding and the handedness of the tangent frame
+                bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+                for (glm::vec4& t : out.tangents) {
+                    t = glm::vec4(safe_normalize(glm::mat3(transform) * glm::vec3(t)), mirrored ? -t.w : t.w);
+                }
+                if (mirrored) {
+                    for (size_t i = 0; i + 2 < out.indices.size(); i += 3) {
+                        std::swap(out.indices[i + 1], out.indices[i + 2]);
+                    }
+                }
+                return true;
+            }
+
+        }
+
+        static bool import_gltf(const char* path, model_data& out, bool binary) {
+            using namespace gltf_detail;
+
+            mapped_file file(path);
+            if (!file.valid()) {
+                return false;
+            }
+
+            document doc;
+            const char* json_begin = (const char*)file.data();
+            const char* json_end = json_begin + file.size();
+            span bin;
+            if (binary) {
+                // 12 byte header, then a JSON chunk and an optional BIN chunk
+                uint32_t header[3], chunk[2];
+                if (file.size() < 20) {
+                    LOG_ERROR("Truncated glb: {}", path);
+                    return false;
+                }
+                std::memcpy(header, file.data(), 12);
+                std::memcpy(chunk, file.data() + 12, 8);
+                if (header[0] != 0x46546c67 || header[1] != 2 || chunk[1] != 0x4e4f534a || 20 + (size_t)chunk[0] > file.size()) {
+                    LOG_ERROR("Not a glTF 2.0 binary: {}", path);
+                    return false;
+                }
+                json_begin = (const char*)file.data() + 20;
+                json_end = json_begin + chunk[0];
+                size_t bin_offset = 20 + (size_t)((chunk[0] + 3) & ~3u);
+                if (bin_offset + 8 <= file.size()) {
+                    std::memcpy(chunk, file.data() + bin_offset, 8);
+                    if (chunk[1] == 0x004e4942 && bin_offset + 8 + chunk[0] <= file.size()) {
+                        bin = { file.data() + bin_offset + 8, chunk[0] };
+                    }
+                }
+            }
+
+            json_parser parser = { json_begin, json_end };
+            doc.root = parser.parse_value();
+            if (parser.failed || doc.root.type != json::kind::object) {
+                LOG_ERROR("Failed to parse glTF json: {}", path);
+                return false;
+            }
+
+            std::string directory = path;
+            size_t slash = directory.find_last_of("/\\");
+            directory = slash == std::string::npos ? "" : directory.substr(0, slash + 1);
+
+            if (const json* buffers = doc.root.find("buffers")) {
+                for (const json& b : buffers->array) {
+                    const json* uri = b.find("uri");
+                    if (!uri) {
+                        doc.buffers.push_back(bin);
+                    } else if (uri->string.starts_with("data:")) {
+                        size_t comma = uri->string.find(',');
+                        doc.decoded.push_back(decode_base64(std::string_view(uri->string).substr(comma == std::string::npos ? 0 : comma + 1)));
+                        doc.buffers.push_back({ doc.decoded.back().data(), doc.decoded.back().size() });
+                    } else {
+                        doc.files.emplace_back((directory + decode_uri(uri->string)).c_str());
+                        if (!doc.files.back().valid()) {
+                            return false;
+                        }
+                        doc.buffers.push_back({ doc.files.back().data(), doc.files.back().size() });
+                    }
+                }
+            }
+
+            // every mesh reference in the default scene, or every mesh once if there is no scene
+            std::vector<instance> instances;
+            const json* nodes = doc.root.find("nodes");
+            const json* scenes = doc.root.find("scenes");
+            if (nodes && scenes && scenes->size()) {
+                const json& scene = scenes->array[std::min((size_t)doc.root.num("scene", 0), scenes->size() - 1)];
+                if (const json* roots = scene.find("nodes")) {
+                    for (const json& r : roots->array) {
+                        collect_instances(*nodes, (size_t)r.number, glm::mat4(1.0f), instances, 0);
+                    }
+                }
+            } else if (const json* meshes = doc.root.find("meshes")) {
+                for (size_t m = 0; m < meshes->size(); m++) {
+                    instances.push_back({ m, glm::mat4(1.0f) });
+                }
+            }
+
+            struct part {
+                const json* primitive;
+                glm::mat4 transform;
+                mesh_data mesh = {};
+                bool ok = false;
+            };
+            std::vector<part> parts;
+            const json* meshes = doc.root.find("meshes");
+            for (const instance& i : instances) {
+                const json* primitives = meshes && i.mesh < meshes->size() ? meshes->array[i.mesh].find("primitives") : nullptr;
+                if (primitives) {
+                    for (const json& p : primitives->array) {
+                        parts.push_back({ &p, i.transform });
+                    }
+                }
+            }
+
+            thread_pool::global().parallel_for(parts.size(), 1, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; i++) {
+                    parts[i].ok = load_primitive(doc, *parts[i].primitive, parts[i].transform, parts[i].mesh);
+                }
+            });
+
+            // optional streams survive only if every part has them
+            mesh_data& mesh = out.mesh;
+            mesh = {};
+            out.submeshes.clear();
+            bool normals = true, uvs = true, tangents = true, colors = true, any = false;
+            for (const part& p : parts) {
+                if (!p.ok) {
+                    continue;
+                }
+                any = true;
+                normals &= !p.mesh.normals.empty();
+                uvs &= !p.mesh.uvs.empty();
+                tangents &= !p.mesh.tangents.empty();
+                colors &= !p.mesh.colors.empty();
+            }
+            if (!any) {
+                LOG_ERROR("No loadable triangle meshes in: {}", path);
+                return false;
+            }
+            for (const part& p : parts) {
+                if (!p.ok) {
+                    continue;
+                }
+                uint32_t base = (uint32_t)mesh.positions.size();
+                out.submeshes.push_back({ (uint32_t)mesh.indices.size(), (uint32_t)p.mesh.indices.size() });
+                for (uint32_t i : p.mesh.indices) {
+                    mesh.indices.push_back(base + i);
+                }
+                mesh.positions.insert(mesh.positions.end(), p.mesh.positions.begin(), p.mesh.positions.end());
+                if (normals) mesh.normals.insert(mesh.normals.end(), p.mesh.normals.begin(), p.mesh.normals.end());
+                if (uvs) mesh.uvs.insert(mesh.uvs.end(), p.mesh.uvs.begin(), p.mesh.uvs.end());
+                if (tangents) mesh.tangents.insert(mesh.tangents.end(), p.mesh.tangents.begin(), p.mesh.tangents.end());
+                if (colors) mesh.colors.insert(mesh.colors.end(), p.mesh.colors.begin(), p.mesh.colors.end());
+            }
+            return true;
+        }
+
+        bool import_model(const char* path, model_data& out) {
+            std::string_view p = path;
+            auto ends_with = [&](std::string_view ext) {
+                return p.size() >= ext.size() && std::equal(ext.begin(), ext.end(), p.end() - ext.size(),
+                    [](char a, char b) { return a == (char)std::tolower((unsigned char)b); });
+            };
+            if (ends_with(".obj")) {
+                return import_obj(path, out);
+            }
+            if (ends_with(".gltf")) {
+                return import_gltf(path, out, false);
+            }
+            if (ends_with(".glb")) {
+                return import_gltf(path, out, true);
+            }
+            LOG_ERROR("Unknown model format: {}", path);
+            return false;
+        }
+
+        interleaved_mesh import_mesh(const char* path, const vertex_layout& layout, bool optimize) {
+            interleaved_mesh result;
+            model_data model;
+            if (!import_model(path, model)) {
+                return result;
+            }
+
+            mesh_data& mesh = model.mesh;
+            if (optimize) {
+                deduplicate_vertices(mesh);
+                // triangle order only moves within a submesh so the ranges stay valid
+                thread_pool::global().parallel_for(model.submeshes.size(), 1, [&](size_t b, size_t e) {
+                    for (size_t s = b; s < e; s++) {
+                        const submesh& sm = model.submeshes[s];
+                        std::vector<uint32_t> indices(mesh.indices.begin() + sm.first_index, mesh.indices.begin() + sm.first_index + sm.index_count);
+                        if (indices.empty()) {
+                            continue;
+                        }
+                        // the cache optimizer's per-vertex state only needs to span this submesh's vertices
+                        auto [lo, hi] = std::minmax_element(indices.begin(), indices.end());
+                        uint32_t first = *lo, range = *hi - *lo + 1;
+                        for (uint32_t& i : indices) {
+                            i -= first;
+                        }
+                        optimize_vertex_cache(indices, range);
+                        for (uint32_t& i : indices) {
+                            i += first;
+                        }
+                        optimize_overdraw(indices, mesh.positions);
+                        std::copy(indices.begin(), indices.end(), mesh.indices.begin() + sm.first_index);
+                    }
+                });
+                optimize_vertex_fetch(mesh);
+            }
+
+            result.vertices = layout.pack(mesh);
+            result.indices = pack_indices(mesh.indices, mesh.vertex_count());
+            result.submeshes = std::move(model.submeshes);
+            result.vertex_count = mesh.vertex_count();
+            return result;
+        }
+
+        // textures
+
+        struct texture2d::state {
+            enum class stage { decoding, decoded, ready, failed };
+
+            std::string path;
+            bool mips, srgb;
+            unsigned int id = 0;
+            int width = 0, height = 0;
+            stbi_uc* pixels = nullptr;
+            std::atomic<stage> current = stage::decoding;
+            // cleared when the texture2d goes away before its upload
+            std::atomic<bool> alive = true;
+
+            ~state() {
+                stbi_image_free(pixels);
+            }
+        };
+
+        namespace texture_detail {
+
+            struct region {
+                size_t begin, end;
+                GLsync fence;
+            };
+
+            // persistently mapped ring shared by every upload, retired by fences
+            struct staging_ring {
+                static constexpr size_t capacity = 64 << 20;
+
+                unsigned int pbo = 0;
+                unsigned char* mapped = nullptr;
+                size_t head = 0;
+                std::deque<region> in_flight;
+
+                void init() {
+                    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                    glCreateBuffers(1, &pbo);
+                    glNamedBufferStorage(pbo, capacity, nullptr, flags);
+                    mapped = (unsigned char*)glMapNamedBufferRange(pbo, 0, capacity, flags);
+                }
+
+                void retire() {
+                    while (!in_flight.empty()) {
+                        GLenum r = glClientWaitSync(in_flight.front().fence, 0, 0);
+                        if (r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED) {
+                            break;
+                        }
+                        glDeleteSync(in_flight.front().fence);
+                        in_flight.pop_front();
+                    }
+                }
+
+                bool allocate(size_t size, size_t& offset) {
+                    retire();
+                    size_t start = head + size > capacity ? 0 : head;
+                    for (const region& r : in_flight) {
+                        if (start < r.end && r.begin < start + size) {
+                            return false;
+                        }
+                    }
+                    offset = start;
+                    head = (start + size + 255) & ~size_t(255);
+                    return true;
+                }
+
+                void release() {
+                    for (region& r : in_flight) {
+                        glDeleteSync(r.fence);
+                    }
+                    in_flight.clear();
+                    if (pbo) {
+                        glUnmapNamedBuffer(pbo);
+                        glDeleteBuffers(1, &pbo);
+                    }
+                    pbo = 0;
+                    mapped = nullptr;
+                    head = 0;
+                }
+            };
+
+            static std::mutex decoded_mutex;
+            static std::deque<std::shared_ptr<texture2d::state>> decoded;
+            static staging_ring ring;
+            static unsigned int placeholder_id = 0;
+            static std::atomic<size_t> pending = 0;
+            static texture2d::stats frame_stats;
+
+            static unsigned int levels_for(int width, int height, bool mips) {
+                return mips ? (unsigned int)std::bit_width((unsigned int)std::max(width, height)) : 1;
+            }
+
+            static void allocate_storage(texture2d::state& s) {
+                glTextureStorage2D(s.id, levels_for(s.width, s.height, s.mips), s.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, s.width, s.height);
+                glTextureParameteri(s.id, GL_TEXTURE_MIN_FILTER, s.mips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                glTextureParameteri(s.id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTextureParameteri(s.id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                glTextureParameteri(s.id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            }
+
+        }
+
+        texture2d::texture2d(const char* path, bool mips, bool srgb) : _state(std::make_shared<state>()) {
+            _state->path = path;
+            _state->mips = mips;
+            _state->srgb = srgb;
+            glCreateTextures(GL_TEXTURE_2D, 1, &_state->id);
+            texture_detail::pending++;
+
+            thread_pool::global().submit([s = _state]() {
+                if (s->alive) {
+                    mapped_file file(s->path.c_str());
+                    if (file.valid()) {
+                        // gl expects the bottom row first
+                        stbi_set_flip_vertically_on_load_thread(1);
+                        int channels;
+                        s->pixels = stbi_load_from_memory(file.data(), (int)file.size(), &s->width, &s->height, &channels, 4);
+                        if (!s->pixels) {
+                            LOG_ERROR("Failed to decode texture {}: {}", s->path, stbi_failure_reason());
+                        }
+                    }
+                }
+                s->current = s->pixels ? state::stage::decoded : state::stage::failed;
+                std::lock_guard<std::mutex> lock(texture_detail::decoded_mutex);
+                texture_detail::decoded.push_back(s);
+            });
+        }
+
+        texture2d::texture2d(unsigned int width, unsigned int height, const void* rgba, bool mips, bool srgb) : _state(std::make_shared<state>()) {
+            state& s = *_state;
+            s.mips = mips;
+            s.srgb = srgb;
+            s.width = (int)width;
+            s.height = (int)height;
+            glCreateTextures(GL_TEXTURE_2D, 1, &s.id);
+            texture_detail::allocate_storage(s);
+            glTextureSubImage2D(s.id, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+            if (mips) {
+                glGenerateTextureMipmap(s.id);
+            }
+            s.current = state::stage::ready;
+        }
+
+        texture2d::~texture2d() {
+            // a decode still in flight finds alive == false and process_uploads drops it
+            _state->alive = false;
+            glDeleteTextures(1, &_state->id);
+        }
+
+        void texture2d::bind(unsigned int slot) const {
+            glBindTextureUnit(slot, id());
+        }
+
+        unsigned int texture2d::id() const {
+            return ready() ? _state->id : placeholder();
+        }
+
+        bool texture2d::ready() const {
+            return _state->current == state::stage::ready;
+        }
+
+        bool texture2d::failed() const {
+            return _state->current == state::stage::failed;
+        }
+
+        unsigned int texture2d::width() const {
+            return (unsigned int)_state->width;
+        }
+
+        unsigned int texture2d::height() const {
+            return (unsigned int)_state->height;
+        }
+
+        unsigned int texture2d::placeholder() {
+            using namespace texture_detail;
+            if (!placeholder_id) {
+                // 2x2 grey checker so pending textures read as "loading", not as black
+                const uint32_t pixels[4] = { 0xff808080, 0xffb0b0b0, 0xffb0b0b0, 0xff808080 };
+                glCreateTextures(GL_TEXTURE_2D, 1, &placeholder_id);
+                glTextureStorage2D(placeholder_id, 1, GL_RGBA8, 2, 2);
+                glTextureSubImage2D(placeholder_id, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+                glTextureParameteri(placeholder_id, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTextureParameteri(placeholder_id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            }
+            return placeholder_id;
+        }
+
+        void texture2d::process_uploads(size_t budget) {
+            using namespace texture_detail;
+            frame_stats.uploaded_bytes = 0;
+
+            while (true) {
+                std::shared_ptr<state> s;
+                {
+                    std::lock_guard<std::mutex> lock(decoded_mutex);
+                    if (decoded.empty()) {
+                        break;
+                    }
+                    s = decoded.front();
+                }
+
+                size_t bytes = (size_t)s->width * s->height * 4;
+                if (s->alive && s->current == state::stage::decoded) {
+                    // always let one through so a texture bigger than the budget still loads
+                    if (frame_stats.uploaded_bytes && frame_stats.uploaded_bytes + bytes > budget) {
+                        break;
+                    }
+
+                    // storage is immutable, so it is only allocated once the upload can go ahead
+                    if (bytes <= staging_ring::capacity) {
+                        if (!ring.pbo) {
+                            ring.init();
+                        }
+                        size_t offset;
+                        if (!ring.allocate(bytes, offset)) {
+                            // staging is still in use by earlier uploads, try next frame
+                            break;
+                        }
+                        allocate_storage(*s);
+                        std::memcpy(ring.mapped + offset, s->pixels, bytes);
+                        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.pbo);
+                        glTextureSubImage2D(s->id, 0, 0, 0, s->width, s->height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)offset);
+                        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                        ring.in_flight.push_back({ offset, offset + bytes, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+                    } else {
+                        allocate_storage(*s);
+                        glTextureSubImage2D(s->id, 0, 0, 0, s->width, s->height, GL_RGBA, GL_UNSIGNED_BYTE, s->pixels);
+                    }
+                    if (s->mips) {
+                        glGenerateTextureMipmap(s->id);
+                    }
+                    s->current = state::stage::ready;
+                    frame_stats.uploaded_bytes += bytes;
+                }
+
+                stbi_image_free(s->pixels);
+                s->pixels = nullptr;
+                pending--;
+                std::lock_guard<std::mutex> lock(decoded_mutex);
+                decoded.pop_front();
+            }
+
+            frame_stats.pending = pending;
+        }
+
+        const texture2d::stats& texture2d::statistics() {
+            return texture_detail::frame_stats;
+        }
+
+        void texture2d::shutdown() {
+            using namespace texture_detail;
+            {
+                std::lock_guard<std::mutex> lock(decoded_mutex);
+                decoded.clear();
+            }
+            ring.release();
+            if (placeholder_id) {
+                glDeleteTextures(1, &placeholder_id);
+                placeholder_id = 0;
+            }
+        }
+
+        // block compression
+
+        namespace bc_detail {
+
+            constexpr uint32_t container_magic = 0x5845544f;   // "OTEX"
+            constexpr uint32_t container_version = 1;
+
+            struct container_header {
+                uint32_t magic, version, format, levels;
+            };
+
+            struct container_level {
+                uint64_t offset, size;
+                uint32_t width, height;
+                uint32_t padding[2];
+            };
+
+            using block = std::array<glm::vec4, 16>;
+
+            // principal axis of the block by power iteration, falls back to the diagonal
+            template<int N>
+            static glm::vec<N, float> principal_axis(const glm::vec<N, float>* px, const glm::vec<N, float>& mean) {
+                float cov[N][N] = {};
+                for (int i = 0; i < 16; i++) {
+                    glm::vec<N, float> d = px[i] - mean;
+                    for (int a = 0; a < N; a++) {
+                        for (int b = 0; b < N; b++) {
+                            cov[a][b] += d[a] * d[b];
+                        }
+                    }
+                }
+                glm::vec<N, float> axis(1.0f);
+                for (int it = 0; it < 8; it++) {
+                    glm::vec<N, float> next(0.0f);
+                    for (int a = 0; a < N; a++) {
+                        for (int b = 0; b < N; b++) {
+                            next[a] += cov[a][b] * axis[b];
+                        }
+                    }
+                    float len = glm::length(next);
+                    if (len < 1e-6f) {
+                        return glm::normalize(glm::vec<N, float>(1.0f));
+                    }
+                    axis = next / len;
+                }
+                return axis;
+            }
+
+            // endpoints spanning the projections of the block on its principal axis
+            template<int N>
+            static void fit_endpoints(const glm::vec<N, float>* px, glm::vec<N, float>& a, glm::vec<N, float>& b) {
+                glm::vec<N, float> mean(0.0f);
+                for (int i = 0; i < 16; i++) {
+                    mean += px[i];
+                }
+                mean /= 16.0f;
+                glm::vec<N, float> axis = principal_axis<N>(px, mean);
+                float lo = std::numeric_limits<float>::max(), hi = std::numeric_limits<float>::lowest();
+                for (int i = 0; i < 16; i++) {
+                    float t = glm::dot(px[i] - mean, axis);
+                    lo = std::min(lo, t);
+                    hi = std::max(hi, t);
+                }
+                a = mean + axis * hi;
+                b = mean + axis * lo;
+            }
+
+            // least squares endpoints for fixed interpolation weights, one step of cluster fit
+            template<int N>
+            static bool refine_endpoints(const glm::vec<N, float>* px, const float* weights, glm::vec<N, float>& a, glm::vec<N, float>& b) {
+                float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+                glm::vec<N, float> ax(0.0f), bx(0.0f);
+                for (int i = 0; i < 16; i++) {
+                    float w = weights[i];
+                    aa += (1.0f - w) * (1.0f - w);
+                    bb += w * w;
+                    ab += w * (1.0f - w);
+                    ax += px[i] * (1.0f - w);
+                    bx += px[i] * w;
+                }
+                float det = aa * bb - ab * ab;
+                if (std::abs(det) < 1e-6f) {
+                    return false;
+                }
+                a = glm::clamp((ax * bb - bx * ab) / det, 0.0f, 255.0f);
+                b = glm::clamp((bx * aa - ax * ab) / det, 0.0f, 255.0f);
+                return true;
+            }
+
+            static uint16_t pack565(const glm::vec3& c) {
+                glm::vec3 q = glm::round(glm::clamp(c, 0.0f, 255.0f) * glm::vec3(31.0f, 63.0f, 31.0f) / 255.0f);
+                return (uint16_t)(((int)q.r << 11) | ((int)q.g << 5) | (int)q.b);
+            }
+
+            static glm::vec3 unpack565(uint16_t c) {
+                int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+                return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+            }
+
+            static float distance2(const glm::vec3& a, const glm::vec3& b) {
+                glm::vec3 d = a - b;
+                return glm::dot(d, d);
+            }
+
+            // returns the squared error, indices are written to `bits`
+            static float bc1_indices(const glm::vec3* px, const bool* transparent, uint16_t c0, uint16_t c1, uint32_t& bits, float* weights) {
+                glm::vec3 e0 = unpack565(c0), e1 = unpack565(c1);
+                glm::vec3 palette[4];
+                float palette_w[4];
+                bool three = c0 <= c1;
+                palette[0] = e0; palette_w[0] = 0.0f;
+                palette[1] = e1; palette_w[1] = 1.0f;
+                if (three) {
+                    palette[2] = (e0 + e1) * 0.5f; palette_w[2] = 0.5f;
+                    palette[3] = glm::vec3(0.0f); palette_w[3] = 0.0f;
+                } else {
+                    palette[2] = (e0 * 2.0f + e1) / 3.0f; palette_w[2] = 1.0f / 3.0f;
+                    palette[3] = (e0 + e1 * 2.0f) / 3.0f; palette_w[3] = 2.0f / 3.0f;
+                }
+
+                float error = 0.0f;
+                bits = 0;
+                for (int i = 0; i < 16; i++) {
+                    uint32_t best = 0;
+                    if (transparent && transparent[i]) {
+                        best = 3;
+                    } else {
+                        float best_d = std::numeric_limits<float>::max();
+                        for (uint32_t k = 0; k < (three ? 3u : 4u); k++) {
+                            float d = distance2(px[i], palette[k]);
+                            if (d < best_d) {
+                                best_d = d;
+                                best = k;
+                            }
+                        }
+                        error += best_d;
+                    }
+                    weights[i] = palette_w[best];
+                    bits |= best << (i * 2);
+                }
+                return error;
+            }
+
+            static void encode_bc1(const block& b, uint8_t* out, bool allow_alpha) {
+                glm::vec3 px[16];
+                bool transparent[16];
+                bool any_transparent = false;
+                for (int i = 0; i < 16; i++) {
+                    px[i] = glm::vec3(b[i]);
+                    transparent[i] = allow_alpha && b[i].a < 128.0f;
+                    any_transparent |= transparent[i];
+                }
+
+                // only the opaque pixels shape the endpoints
+                glm::vec3 fit[16];
+                int opaque = 0;
+                for (int i = 0; i < 16; i++) {
+                    if (!transparent[i]) {
+                        fit[opaque++] = px[i];
+                    }
+                }
+                for (int i = opaque; i < 16; i++) {
+                    fit[i] = opaque ? fit[i % opaque] : glm::vec3(0.0f);
+                }
+
+                glm::vec3 a, c;
+                fit_endpoints<3>(fit, a, c);
+                uint16_t c0 = pack565(a), c1 = pack565(c);
+
+                // four colors wants c0 > c1, three colors plus transparent wants c0 <= c1
+                auto order = [&](uint16_t& x, uint16_t& y) {
+                    if (any_transparent ? x > y : x < y) {
+                        std::swap(x, y);
+                    }
+                };
+                order(c0, c1);
+
+                uint32_t bits;
+                float weights[16];
+                float error = bc1_indices(px, transparent, c0, c1, bits, weights);
+
+                glm::vec3 ra, rc;
+                if (!any_transparent && c0 != c1 && refine_endpoints<3>(px, weights, ra, rc)) {
+                    uint16_t r0 = pack565(ra), r1 = pack565(rc);
+                    order(r0, r1);
+                    uint32_t refined_bits;
+                    float refined_weights[16];
+                    if (r0 != r1) {
+                        float refined = bc1_indices(px, nullptr, r0, r1, refined_bits, refined_weights);
+                        if (refined < error) {
+                            c0 = r0; c1 = r1; bits = refined_bits;
+                        }
+                    }
+                }
+                if (!any_transparent && c0 == c1) {
+                    // a flat block would otherwise decode in three color mode, index 0 reads the same
+                    bits = 0;
+                }
+
+                std::memcpy(out, &c0, 2);
+                std::memcpy(out + 2, &c1, 2);
+                std::memcpy(out + 4, &bits, 4);
+            }
+
+            static void encode_bc4(const float* values, uint8_t* out) {
+                float lo = 255.0f, hi = 0.0f;
+                for (int i = 0; i < 16; i++) {
+                    lo = std::min(lo, values[i]);
+                    hi = std::max(hi, values[i]);
+                }
+                int e0 = (int)std::round(hi), e1 = (int)std::round(lo);
+                out[0] = (uint8_t)e0;
+                out[1] = (uint8_t)e1;
+
+                // e0 > e1: index 0 and 1 are the endpoints, 2..7 step from e0 towards e1
+                uint64_t bits = 0;
+                if (e0 > e1) {
+                    float palette[8] = { (float)e0, (float)e1 };
+                    for (int k = 1; k < 7; k++) {
+                        palette[k + 1] = ((7 - k) * e0 + k * e1) / 7.0f;
+                    }
+                    for (int i = 0; i < 16; i++) {
+                        uint64_t best = 0;
+                        float best_d = std::numeric_limits<float>::max();
+                        for (uint64_t k = 0; k < 8; k++) {
+                            float d = std::abs(values[i] - palette[k]);
+                            if (d < best_d) {
+                                best_d = d;
+                                best = k;
+                            }
+                        }
+                        bits |= best << (i * 3);
+                    }
+                }
+                for (int i = 0; i < 6; i++) {
+                    out[2 + i] = (uint8_t)(bits >> (i * 8));
+                }
+            }
+
+            // bc7 mode 6: one subset, rgba 7.7.7.7 endpoints each with a p-bit, 4 bit indices
+            static void encode_bc7(const block& b, uint8_t* out) {
+                static constexpr int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+                // best 7 bit + p-bit representation of an endpoint
+                auto quantize = [](const glm::vec4& e, glm::ivec4& q, int& p) {
+                    float best = std::numeric_limits<float>::max();
+                    for (int bit = 0; bit < 2; bit++) {
+                        glm::ivec4 candidate = glm::clamp(glm::ivec4(glm::round((glm::clamp(e, 0.0f, 255.0f) - (float)bit) / 2.0f)), 0, 127);
+                        glm::vec4 d = glm::vec4(candidate * 2 + bit) - e;
+                        float err = glm::dot(d, d);
+                        if (err < best) {
+                            best = err;
+                            q = candidate;
+                            p = bit;
+                        }
+                    }
+                };
+
+                auto evaluate = [&](const glm::vec4& a, const glm::vec4& c, glm::ivec4 q[2], int p[2], int idx[16], float w[16]) {
+                    quantize(a, q[0], p[0]);
+                    quantize(c, q[1], p[1]);
+                    glm::ivec4 e0 = q[0] * 2 + p[0], e1 = q[1] * 2 + p[1];
+                    glm::vec4 palette[16];
+                    for (int k = 0; k < 16; k++) {
+                        palette[k] = glm::vec4((e0 * (64 - weights[k]) + e1 * weights[k] + 32) / 64);
+                    }
+                    float error = 0.0f;
+                    for (int i = 0; i < 16; i++) {
+                        float best_d = std::numeric_limits<float>::max();
+                        for (int k = 0; k < 16; k++) {
+                            glm::vec4 d = b[i] - palette[k];
+                            float dd = glm::dot(d, d);
+                            if (dd < best_d) {
+                                best_d = dd;
+                                idx[i] = k;
+                            }
+                        }
+                        w[i] = weights[idx[i]] / 64.0f;
+                        error += best_d;
+                    }
+                    return error;
+                };
+
+                glm::vec4 a, c;
+                fit_endpoints<4>(b.data(), a, c);
+                glm::ivec4 q[2];
+                int p[2], idx[16];
+                float w[16];
+                float error = evaluate(a, c, q, p, idx, w);
+
+                glm::vec4 ra, rc;
+                if (refine_endpoints<4>(b.data(), w, ra, rc)) {
+                    glm::ivec4 rq[2];
+                    int rp[2], ridx[16];
+                    float rw[16];
+                    if (evaluate(ra, rc, rq, rp, ridx, rw) < error) {
+                        std::copy(rq, rq + 2, q);
+                        std::copy(rp, rp + 2, p);
+                        std::copy(ridx, ridx + 16, idx);
+                    }
+                }
+
+                // the anchor index has an implicit zero msb, swap the endpoints to get it
+                if (idx[0] >= 8) {
+                    std::swap(q[0], q[1]);
+                    std::swap(p[0], p[1]);
+                    for (int& i : idx) {
+                        i = 15 - i;
+                    }
+                }
+
+                uint64_t lo = 1ull << 6, hi = 0;
+                int pos = 7;
+                auto put = [&](uint64_t value, int count) {
+                    for (int i = 0; i < count; i++, pos++) {
+                        uint64_t bit = (value >> i) & 1;
+                        if (pos < 64) {
+                            lo |= bit << pos;
+                        } else {
+                            hi |= bit << (pos - 64);
+                        }
+                    }
+                };
+                for (int channel = 0; channel < 4; channel++) {
+                    put((uint64_t)q[0][channel], 7);
+                    put((uint64_t)q[1][channel], 7);
+                }
+                put((uint64_t)p[0], 1);
+                put((uint64_t)p[1], 1);
+                put((uint64_t)idx[0], 3);
+                for (int i = 1; i < 16; i++) {
+                    put((uint64_t)idx[i], 4);
+                }
+                std::memcpy(out, &lo, 8);
+                std::memcpy(out + 8, &hi, 8);
+            }
+
+            static void encode_block(const block& b, block_format format, uint8_t* out) {
+                float channel[16];
+                switch (format) {
+                    case block_format::bc1:
+                        encode_bc1(b, out, true);
+                        break;
+                    case block_format::bc3:
+                        for (int i = 0; i < 16; i++) channel[i] = b[i].a;
+                        encode_bc4(channel, out);
+                        encode_bc1(b, out + 8, false);
+                        break;
+                    case block_format::bc4:
+                        for (int i = 0; i < 16; i++) channel[i] = b[i].r;
+                        encode_bc4(channel, out);
+                        break;
+                    case block_format::bc5:
+                        for (int i = 0; i < 16; i++) channel[i] = b[i].r;
+                        encode_bc4(channel, out);
+                        for (int i = 0; i < 16; i++) channel[i] = b[i].g;
+                        encode_bc4(channel, out + 8);
+                        break;
+                    case block_format::bc7:
+                        encode_bc7(b, out);
+                        break;
+                }
+            }
+
+        }
+
+        size_t block_bytes(block_format format) {
+            return format == block_format::bc1 || format == block_format::bc4 ? 8 : 16;
+        }
+
+        GLenum gl_format(block_format format, bool srgb) {
+            switch (format) {
+                case block_format::bc1: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+                case block_format::bc3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                case block_format::bc4: return GL_COMPRESSED_RED_RGTC1;
+                case block_format::bc5: return GL_COMPRESSED_RG_RGTC2;
+                case block_format::bc7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+            }
+            return 0;
+        }
+
+        std::vector<uint8_t> compress_blocks(const uint8_t* rgba, unsigned int width, unsigned int height, block_format format) {
+            unsigned int bw = (width + 3) / 4, bh = (height + 3) / 4;
+            size_t bytes = block_bytes(format);
+            std::vector<uint8_t> out((size_t)bw * bh * bytes);
+
+            thread_pool::global().parallel_for(bh, 1, [&](size_t begin, size_t end) {
+                bc_detail::block b;
+                for (size_t by = begin; by < end; by++) {
+                    for (unsigned int bx = 0; bx < bw; bx++) {
+                        for (unsigned int i = 0; i < 16; i++) {
+                            size_t x = std::min(bx * 4 + (i & 3), width - 1), y = std::min((unsigned int)by * 4 + (i >> 2), height - 1);
+                            const uint8_t* p = rgba + (y * width + x) * 4;
+                            b[i] = glm::vec4(p[0], p[1], p[2], p[3]);
+                        }
+                        bc_detail::encode_block(b, format, out.data() + (by * bw + bx) * bytes);
+                    }
+                }
+            });
+            return out;
+        }
+
+        bool cook_texture(const char* source, const char* destination, block_format format, bool srgb, bool mips) {
+            using namespace bc_detail;
+
+            mapped_file file(source);
+            if (!file.valid()) {
+                return false;
+            }
+            int width, height, channels;
+            stbi_set_flip_vertically_on_load_thread(1);
+            stbi_uc* pixels = stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &channels, 4);
+            if (!pixels) {
+                LOG_ERROR("Failed to decode texture {}: {}", source, stbi_failure_reason());
+                return false;
+            }
+            image source_image = { (unsigned int)width, (unsigned int)height, std::vector<uint8_t>(pixels, pixels + (size_t)width * height * 4) };
+            stbi_image_free(pixels);
+
+            std::vector<image> levels = mips ? generate_mips(source_image, image_filter::box, srgb) : std::vector<image>{ std::move(source_image) };
+            std::vector<std::vector<uint8_t>> payloads;
+            std::vector<container_level> table;
+            for (const image& level : levels) {
+                payloads.push_back(compress_blocks(level.pixels.data(), level.width, level.height, format));
+                table.push_back({ 0, payloads.back().size(), level.width, level.height, {} });
+            }
+
+            container_header header = { container_magic, container_version, gl_format(format, srgb), (uint32_t)table.size() };
+            uint64_t offset = (sizeof(header) + table.size() * sizeof(container_level) + 15) & ~15ull;
+            for (container_level& l : table) {
+                l.offset = offset;
+                offset = (offset + l.size + 15) & ~15ull;
+            }
+
+            std::ofstream out(destination, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                LOG_ERROR("Failed to open file: {}", destination);
+                return false;
+            }
+            out.write((const char*)&header, sizeof(header));
+            out.write((const char*)table.data(), table.size() * sizeof(container_level));
+            static const char zeros[16] = {};
+            for (size_t i = 0; i < table.size(); i++) {
+                out.write(zeros, table[i].offset - (uint64_t)out.tellp());
+                out.write((const char*)payloads[i].data(), payloads[i].size());
+            }
+            if (!out) {
+                LOG_ERROR("Failed to write file: {}", destination);
+                return false;
+            }
+            return true;
+        }
+
+        cooked_texture::cooked_texture(const char* path) : _file(path) {
+            using namespace bc_detail;
+
+            if (!_file.valid()) {
+                return;
+            }
+            container_header header;
+            if (_file.size() < sizeof(header)) {
+                LOG_ERROR("Not a cooked texture: {}", path);
+                return;
+            }
+            std::memcpy(&header, _file.data(), sizeof(header));
+            if (header.magic != container_magic || header.version != container_version
+                || sizeof(header) + (size_t)header.levels * sizeof(container_level) > _file.size()) {
+                LOG_ERROR("Not a cooked texture: {}", path);
+                return;
+            }
+
+            _format = header.format;
+            for (uint32_t i = 0; i < header.levels; i++) {
+                container_level l;
+                std::memcpy(&l, _file.data() + sizeof(header) + i * sizeof(container_level), sizeof(l));
+                if (l.offset + l.size > _file.size()) {
+                    LOG_ERROR("Truncated cooked texture: {}", path);
+                    _levels.clear();
+                    return;
+                }
+                _levels.push_back({ l.width, l.height, _file.data() + l.offset, (size_t)l.size });
+            }
+        }
+
+        unsigned int cooked_texture::upload() const {
+            if (!valid()) {
+                return 0;
+            }
+            unsigned int id;
+            glCreateTextures(GL_TEXTURE_2D, 1, &id);
+            glTextureStorage2D(id, (GLsizei)_levels.size(), _format, _levels[0].width, _levels[0].height);
+            for (size_t i = 0; i < _levels.size(); i++) {
+                const level& l = _levels[i];
+                glCompressedTextureSubImage2D(id, (GLint)i, 0, 0, l.width, l.height, _format, (GLsizei)l.size, l.data);
+            }
+            glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, _levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            return id;
+        }
+
+        // image kernels
+
+        namespace image_detail {
+
+            // 0..255: srgb to linear, 256..511: plain unorm for alpha
+            struct decode_table {
+                float values[512];
+
+                decode_table() {
+                    for (int i = 0; i < 256; i++) {
+                        float c = i / 255.0f;
+                        values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                        values[256 + i] = c;
+                    }
+                }
+            };
+
+            // linear to srgb8 as a piecewise linear curve over 8 segments per octave from 2^-13 to 1,
+            // indexed straight from the float bits
+            struct encode_table {
+                static constexpr uint32_t min_bits = 114u << 23;   // 2^-13
+                static constexpr uint32_t max_bits = 0x3f7fffff;   // just below 1
+                float base[104], slope[104];
+
+                encode_table() {
+                    auto srgb = [](double c) { return c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055; };
+                    for (uint32_t i = 0; i < 104; i++) {
+                        double x0 = std::bit_cast<float>(min_bits + (i << 20));
+                        double x1 = std::bit_cast<float>(min_bits + ((i + 1) << 20));
+                        // fit through the segment's midpoint too, it halves the worst error of the chord
+                        double y0 = srgb(x0) * 255.0, y1 = srgb(x1) * 255.0, ym = srgb((x0 + x1) * 0.5) * 255.0;
+                        double bias = (ym - (y0 + y1) * 0.5) * 0.5;
+                        base[i] = (float)(y0 + bias + 0.5);
+                        slope[i] = (float)(y1 - y0);
+                    }
+                }
+            };
+
+            static const decode_table& decoder() {
+                static decode_table table;
+                return table;
+            }
+
+            static const encode_table& encoder() {
+                static encode_table table;
+                return table;
+            }
+
+            // max(lo, c) before min(c, hi): a NaN falls out of the first comparison as lo, where
+            // std::clamp would pass it through and index past the table
+            static inline uint8_t encode_srgb(float c, const encode_table& t) {
+                float lo = std::bit_cast<float>(encode_table::min_bits), hi = std::bit_cast<float>(encode_table::max_bits);
+                uint32_t bits = std::bit_cast<uint32_t>(std::min(std::max(lo, c), hi));
+                uint32_t i = (bits - encode_table::min_bits) >> 20;
+                float frac = (float)(bits & 0xfffff) * (1.0f / (1 << 20));
+                return (uint8_t)(t.base[i] + t.slope[i] * frac);
+            }
+
+            static inline uint8_t encode_unorm(float c) {
+                return (uint8_t)(std::min(std::max(0.0f, c), 1.0f) * 255.0f + 0.5f);
+            }
+
+            static inline uint8_t mul_div255(uint32_t c, uint32_t a) {
+                uint32_t t = c * a + 128;
+                return (uint8_t)((t + (t >> 8)) >> 8);
+            }
+
+            struct filter_taps {
+                int width;                    // taps per output, zero weights pad
+                std::vector<int> index;
+                std::vector<float> weight;
+            };
+
+            static float filter_kernel(image_filter filter, float t) {
+                t = std::abs(t);
+                switch (filter) {
+                    case image_filter::box:
+                        return t <= 0.5f ? 1.0f : 0.0f;
+                    case image_filter::triangle:
+                        return std::max(0.0f, 1.0f - t);
+                    case image_filter::kaiser: {
+                        // sinc windowed by kaiser(alpha = 4) over three lobes
+                        constexpr float radius = 3.0f, alpha = 4.0f;
+                        if (t >= radius) {
+                            return 0.0f;
+                        }
+                        auto bessel_i0 = [](float x) {
+                            float sum = 1.0f, term = 1.0f;
+                            for (int k = 1; k < 20; k++) {
+                                term *= (x / (2.0f * k)) * (x / (2.0f * k));
+                                sum += term;
+                            }
+                            return sum;
+                        };
+                        float r = t / radius;
+                        float sinc = t < 1e-5f ? 1.0f : std::sin(glm::pi<float>() * t) / (glm::pi<float>() * t);
+                        return sinc * bessel_i0(alpha * std::sqrt(1.0f - r * r)) / bessel_i0(alpha);
+                    }
+                }
+                return 0.0f;
+            }
+
+            static float filter_radius(image_filter filter) {
+                return filter == image_filter::box ? 0.5f : filter == image_filter::triangle ? 1.0f : 3.0f;
+            }
+
+            static filter_taps build_taps(unsigned int in, unsigned int out, image_filter filter) {
+                float scale = (float)in / out;
+                float stretch = std::max(scale, 1.0f);
+                float support = filter_radius(filter) * stretch;
+
+                filter_taps taps;
+                taps.width = (int)std::ceil(support * 2.0f) + 1;
+                taps.index.assign((size_t)out * taps.width, 0);
+                taps.weight.assign((size_t)out * taps.width, 0.0f);
+                for (unsigned int i = 0; i < out; i++) {
+                    float center = (i + 0.5f) * scale - 0.5f;
+                    int first = (int)std::ceil(center - support - 1e-4f);
+                    float total = 0.0f;
+                    for (int k = 0; k < taps.width; k++) {
+                        float w = filter_kernel(filter, (first + k - center) / stretch);
+                        taps.index[i * taps.width + k] = std::clamp(first + k, 0, (int)in - 1);
+                        taps.weight[i * taps.width + k] = w;
+                        total += w;
+                    }
+                    for (int k = 0; k < taps.width; k++) {
+                        taps.weight[i * taps.width + k] = total != 0.0f ? taps.weight[i * taps.width + k] / total : (k == 0 ? 1.0f : 0.0f);
+                    }
+                }
+                return taps;
+            }
+
+            // float rgba in, float rgba out, horizontal then vertical
+            static std::vector<float> resample(const std::vector<float>& src, unsigned int sw, unsigned int sh, unsigned int dw, unsigned int dh, image_filter filter) {
+                filter_taps h = build_taps(sw, dw, filter), v = build_taps(sh, dh, filter);
+                std::vector<float> tmp((size_t)dw * sh * 4), dst((size_t)dw * dh * 4);
+                thread_pool& pool = thread_pool::global();
+
+                pool.parallel_for(sh, 8, [&](size_t begin, size_t end) {
+                    for (size_t y = begin; y < end; y++) {
+                        const float* row = src.data() + y * sw * 4;
+                        float* out = tmp.data() + y * dw * 4;
+                        for (unsigned int x = 0; x < dw; x++) {
+                            const int* index = h.index.data() + (size_t)x * h.width;
+                            const float* weight = h.weight.data() + (size_t)x * h.width;
+        #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+                            // one rgba pixel per register
+                            __m128 acc = _mm_setzero_ps();
+                            for (int k = 0; k < h.width; k++) {
+                                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(row + index[k] * 4)));
+                            }
+                            _mm_storeu_ps(out + x * 4, acc);
+        #else
+                            glm::vec4 acc(0.0f);
+                            for (int k = 0; k < h.width; k++) {
+                                acc += weight[k] * glm::vec4(row[index[k] * 4], row[index[k] * 4 + 1], row[index[k] * 4 + 2], row[index[k] * 4 + 3]);
+                            }
+                            std::memcpy(out + x * 4, &acc, 16);
+        #endif
+                        }
+                    }
+                });
+
+                size_t row_floats = (size_t)dw * 4;
+                pool.parallel_for(dh, 8, [&](size_t begin, size_t end) {
+                    for (size_t y = begin; y < end; y++) {
+                        const int* index = v.index.data() + y * v.width;
+                        const float* weight = v.weight.data() + y * v.width;
+                        float* out = dst.data() + y * row_floats;
+                        size_t i = 0;
+        #if defined(__AVX2__)
+                        for (; i + 8 <= row_floats; i += 8) {
+                            __m256 acc = _mm256_setzero_ps();
+                            for (int k = 0; k < v.width; k++) {
+                                acc = OGE_FMADD256(_mm256_set1_ps(weight[k]), _mm256_loadu_ps(tmp.data() + index[k] * row_floats + i), acc);
+                            }
+                            _mm256_storeu_ps(out + i, acc);
+                        }
+        #endif
+        #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+                        for (; i + 4 <= row_floats; i += 4) {
+                            __m128 acc = _mm_setzero_ps();
+                            for (int k = 0; k < v.width; k++) {
+                                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(tmp.data() + index[k] * row_floats + i)));
+                            }
+                            _mm_storeu_ps(out + i, acc);
+                        }
+        #endif
+                        for (; i < row_floats; i++) {
+                            float acc = 0.0f;
+                            for (int k = 0; k < v.width; k++) {
+                                acc += weight[k] * tmp[index[k] * row_floats + i];
+                            }
+                            out[i] = acc;
+                        }
+                    }
+                });
+                return dst;
+            }
+
+            static std::vector<float> decode(const image& src, bool srgb) {
+                std::vector<float> out((size_t)src.width * src.height * 4);
+                size_t pixels = (size_t)src.width * src.height;
+                thread_pool::global().parallel_for(pixels, 1 << 16, [&](size_t begin, size_t end) {
+                    if (srgb) {
+                        srgb_to_linear(src.pixels.data() + begin * 4, out.data() + begin * 4, end - begin);
+                    } else {
+                        for (size_t i = begin * 4; i < end * 4; i++) {
+                            out[i] = src.pixels[i] / 255.0f;
+                        }
+                    }
+                });
+                return out;
+            }
+
+            static image encode(const std::vector<float>& src, unsigned int width, unsigned int height, bool srgb) {
+                image out = { width, height, std::vector<uint8_t>((size_t)width * height * 4) };
+                size_t pixels = (size_t)width * height;
+                thread_pool::global().parallel_for(pixels, 1 << 16, [&](size_t begin, size_t end) {
+                    if (srgb) {
+                        linear_to_srgb(src.data() + begin * 4, out.pixels.data() + begin * 4, end - begin);
+                    } else {
+                        for (size_t i = begin * 4; i < end * 4; i++) {
+                            out.pixels[i] = encode_unorm(src[i]);
+                        }
+                    }
+                });
+                return out;
+            }
+
+        }
+
+        namespace scalar {
+
+            void srgb_to_linear(const uint8_t* src, float* dst, size_t pixels) {
+                const float* table = image_detail::decoder().values;
+                for (size_t i = 0; i < pixels * 4; i += 4) {
+                    dst[i] = table[src[i]];
+                    dst[i + 1] = table[src[i + 1]];
+                    dst[i + 2] = table[src[i + 2]];
+                    dst[i + 3] = table[256 + src[i + 3]];
+                }
+            }
+
+            void linear_to_srgb(const float* src, uint8_t* dst, size_t pixels) {
+                const image_detail::encode_table& table = image_detail::encoder();
+                for (size_t i = 0; i < pixels * 4; i += 4) {
+                    dst[i] = image_detail::encode_srgb(src[i], table);
+                    dst[i + 1] = image_detail::encode_srgb(src[i + 1], table);
+                    dst[i + 2] = image_detail::encode_srgb(src[i + 2], table);
+                    dst[i + 3] = image_detail::encode_unorm(src[i + 3]);
+                }
+            }
+
+            void premultiply_alpha(uint8_t* rgba, size_t pixels) {
+                for (size_t i = 0; i < pixels * 4; i += 4) {
+                    uint8_t a = rgba[i + 3];
+                    rgba[i] = image_detail::mul_div255(rgba[i], a);
+                    rgba[i + 1] = image_detail::mul_div255(rgba[i + 1], a);
+                    rgba[i + 2] = image_detail::mul_div255(rgba[i + 2], a);
+                }
+            }
+
+            void swizzle(uint8_t* rgba, size_t pixels, const std::array<uint8_t, 4>& order) {
+                for (size_t i = 0; i < pixels * 4; i += 4) {
+                    uint8_t p[4] = { rgba[i], rgba[i + 1], rgba[i + 2], rgba[i + 3] };
+                    rgba[i] = p[order[0]];
+                    rgba[i + 1] = p[order[1]];
+                    rgba[i + 2] = p[order[2]];
+                    rgba[i + 3] = p[order[3]];
+                }
+            }
+
+        }
+
+        void srgb_to_linear(const uint8_t* src, float* dst, size_t pixels) {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            // two pixels per gather, alpha lanes index the unorm half of the table
+            const float* table = image_detail::decoder().values;
+            __m256i alpha = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+            for (; i + 2 <= pixels; i += 2) {
+                __m256i index = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i * 4))), alpha);
+                _mm256_storeu_ps(dst + i * 4, _mm256_i32gather_ps(table, index, 4));
+            }
+        #endif
+            scalar::srgb_to_linear(src + i * 4, dst + i * 4, pixels - i);
+        }
+
+        void linear_to_srgb(const float* src, uint8_t* dst, size_t pixels) {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            const image_detail::encode_table& table = image_detail::encoder();
+            __m256 lo = _mm256_set1_ps(std::bit_cast<float>(image_detail::encode_table::min_bits));
+            __m256 hi = _mm256_set1_ps(std::bit_cast<float>(image_detail::encode_table::max_bits));
+            __m256i min_bits = _mm256_set1_epi32((int)image_detail::encode_table::min_bits);
+            __m256i mantissa = _mm256_set1_epi32(0xfffff);
+            __m256 frac_scale = _mm256_set1_ps(1.0f / (1 << 20));
+            __m256 alpha_mask = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+
+            auto convert = [&](__m256 c) {
+                // maxps returns its second operand when either is NaN, so NaN lands on lo
+                __m256i bits = _mm256_castps_si256(_mm256_min_ps(_mm256_max_ps(c, lo), hi));
+                __m256i index = _mm256_srli_epi32(_mm256_sub_epi32(bits, min_bits), 20);
+                __m256 frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(bits, mantissa)), frac_scale);
+                __m256 srgb = OGE_FMADD256(_mm256_i32gather_ps(table.slope, index, 4), frac, _mm256_i32gather_ps(table.base, index, 4));
+                __m256 unorm = _mm256_add_ps(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(c, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)), _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f));
+                return _mm256_cvttps_epi32(_mm256_blendv_ps(srgb, unorm, alpha_mask));
+            };
+
+            // four pixels per step: 16 ints packed down to 16 bytes
+            for (; i + 4 <= pixels; i += 4) {
+                __m256i a = convert(_mm256_loadu_ps(src + i * 4));
+                __m256i b = convert(_mm256_loadu_ps(src + i * 4 + 8));
+                __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8);
+                __m256i bytes = _mm256_packus_epi16(words, words);
+                _mm_storeu_si128((__m128i*)(dst + i * 4), _mm256_castsi256_si128(_mm256_permute4x64_epi64(bytes, 0x08)));
+            }
+        #endif
+            scalar::linear_to_srgb(src + i * 4, dst + i * 4, pixels - i);
+        }
+
+        void premultiply_alpha(uint8_t* rgba, size_t pixels) {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            __m256i zero = _mm256_setzero_si256(), round = _mm256_set1_epi16(128);
+            __m256i keep_alpha = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+            __m256i color_mask = _mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0);
+            auto scale = [&](__m256i c) {
+                __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, 0xff), 0xff);
+                __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(c, _mm256_or_si256(_mm256_and_si256(a, color_mask), keep_alpha)), round);
+                return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+            };
+            for (; i + 8 <= pixels; i += 8) {
+                __m256i p = _mm256_loadu_si256((const __m256i*)(rgba + i * 4));
+                __m256i lo = scale(_mm256_unpacklo_epi8(p, zero)), hi = scale(_mm256_unpackhi_epi8(p, zero));
+                _mm256_storeu_si256((__m256i*)(rgba + i * 4), _mm256_packus_epi16(lo, hi));
+            }
+        #elif defined(__SSE2__) || defined(_M_X64)
+            __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi16(128);
+            __m128i keep_alpha = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+            __m128i color_mask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+            auto scale = [&](__m128i c) {
+                __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, 0xff), 0xff);
+                __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, _mm_or_si128(_mm_and_si128(a, color_mask), keep_alpha)), round);
+                return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            };
+            for (; i + 4 <= pixels; i += 4) {
+                __m128i p = _mm_loadu_si128((const __m128i*)(rgba + i * 4));
+                __m128i lo = scale(_mm_unpacklo_epi8(p, zero)), hi = scale(_mm_unpackhi_epi8(p, zero));
+                _mm_storeu_si128((__m128i*)(rgba + i * 4), _mm_packus_epi16(lo, hi));
+            }
+        #endif
+            scalar::premultiply_alpha(rgba + i * 4, pixels - i);
+        }
+
+        void swizzle(uint8_t* rgba, size_t pixels, const std::array<uint8_t, 4>& order) {
+            size_t i = 0;
+        #if defined(__AVX2__)
+            alignas(32) int8_t shuffle[32];
+            for (int b = 0; b < 32; b++) {
+                shuffle[b] = (int8_t)((b & ~3 & 15) + order[b & 3]);
+            }
+            __m256i mask = _mm256_load_si256((const __m256i*)shuffle);
+            for (; i + 8 <= pixels; i += 8) {
+                __m256i p = _mm256_loadu_si256((const __m256i*)(rgba + i * 4));
+                _mm256_storeu_si256((__m256i*)(rgba + i * 4), _mm256_shuffle_epi8(p, mask));
+            }
+        #endif
+            scalar::swizzle(rgba + i * 4, pixels - i, order);
+        }
+
+        image resize(const image& src, unsigned int width, unsigned int height, image_filter filter, bool srgb) {
+            std::vector<float> linear = image_detail::decode(src, srgb);
+            return image_detail::encode(image_detail::resample(linear, src.width, src.height, width, height, filter), width, height, srgb);
+        }
+
+        std::vector<image> generate_mips(const image& src, image_filter filter, bool srgb) {
+            std::vector<image> levels = { src };
+            std::vector<float> level = image_detail::decode(src, srgb);
+            unsigned int w = src.width, h = src.height;
+            while (w > 1 || h > 1) {
+                unsigned int nw = std::max(1u, w / 2), nh = std::max(1u, h / 2);
+                level = image_detail::resample(level, w, h, nw, nh, filter);
+                levels.push_back(image_detail::encode(level, nw, nh, srgb));
+                w = nw;
+                h = nh;
+            }
+            return levels;
+        }
+
+        void benchmark_image_kernels(unsigned int size) {
+            size_t pixels = (size_t)size * size;
+            std::vector<uint8_t> rgba(pixels * 4), copy;
+            for (size_t i = 0; i < rgba.size(); i++) {
+                rgba[i] = (uint8_t)((i * 2654435761u) >> 24);
+            }
+            std::vector<float> linear(pixels * 4);
+
+            auto time = [](auto&& fn) {
+                auto start = std::chrono::steady_clock::now();
+                fn();
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            };
+            auto report = [](const char* name, double simd, double reference) {
+                LOG_INFO("{:<18} simd {:8.2f} ms  scalar {:8.2f} ms  x{:.1f}", name, simd, reference, reference / std::max(simd, 1e-3));
+            };
+
+            report("srgb_to_linear", time([&] { srgb_to_linear(rgba.data(), linear.data(), pixels); }),
+                                     time([&] { scalar::srgb_to_linear(rgba.data(), linear.data(), pixels); }));
+            report("linear_to_srgb", time([&] { linear_to_srgb(linear.data(), rgba.data(), pixels); }),
+                                     time([&] { scalar::linear_to_srgb(linear.data(), rgba.data(), pixels); }));
+            copy = rgba;
+            report("premultiply_alpha", time([&] { premultiply_alpha(rgba.data(), pixels); }),
+                                        time([&] { scalar::premultiply_alpha(copy.data(), pixels); }));
+            report("swizzle", time([&] { swizzle(rgba.data(), pixels, { 2, 1, 0, 3 }); }),
+                              time([&] { scalar::swizzle(copy.data(), pixels, { 2, 1, 0, 3 }); }));
+
+            image img = { size, size, rgba };
+            LOG_INFO("generate_mips box {:.2f} ms, kaiser {:.2f} ms",
+                time([&] { generate_mips(img, image_filter::box); }), time([&] { generate_mips(img, image_filter::kaiser); }));
+        }
+
+        // asset manager
+
+        shader_source asset_loader<shader>::decode(const std::string& key) {
+            size_t split = key.find('|');
+            if (split == std::string::npos) {
+                LOG_ERROR("Shader key needs \"vertex|fragment\": {}", key);
+                return {};
+            }
+            return { read_file(key.substr(0, split).c_str()), read_file(key.substr(split + 1).c_str()) };
+        }
+
+        std::unique_ptr<shader> asset_loader<shader>::create(shader_source&& source) {
+            if (source.vertex.empty() || source.fragment.empty()) {
+                return nullptr;
+            }
+            auto program = std::make_unique<shader>(source);
+            return program->id() ? std::move(program) : nullptr;
+        }
+
+        asset_size asset_loader<shader>::size(const shader& program) {
+            int length = 0;
+            glGetProgramiv(program.id(), GL_PROGRAM_BINARY_LENGTH, &length);
+            return { 0, (size_t)std::max(length, 1) };
+        }
+
+        std::string asset_loader<texture2d>::decode(const std::string& key) {
+            return key;
+        }
+
+        std::unique_ptr<texture2d> asset_loader<texture2d>::create(std::string&& path) {
+            return std::make_unique<texture2d>(path.c_str());
+        }
+
+        asset_size asset_loader<texture2d>::size(const texture2d& texture) {
+            if (!texture.ready()) {
+                return {};
+            }
+            // rgba8 plus a third for the mip chain
+            return { 0, (size_t)texture.width() * texture.height() * 4 * 4 / 3 };
+        }
+
+        std::unique_ptr<model_data> asset_loader<model_data>::decode(const std::string& key) {
+            auto model = std::make_unique<model_data>();
+            return import_model(key.c_str(), *model) ? std::move(model) : nullptr;
+        }
+
+        std::unique_ptr<model_data> asset_loader<model_data>::create(std::unique_ptr<model_data>&& model) {
+            return std::move(model);
+        }
+
+        asset_size asset_loader<model_data>::size(const model_data& model) {
+            const mesh_data& m = model.mesh;
+            return { m.positions.size() * sizeof(glm::vec3) + m.normals.size() * sizeof(glm::vec3) + m.uvs.size() * sizeof(glm::vec2) +
+                     m.tangents.size() * sizeof(glm::vec4) + m.colors.size() * sizeof(glm::vec4) + m.indices.size() * sizeof(uint32_t) +
+                     model.submeshes.size() * sizeof(submesh), 0 };
+        }
+
+        asset_manager::asset_manager(size_t cpu_budget, size_t gpu_budget) : _cpu_budget(cpu_budget), _gpu_budget(gpu_budget) {}
+
+        asset_manager::~asset_manager() {
+            clear();
+        }
+
+        asset_manager& asset_manager::global() {
+            static asset_manager manager;
+            return manager;
+        }
+
+        uint32_t asset_manager::next_type_id() {
+            static std::atomic<uint32_t> next = 1;
+            return next++;
+        }
+
+        asset_manager::slot* asset_manager::resolve(asset_id id) {
+            if (!id.valid() || id.index >= _slots.size() || _slots[id.index].generation != id.generation || _slots[id.index].state == asset_state::empty) {
+                return nullptr;
+            }
+            return &_slots[id.index];
+        }
+
+        const asset_manager::slot* asset_manager::resolve(asset_id id) const {
+            return const_cast<asset_manager*>(this)->resolve(id);
+        }
+
+        asset_id asset_manager::acquire(uint32_t type, std::string_view key, std::initializer_list<asset_id> dependencies,
+                                        const type_ops& ops, std::function<std::shared_ptr<void>()> decode) {
+            std::string lookup = std::to_string(type) + ':' + asset_pack::normalize(key);
+            if (auto it = _lookup.find(lookup); it != _lookup.end()) {
+                asset_id id = { it->second, _slots[it->second].generation };
+                retain(id);
+                _stats.dedup_hits++;
+                return id;
+            }
+
+            uint32_t index;
+            if (!_free.empty()) {
+                index = _free.back();
+                _free.pop_back();
+            } else {
+                index = (uint32_t)_slots.size();
+                _slots.emplace_back();
+            }
+            slot& s = _slots[index];
+            s.type = type;
+            s.state = asset_state::loading;
+            s.references = 1;
+            s.key = std::move(lookup);
+            s.ops = &ops;
+            for (asset_id dependency : dependencies) {
+                if (resolve(dependency)) {
+                    retain(dependency);
+                    s.dependencies.push_back(dependency);
+                } else {
+                    LOG_WARN("Asset {} depends on a stale handle", key);
+                }
+            }
+            s.decoding = thread_pool::global().submit(std::move(decode));
+            _lookup.emplace(s.key, index);
+            _stats.assets++;
+            _stats.loading++;
+            return { index, s.generation };
+        }
+
+        void* asset_manager::object(asset_id id, uint32_t type) {
+            slot* s = resolve(id);
+            if (!s || s->type != type || s->state != asset_state::ready) {
+                return nullptr;
+            }
+            return s->object;
+        }
+
+        asset_state asset_manager::state(asset_id id) const {
+            const slot* s = resolve(id);
+            return s ? s->state : asset_state::empty;
+        }
+
+        void asset_manager::retain(asset_id id) {
+            slot* s = resolve(id);
+            if (!s) {
+                return;
+            }
+            if (s->cached) {
+                _lru.erase(s->lru);
+                s->cached = false;
+            }
+            s->references++;
+        }
+
+        void asset_manager::release(asset_id id) {
+            slot* s = resolve(id);
+            if (!s || !s->references) {
+                LOG_WARN("Released an asset that holds no references");
+                return;
+            }
+            if (--s->references == 0) {
+                if (s->state == asset_state::failed) {
+                    // nothing worth caching
+                    evict(id.index);
+                    return;
+                }
+                s->lru = _lru.insert(_lru.end(), id.index);
+                s->cached = true;
+            }
+        }
+
+        void asset_manager::update() {
+            for (uint32_t i = 0; i < _slots.size(); i++) {
+                slot& s = _slots[i];
+                if (s.state != asset_state::loading || !s.decoding.valid() ||
+                    s.decoding.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    continue;
+                }
+
+                bool waiting = false, failed = false;
+                for (asset_id dependency : s.dependencies) {
+                    asset_state st = state(dependency);
+                    waiting |= st == asset_state::loading;
+                    failed |= st == asset_state::failed || st == asset_state::empty;
+                }
+                if (waiting && !failed) {
+                    continue;
+                }
+
+                std::shared_ptr<void> payload = s.decoding.get();
+                s.object = failed ? nullptr : s.ops->create(payload.get());
+                s.state = s.object ? asset_state::ready : asset_state::failed;
+                _stats.loading--;
+                if (!s.object) {
+                    LOG_ERROR("Failed to load asset {}", s.key.substr(s.key.find(':') + 1));
+                    // handles already out keep seeing failed, the next load of the key tries again
+                    _lookup.erase(s.key);
+                }
+            }
+
+            // streamed assets report their size once they are resident
+            for (slot& s : _slots) {
+                if (s.state == asset_state::ready && !s.size.cpu && !s.size.gpu) {
+                    s.size = s.ops->size(s.object);
+                    _stats.cpu_bytes += s.size.cpu;
+                    _stats.gpu_bytes += s.size.gpu;
+                }
+            }
+
+            while (over_budget() && !_lru.empty()) {
+                evict(_lru.front());
+            }
+        }
+
+        void asset_manager::evict_unused() {
+            while (!_lru.empty()) {
+                evict(_lru.front());
+            }
+        }
+
+        bool asset_manager::over_budget() const {
+            return _stats.cpu_bytes > _cpu_budget || _stats.gpu_bytes > _gpu_budget;
+        }
+
+        void asset_manager::evict(uint32_t index) {
+            slot& s = _slots[index];
+            if (s.cached) {
+                _lru.erase(s.lru);
+            }
+            if (s.object) {
+                s.ops->destroy(s.object);
+            }
+            if (s.state == asset_state::loading) {
+                _stats.loading--;
+            }
+            _stats.cpu_bytes -= s.size.cpu;
+            _stats.gpu_bytes -= s.size.gpu;
+            _stats.assets--;
+            _stats.evictions++;
+            // a failed load no longer owns its key, a retry may have taken it
+            if (auto it = _lookup.find(s.key); it != _lookup.end() && it->second == index) {
+                _lookup.erase(it);
+            }
+
+            // an unfinished decode completes into a future nobody reads
+            std::vector<asset_id> dependencies = std::move(s.dependencies);
+            uint32_t generation = s.generation + 1 ? s.generation + 1 : 1;
+            s = slot();
+            s.generation = generation;
+            _free.push_back(index);
+
+            for (asset_id dependency : dependencies) {
+                release(dependency);
+            }
+        }
+
+        void asset_manager::clear() {
+            for (uint32_t i = 0; i < _slots.size(); i++) {
+                if (_slots[i].state != asset_state::empty) {
+                    // everything goes, so nothing needs its dependencies released
+                    _slots[i].dependencies.clear();
+                    evict(i);
+                }
+            }
+            _lru.clear();
+            _stats = {};
+        }
 
-        ogldbg::level ogldbg::_level = ogldbg::level::highassert;
+        void asset_manager::set_budget(size_t cpu, size_t gpu) {
+            _cpu_budget = cpu;
+            _gpu_budget = gpu;
+        }
 
-        void ogldbg::init() {
-            glDebugMessageCallback(message, nullptr);
-            glEnable(GL_DEBUG_OUTPUT);
-            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        // virtual file system
+
+    #if defined(__linux__)
+        // raw syscalls, no liburing. the eventfd poll lets submitters wake the i/o thread
+        // while it sleeps in io_uring_enter
+        struct vfs::ring {
+            static constexpr uint64_t wake_tag = 0;   // tickets start at 1
+            static constexpr uint64_t cancel_tag = ~0ull;
+
+            int fd = -1;
+            int wake = -1;
+            io_uring_params params = {};
+            uint8_t* sq = nullptr;
+            uint8_t* cq = nullptr;
+            io_uring_sqe* sqes = nullptr;
+            size_t sq_size = 0, cq_size = 0;
+            unsigned int queued = 0;
+
+            ~ring() {
+                if (sqes) {
+                    munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+                }
+                if (cq && cq != sq) {
+                    munmap(cq, cq_size);
+                }
+                if (sq) {
+                    munmap(sq, sq_size);
+                }
+                if (wake >= 0) {
+                    ::close(wake);
+                }
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+
+            bool init(unsigned int entries) {
+                fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+                // IORING_OP_READ came with 5.6, fast poll with 5.7: older kernels take the fallback
+                if (fd < 0 || !(params.features & IORING_FEAT_FAST_POLL)) {
+                    return false;
+                }
+                sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+                cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+                if (single) {
+                    sq_size = cq_size = std::max(sq_size, cq_size);
+                }
+                void* s = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                if (s == MAP_FAILED) {
+                    return false;
+                }
+                sq = (uint8_t*)s;
+                void* c = single ? s : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                if (c == MAP_FAILED) {
+                    return false;
+                }
+                cq = (uint8_t*)c;
+                void* e = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+                if (e == MAP_FAILED) {
+                    return false;
+                }
+                sqes = (io_uring_sqe*)e;
+                wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                return wake >= 0 && arm_wake();
+            }
+
+            inline unsigned int& field(uint8_t* base, uint32_t offset) { return *(unsigned int*)(base + offset); }
+
+            // a zeroed sqe at the tail, the kernel doesn't see it until commit()
+            io_uring_sqe* next() {
+                unsigned int tail = field(sq, params.sq_off.tail);
+                unsigned int head = std::atomic_ref<unsigned int>(field(sq, params.sq_off.head)).load(std::memory_order_acquire);
+                if (tail - head >= params.sq_entries) {
+                    return nullptr;
+                }
+                unsigned int index = tail & field(sq, params.sq_off.ring_mask);
+                io_uring_sqe* e = &sqes[index];
+                std::memset(e, 0, sizeof(*e));
+                ((unsigned int*)(sq + params.sq_off.array))[index] = index;
+                return e;
+            }
+
+            // publishes the sqe next() handed out once it is filled in
+            void commit() {
+                unsigned int tail = field(sq, params.sq_off.tail);
+                std::atomic_ref<unsigned int>(field(sq, params.sq_off.tail)).store(tail + 1, std::memory_order_release);
+                queued++;
+            }
+
+            bool arm_wake() {
+                io_uring_sqe* e = next();
+                if (!e) {
+                    return false;
+                }
+                e->opcode = IORING_OP_POLL_ADD;
+                e->fd = wake;
+                e->poll_events = POLLIN;
+                e->user_data = wake_tag;
+                commit();
+                return true;
+            }
+
+            bool push_read(int file, uint8_t* data, size_t size, uint64_t offset, uint64_t ticket) {
+                io_uring_sqe* e = next();
+                if (!e) {
+                    return false;
+                }
+                e->opcode = IORING_OP_READ;
+                e->fd = file;
+                e->addr = (uint64_t)(uintptr_t)data;
+                e->len = (uint32_t)std::min<size_t>(size, 1u << 30);
+                e->off = offset;
+                e->user_data = ticket;
+                commit();
+                return true;
+            }
+
+            bool push_cancel(uint64_t ticket) {
+                io_uring_sqe* e = next();
+                if (!e) {
+                    return false;
+                }
+                e->opcode = IORING_OP_ASYNC_CANCEL;
+                e->fd = -1;
+                e->addr = ticket;
+                e->user_data = cancel_tag;
+                commit();
+                return true;
+            }
+
+            // submits everything queued and optionally sleeps until one completion arrives
+            void enter(bool wait) {
+                int r = (int)syscall(__NR_io_uring_enter, fd, queued, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if (r > 0) {
+                    queued -= std::min<unsigned int>(queued, r);
+                }
+            }
+
+            bool pop(io_uring_cqe& out) {
+                unsigned int head = field(cq, params.cq_off.head);
+                unsigned int tail = std::atomic_ref<unsigned int>(field(cq, params.cq_off.tail)).load(std::memory_order_acquire);
+                if (head == tail) {
+                    return false;
+                }
+                out = ((io_uring_cqe*)(cq + params.cq_off.cqes))[head & field(cq, params.cq_off.ring_mask)];
+                std::atomic_ref<unsigned int>(field(cq, params.cq_off.head)).store(head + 1, std::memory_order_release);
+                return true;
+            }
+        };
+    #else
+        struct vfs::ring {};
+    #endif
+
+        vfs::vfs(unsigned int queue_depth) : _depth(std::max(1u, queue_depth)) {
+        #if defined(__linux__)
+            auto r = std::make_unique<ring>();
+            // a read and its cancel per slot, plus the wake poll
+            if (r->init(2 * _depth + 1)) {
+                _ring = std::move(r);
+            } else {
+                LOG_WARN("io_uring unavailable, file reads go through reader threads");
+            }
+        #endif
+            if (!_ring) {
+                for (unsigned int i = 0; i < std::min(_depth, 4u); i++) {
+                    _readers.emplace_back(&vfs::reader, this);
+                }
+            }
+            _thread = std::thread(&vfs::worker, this);
         }
 
-        void ogldbg::set_level( const ogldbg::level& lvl) {
-            _level = lvl;
+        vfs::~vfs() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            wake();
+            _thread.join();
+            // the worker only returns once nothing is in flight, the readers are idle
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _readers_stop = true;
+            }
+            _read_cv.notify_all();
+            for (std::thread& t : _readers) {
+                t.join();
+            }
+            while (_pool_jobs) {
+                std::this_thread::yield();
+            }
         }
 
-        void ogldbg::message(GLenum, GLenum, GLuint, GLenum severity, GLsizei, const GLchar* message, const void*) {
-            switch(severity) {
-                case GL_DEBUG_SEVERITY_HIGH:
-                    if (_level > level::high) {
-                        LOG_ERROR("OpenGL Error: {}", message);
-                        if(_level == level::highassert) {
-                            OGE_ASSERT(false, "OpenGL Error: {}", message);
-                        }
-                    }
-                    break;
-                case GL_DEBUG_SEVERITY_MEDIUM:
-                    if (_level > level::medium) {
-                        LOG_WARN("OpenGL Error: {}", message);
-                    }
-                    break;
-                case GL_DEBUG_SEVERITY_LOW:
-                    if (_level > level::low) {
-                        LOG_INFO("OpenGL Error: {}", message);
-                    }
-                    break;
-                case GL_DEBUG_SEVERITY_NOTIFICATION:
-                    if (_level > level::notification) {
-                        LOG_TRACE("OpenGL Error: {}", message);
-                    }
-                    break;
+        vfs& vfs::global() {
+            static vfs instance;
+            return instance;
+        }
+
+        bool vfs::mount_directory(std::string_view prefix, const char* dir) {
+            if (!std::filesystem::is_directory(dir)) {
+                LOG_ERROR("Cannot mount {}: not a directory", dir);
+                return false;
             }
+            std::lock_guard<std::mutex> lock(_mutex);
+            _mounts.push_back({ asset_pack::normalize(prefix), asset_pack::normalize(dir), nullptr });
+            return true;
         }
-   
-        // shader
 
-        std::string read_file(const char* path) {
-            std::ifstream file(path, std::ios::in | std::ios::binary);
-            if (!file) {
-                LOG_ERROR("Failed to open file: {}", path);
-                return "";
+        bool vfs::mount_pack(std::string_view prefix, const char* path) {
+            auto pack = std::make_unique<asset_pack>(path);
+            if (!pack->valid()) {
+                return false;
             }
-            std::stringstream ss;
-            ss << file.rdbuf();
-            file.close();
-            return ss.str();
+            std::lock_guard<std::mutex> lock(_mutex);
+            _mounts.push_back({ asset_pack::normalize(prefix), {}, std::move(pack) });
+            return true;
         }
 
-        shader::shader(const char* vertex_path, const char* fragment_path) {
+        void vfs::unmount_all() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _mounts.clear();
+        }
 
-            const char* vertex_source = read_file(vertex_path).c_str();
-            const char* fragment_source = read_file(fragment_path).c_str();
+        vfs::stats vfs::statistics() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _stats;
+        }
 
-            _id = compile_program(vertex_source, fragment_source);
+        uint64_t vfs::read_async(std::string_view path, io_callback done, io_priority priority) {
+            uint64_t ticket;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                ticket = _next_ticket++;
+                _queues[(size_t)priority].push_back({ ticket, asset_pack::normalize(path), std::move(done) });
+                _active.emplace(ticket, false);
+                _stats.submitted++;
+            }
+            wake();
+            return ticket;
+        }
 
+        io_request vfs::read_async(std::string_view path, io_priority priority) {
+            auto promise = std::make_shared<std::promise<io_result>>();
+            io_request req;
+            req.result = promise->get_future();
+            req.ticket = read_async(path, [promise](io_result&& result) { promise->set_value(std::move(result)); }, priority);
+            return req;
         }
 
-        void shader::bind() const { glUseProgram(_id); }
-        void shader::unbind() const { glUseProgram(0); }
+        io_result vfs::read(std::string_view path) {
+            // with every worker blocked here the pack reads it waits on would never run
+            OGE_ASSERT(!thread_pool::global().is_worker(), "vfs::read called from a thread pool job");
+            return read_async(path, io_priority::high).result.get();
+        }
 
-        void shader::set_uniform(const char* name, const int& value) {
-            glUniform1i(get_uniform_location(name), value);
+        bool vfs::cancel(uint64_t ticket) {
+            request cancelled;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto it = _active.find(ticket);
+                if (it == _active.end()) {
+                    return false;
+                }
+                if (it->second) {
+                    return true;
+                }
+                it->second = true;
+                for (std::deque<request>& queue : _queues) {
+                    auto queued = std::find_if(queue.begin(), queue.end(), [ticket](const request& r) { return r.ticket == ticket; });
+                    if (queued != queue.end()) {
+                        cancelled = std::move(*queued);
+                        queue.erase(queued);
+                        break;
+                    }
+                }
+                if (!cancelled.done && _ring) {
+                    _cancels.push_back(ticket);
+                }
+            }
+            if (cancelled.done) {
+                finish(ticket, cancelled.done, {});
+            } else if (_ring) {
+                wake();
+            }
+            return true;
         }
 
-        void shader::set_uniform(const char* name, const unsigned int& value) {
-            glUniform1ui(get_uniform_location(name), value);
+        void vfs::wake() {
+        #if defined(__linux__)
+            if (_ring) {
+                uint64_t one = 1;
+                [[maybe_unused]] ssize_t n = ::write(_ring->wake, &one, sizeof(one));
+                return;
+            }
+        #endif
+            // the worker checks _in_flight under the lock, so take it before notifying
+            { std::lock_guard<std::mutex> lock(_mutex); }
+            _cv.notify_all();
         }
 
-        void shader::set_uniform(const char* name, const float& value) {
-            glUniform1f(get_uniform_location(name), value);
+        vfs::target vfs::resolve(std::string_view path) const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto it = _mounts.rbegin(); it != _mounts.rend(); ++it) {
+                const mount& m = *it;
+                if (!path.starts_with(m.prefix)) {
+                    continue;
+                }
+                std::string_view rest = path.substr(m.prefix.size());
+                if (!m.prefix.empty() && !m.prefix.ends_with('/')) {
+                    if (!rest.starts_with('/')) {
+                        continue;
+                    }
+                }
+                while (rest.starts_with('/')) {
+                    rest.remove_prefix(1);
+                }
+                if (m.pack) {
+                    if (const asset_pack::entry* e = m.pack->find(rest)) {
+                        return { m.pack.get(), e, {} };
+                    }
+                } else {
+                    std::string file = m.directory + "/" + std::string(rest);
+                    std::error_code error;
+                    if (std::filesystem::is_regular_file(file, error)) {
+                        return { nullptr, nullptr, std::move(file) };
+                    }
+                }
+            }
+            std::error_code error;
+            return { nullptr, nullptr, std::filesystem::is_regular_file(path, error) ? std::string(path) : std::string() };
         }
 
-        void shader::set_uniform(const char* name, const double& value) {
-            glUniform1d(get_uniform_location(name), value);
+        void vfs::finish(uint64_t ticket, const io_callback& done, io_result&& result) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto it = _active.find(ticket);
+                if (it != _active.end() && it->second) {
+                    result = { io_status::cancelled, {} };
+                }
+                _active.erase(ticket);
+                _stats.completed++;
+                _stats.cancelled += result.status == io_status::cancelled;
+                _stats.bytes_read += result.data.size();
+            }
+            if (done) {
+                done(std::move(result));
+            }
         }
 
-        void shader::set_uniform(const char* name, const vec2i value) {
-            glUniform2i(get_uniform_location(name), value.x, value.y);
+        void vfs::reader() {
+            while (true) {
+                request req;
+                std::string path;
+                bool cancelled;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _read_cv.wait(lock, [&]() { return _readers_stop || !_file_reads.empty(); });
+                    if (_file_reads.empty()) {
+                        return;
+                    }
+                    req = std::move(_file_reads.front().first);
+                    path = std::move(_file_reads.front().second);
+                    _file_reads.pop_front();
+                    auto it = _active.find(req.ticket);
+                    cancelled = it != _active.end() && it->second;
+                }
+
+                io_result result;
+                if (!cancelled) {
+                    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+                    std::streamoff size = file ? (std::streamoff)file.tellg() : -1;
+                    if (size >= 0) {
+                        result.data.resize((size_t)size);
+                        file.seekg(0);
+                        file.read((char*)result.data.data(), result.data.size());
+                        result.status = file ? io_status::ok : io_status::failed;
+                    }
+                    if (!result.ok()) {
+                        LOG_ERROR("Failed to read {}", req.path);
+                        result.data.clear();
+                    }
+                }
+                finish(req.ticket, req.done, std::move(result));
+                _in_flight--;
+                wake();
+            }
         }
 
-        void shader::set_uniform(const char* name, const vec2u& value) {
-            glUniform2ui(get_uniform_location(name), value.x, value.y);
+        // packs are already mapped, and compressed entries want several cores anyway
+        void vfs::read_on_pool(request& req, target where) {
+            _in_flight++;
+            _pool_jobs++;
+            thread_pool::global().submit([this, req = std::move(req), where = std::move(where)]() {
+                io_result result;
+                result.data.resize(where.entry->size);
+                result.status = where.pack->read(*where.entry, result.data.data()) ? io_status::ok : io_status::failed;
+                if (!result.ok()) {
+                    LOG_ERROR("Failed to read {}", req.path);
+                    result.data.clear();
+                }
+                finish(req.ticket, req.done, std::move(result));
+                _in_flight--;
+                wake();
+                // last touch of `this`, the destructor waits for it
+                _pool_jobs--;
+            });
         }
 
-        void shader::set_uniform(const char* name, const vec2f& value) {
-            glUniform2f(get_uniform_location(name), value.x, value.y);
+        void vfs::worker() {
+        #if defined(__linux__)
+            struct file_read {
+                request req;
+                int fd;
+                std::vector<uint8_t> data;
+                size_t done = 0;
+            };
+            std::unordered_map<uint64_t, file_read> reads;
+        #endif
+
+            while (true) {
+                std::vector<request> batch;
+                bool stopping;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    auto queued = [&]() { return !_queues[0].empty() || !_queues[1].empty() || !_queues[2].empty(); };
+                    if (!_ring) {
+                        _cv.wait(lock, [&]() { return _stop ? queued() || _in_flight == 0 : queued() && _in_flight < _depth; });
+                    }
+                    stopping = _stop;
+                    if (stopping) {
+                        // whatever is still queued completes as cancelled
+                        for (std::deque<request>& queue : _queues) {
+                            for (request& r : queue) {
+                                _active[r.ticket] = true;
+                                batch.push_back(std::move(r));
+                            }
+                            queue.clear();
+                        }
+                    } else {
+                        for (size_t p = 3; p-- > 0;) {
+                            while (!_queues[p].empty() && _in_flight + batch.size() < _depth) {
+                                batch.push_back(std::move(_queues[p].front()));
+                                _queues[p].pop_front();
+                            }
+                        }
+                    }
+                }
+
+                if (stopping) {
+                    for (request& r : batch) {
+                        finish(r.ticket, r.done, {});
+                    }
+                    batch.clear();
+                }
+
+                for (request& r : batch) {
+                    target where = resolve(r.path);
+                    if (!where.pack && where.file.empty()) {
+                        finish(r.ticket, r.done, { io_status::missing, {} });
+                        continue;
+                    }
+                    if (where.pack) {
+                        read_on_pool(r, std::move(where));
+                        continue;
+                    }
+                    if (!_ring) {
+                        {
+                            std::lock_guard<std::mutex> lock(_mutex);
+                            _file_reads.push_back({ std::move(r), std::move(where.file) });
+                            _in_flight++;
+                        }
+                        _read_cv.notify_one();
+                        continue;
+                    }
+                #if defined(__linux__)
+                    int fd = ::open(where.file.c_str(), O_RDONLY | O_CLOEXEC);
+                    struct stat st;
+                    if (fd < 0 || fstat(fd, &st) != 0) {
+                        if (fd >= 0) {
+                            ::close(fd);
+                        }
+                        LOG_ERROR("Failed to open file: {}", where.file);
+                        finish(r.ticket, r.done, { io_status::failed, {} });
+                        continue;
+                    }
+                    if (!st.st_size) {
+                        ::close(fd);
+                        finish(r.ticket, r.done, { io_status::ok, {} });
+                        continue;
+                    }
+                    file_read& fr = reads[r.ticket];
+                    fr.fd = fd;
+                    fr.data.resize((size_t)st.st_size);
+                    fr.req = std::move(r);
+                    // sized for every slot's read and cancel: the ring cannot be full here
+                    _ring->push_read(fd, fr.data.data(), fr.data.size(), 0, fr.req.ticket);
+                    _in_flight++;
+                #endif
+                }
+
+                if (stopping && _in_flight == 0) {
+                    break;
+                }
+
+            #if defined(__linux__)
+                if (_ring) {
+                    // reads cancelled while in flight stop early instead of filling their buffers
+                    std::vector<uint64_t> cancels;
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        cancels.swap(_cancels);
+                    }
+                    for (uint64_t ticket : cancels) {
+                        if (reads.count(ticket)) {
+                            _ring->push_cancel(ticket);
+                        }
+                    }
+
+                    // sleep until a read lands or wake() is called
+                    _ring->enter(true);
+                    io_uring_cqe cqe;
+                    while (_ring->pop(cqe)) {
+                        if (cqe.user_data == ring::wake_tag) {
+                            uint64_t count;
+                            [[maybe_unused]] ssize_t n = ::read(_ring->wake, &count, sizeof(count));
+                            _ring->arm_wake();
+                            continue;
+                        }
+                        auto it = reads.find(cqe.user_data);
+                        if (cqe.user_data == ring::cancel_tag || it == reads.end()) {
+                            continue;
+                        }
+                        file_read& fr = it->second;
+                        bool cancelled;
+                        {
+                            std::lock_guard<std::mutex> lock(_mutex);
+                            cancelled = _active[fr.req.ticket];
+                        }
+                        if (!cancelled && (cqe.res == -EINTR || cqe.res == -EAGAIN)) {
+                            _ring->push_read(fr.fd, fr.data.data() + fr.done, fr.data.size() - fr.done, fr.done, fr.req.ticket);
+                            continue;
+                        }
+                        if (cqe.res > 0) {
+                            fr.done += cqe.res;
+                        }
+                        // short reads carry on from where they stopped
+                        if (cqe.res > 0 && fr.done < fr.data.size() && !cancelled) {
+                            _ring->push_read(fr.fd, fr.data.data() + fr.done, fr.data.size() - fr.done, fr.done, fr.req.ticket);
+                            continue;
+                        }
+                        // a cancelled read leaves result empty, finish() reports it as cancelled
+                        io_result result;
+                        if (!cancelled && cqe.res < 0) {
+                            LOG_ERROR("Failed to read {}: {}", fr.req.path, std::strerror(-cqe.res));
+                        } else if (!cancelled) {
+                            fr.data.resize(fr.done);
+                            result = { io_status::ok, std::move(fr.data) };
+                        }
+                        ::close(fr.fd);
+                        file_read done = std::move(fr);
+                        reads.erase(it);
+                        _in_flight--;
+                        finish(done.req.ticket, done.req.done, std::move(result));
+                    }
+                }
+            #endif
+            }
         }
 
-        void shader::set_uniform(const char* name, const vec2d& value) {
-            glUniform2d(get_uniform_location(name), value.x, value.y);
+        // asset cooking
+
+        namespace cook_detail {
+
+            // xxh64
+            static constexpr uint64_t prime1 = 0x9e3779b185ebca87ull, prime2 = 0xc2b2ae3d27d4eb4full, prime3 = 0x165667b19e3779f9ull,
+                                      prime4 = 0x85ebca77c2b2ae63ull, prime5 = 0x27d4eb2f165667c5ull;
+
+            static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+                return std::rotl(acc + input * prime2, 31) * prime1;
+            }
+
+            static inline uint64_t merge(uint64_t acc, uint64_t value) {
+                return (acc ^ xxh_round(0, value)) * prime1 + prime4;
+            }
+
+            static uint64_t hash(const void* data, size_t size, uint64_t seed = 0) {
+                const uint8_t* p = (const uint8_t*)data;
+                const uint8_t* end = p + size;
+                auto read64 = [](const uint8_t* at) { uint64_t v; std::memcpy(&v, at, 8); return v; };
+                auto read32 = [](const uint8_t* at) { uint32_t v; std::memcpy(&v, at, 4); return (uint64_t)v; };
+
+                uint64_t h;
+                if (size >= 32) {
+                    uint64_t v1 = seed + prime1 + prime2, v2 = seed + prime2, v3 = seed, v4 = seed - prime1;
+                    for (; p + 32 <= end; p += 32) {
+                        v1 = xxh_round(v1, read64(p));
+                        v2 = xxh_round(v2, read64(p + 8));
+                        v3 = xxh_round(v3, read64(p + 16));
+                        v4 = xxh_round(v4, read64(p + 24));
+                    }
+                    h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+                    h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+                } else {
+                    h = seed + prime5;
+                }
+                h += size;
+                for (; p + 8 <= end; p += 8) {
+                    h = std::rotl(h ^ xxh_round(0, read64(p)), 27) * prime1 + prime4;
+                }
+                if (p + 4 <= end) {
+                    h = std::rotl(h ^ read32(p) * prime1, 23) * prime2 + prime3;
+                    p += 4;
+                }
+                for (; p < end; p++) {
+                    h = std::rotl(h ^ *p * prime5, 11) * prime1;
+                }
+                h ^= h >> 33;
+                h *= prime2;
+                h ^= h >> 29;
+                h *= prime3;
+                return h ^ (h >> 32);
+            }
+
+            static inline uint64_t hash(std::string_view text, uint64_t seed = 0) {
+                return hash(text.data(), text.size(), seed);
+            }
+
+            struct file_state {
+                uint64_t hash = 0;
+                uint64_t size = 0;
+                int64_t mtime = 0;
+            };
+
+            struct record {
+                uint64_t key = 0;
+                std::string output;
+                std::vector<std::string> dependencies;
+            };
+
+            static std::string lowercase_extension(const std::filesystem::path& path) {
+                std::string ext = path.extension().string();
+                std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+                return ext;
+            }
+
+            // a missing file hashes to 0, which no cached key was built from
+            static file_state stat_file(const std::filesystem::path& path, const file_state* cached) {
+                std::error_code error;
+                file_state state;
+                state.size = std::filesystem::file_size(path, error);
+                if (error) {
+                    return {};
+                }
+                state.mtime = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+                if (cached && cached->size == state.size && cached->mtime == state.mtime) {
+                    return *cached;
+                }
+                mapped_file file(path.string().c_str());
+                state.hash = file.valid() ? hash(file.data(), file.size()) | 1 : 0;
+                return state;
+            }
+
+            // manifest numbers; anything malformed drops the line, which re-cooks that asset
+            template <typename T>
+            static bool parse_field(std::string_view text, T& out, int base = 10) {
+                const char* end = text.data() + text.size();
+                std::from_chars_result r = std::from_chars(text.data(), end, out, base);
+                return !text.empty() && r.ec == std::errc() && r.ptr == end;
+            }
+
+            // inlines #include "file" relative to the including file, once per file
+            static bool expand_includes(const std::filesystem::path& path, std::string& out, std::vector<std::string>& dependencies,
+                                        std::vector<std::string>& stack) {
+                // straight off disk: read_file would serve a mounted pack's stale copy
+                mapped_file file(path.string().c_str());
+                std::string key = path.lexically_normal().generic_string();
+                if (!file.valid()) {
+                    LOG_ERROR("Failed to read {}", key);
+                    return false;
+                }
+                std::string_view text = file.view();
+                if (std::find(stack.begin(), stack.end(), key) != stack.end()) {
+                    LOG_ERROR("Include cycle through {}", key);
+                    return false;
+                }
+                stack.push_back(key);
+                size_t line_start = 0;
+                while (line_start < text.size()) {
+                    size_t line_end = text.find('\n', line_start);
+                    line_end = line_end == std::string::npos ? text.size() : line_end + 1;
+                    std::string_view line(text.data() + line_start, line_end - line_start);
+                    size_t hash_at = line.find_first_not_of(" \t");
+                    if (hash_at != std::string_view::npos && line.substr(hash_at).starts_with("#include")) {
+                        size_t open = line.find('"'), close = line.rfind('"');
+                        if (open == std::string_view::npos || close <= open) {
+                            LOG_ERROR("Malformed include in {}: {}", key, line);
+                            return false;
+                        }
+                        std::filesystem::path included = path.parent_path() / std::string(line.substr(open + 1, close - open - 1));
+                        dependencies.push_back(included.lexically_normal().generic_string());
+                        if (!std::filesystem::exists(included) || !expand_includes(included, out, dependencies, stack)) {
+                            LOG_ERROR("Failed to include {} from {}", included.generic_string(), key);
+                            return false;
+                        }
+                    } else {
+                        out += line;
+                    }
+                    line_start = line_end;
+                }
+                stack.pop_back();
+                return true;
+            }
+
         }
 
-        void shader::set_uniform(const char* name, const vec3i& value) {
-            glUniform3i(get_uniform_location(name), value.x, value.y, value.z);
+        bool cook_manifest::load(const char* path) {
+            std::ifstream file(path);
+            if (!file) {
+                LOG_ERROR("Failed to open cook manifest: {}", path);
+                return false;
+            }
+            std::string root = std::filesystem::path(path).parent_path().generic_string();
+            std::string line;
+            _outputs.clear();
+            while (std::getline(file, line)) {
+                // asset \t key \t source \t output [\t dependencies]
+                if (!line.starts_with("asset\t")) {
+                    continue;
+                }
+                std::vector<std::string_view> fields;
+                for (size_t start = 0, end; start <= line.size(); start = end + 1) {
+                    end = std::min(line.find('\t', start), line.size());
+                    fields.emplace_back(line.data() + start, end - start);
+                }
+                if (fields.size() >= 4) {
+                    _outputs[std::string(fields[2])] = root.empty() ? std::string(fields[3]) : root + "/" + std::string(fields[3]);
+                }
+            }
+            return true;
+        }
+
+        const std::string* cook_manifest::find(std::string_view source) const {
+            auto it = _outputs.find(asset_pack::normalize(source));
+            return it == _outputs.end() ? nullptr : &it->second;
+        }
+
+        asset_cooker::asset_cooker(std::string source_dir, std::string output_dir)
+            : _source(std::move(source_dir)), _output(std::move(output_dir)) {}
+
+        void asset_cooker::add_rule(cook_rule rule) {
+            for (std::string& ext : rule.extensions) {
+                std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+            }
+            _rules.push_back(std::move(rule));
+        }
+
+        void asset_cooker::add_default_rules() {
+            add_rule({ { ".png", ".jpg", ".jpeg", ".tga", ".bmp" }, ".otex", "bc7 mips", [](const std::string& input, const std::string& output, std::vector<std::string>&) {
+                return cook_texture(input.c_str(), output.c_str(), block_format::bc7, false, true);
+            } });
+            add_rule({ { ".glsl", ".vert", ".frag" }, ".glsl", "inline includes", [](const std::string& input, const std::string& output, std::vector<std::string>& dependencies) {
+                std::string text;
+                std::vector<std::string> stack;
+                if (!cook_detail::expand_includes(input, text, dependencies, stack)) {
+                    return false;
+                }
+                std::ofstream file(output, std::ios::out | std::ios::binary | std::ios::trunc);
+                file.write(text.data(), text.size());
+                return (bool)file;
+            } });
         }
 
-        void shader::set_uniform(const char* name, const vec3u& value) {
-            glUniform3ui(get_uniform_location(name), value.x, value.y, value.z);
-        }
+        cook_report asset_cooker::cook() {
+            using namespace cook_detail;
+            auto start = std::chrono::steady_clock::now();
+            cook_report report;
+            std::filesystem::path source_root = std::filesystem::path(_source).lexically_normal();
+            std::filesystem::path output_root = std::filesystem::path(_output).lexically_normal();
+            std::error_code error;
+            std::filesystem::create_directories(output_root, error);
+
+            // what the last run left behind
+            std::unordered_map<std::string, file_state> cached_files;
+            std::unordered_map<std::string, record> previous;
+            std::string manifest_path = (output_root / manifest_name).string();
+            {
+                std::ifstream manifest(manifest_path);
+                std::string line;
+                while (std::getline(manifest, line)) {
+                    std::vector<std::string> fields;
+                    std::stringstream ss(line);
+                    for (std::string field; std::getline(ss, field, '\t');) {
+                        fields.push_back(std::move(field));
+                    }
+                    if (fields.size() == 5 && fields[0] == "file") {
+                        file_state state;
+                        if (parse_field(fields[1], state.hash, 16) && parse_field(fields[2], state.size) && parse_field(fields[3], state.mtime)) {
+                            cached_files[fields[4]] = state;
+                        }
+                    } else if (fields.size() >= 4 && fields[0] == "asset") {
+                        uint64_t key = 0;
+                        if (!parse_field(fields[1], key, 16)) {
+                            continue;
+                        }
+                        record& r = previous[fields[2]];
+                        r.key = key;
+                        r.output = fields[3];
+                        if (fields.size() > 4) {
+                            std::stringstream deps(fields[4]);
+                            for (std::string dep; std::getline(deps, dep, '|');) {
+                                r.dependencies.push_back(dep);
+                            }
+                        }
+                    }
+                }
+            }
+
+            struct job {
+                std::string source;
+                const cook_rule* rule;
+                record result;
+                bool dirty = false;
+                bool ok = true;
+            };
+            std::vector<job> jobs;
+            for (auto it = std::filesystem::recursive_directory_iterator(source_root, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+                if (!it->is_regular_file()) {
+                    continue;
+                }
+                std::string ext = lowercase_extension(it->path());
+                for (const cook_rule& rule : _rules) {
+                    if (std::find(rule.extensions.begin(), rule.extensions.end(), ext) != rule.extensions.end()) {
+                        std::string rel = it->path().lexically_relative(source_root).generic_string();
+                        std::string output = std::filesystem::path(rel).replace_extension(rule.output_extension).generic_string();
+                        jobs.push_back({ rel, &rule, { 0, output, {} } });
+                        break;
+                    }
+                }
+            }
+            if (error) {
+                LOG_ERROR("Failed to scan {}: {}", _source, error.message());
+            }
+
+            // content hashes, in parallel; unchanged size + mtime reuses the cached hash
+            std::unordered_map<std::string, file_state> files;
+            auto hash_files = [&](std::vector<std::string> paths) {
+                std::sort(paths.begin(), paths.end());
+                paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+                std::erase_if(paths, [&](const std::string& p) { return files.count(p) != 0; });
+                std::vector<file_state> states(paths.size());
+                thread_pool::global().parallel_for(paths.size(), 16, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        auto cached = cached_files.find(paths[i]);
+                        states[i] = stat_file(source_root / paths[i], cached == cached_files.end() ? nullptr : &cached->second);
+                    }
+                });
+                for (size_t i = 0; i < paths.size(); i++) {
+                    files[paths[i]] = states[i];
+                }
+            };
+            std::vector<std::string> inputs;
+            for (const job& j : jobs) {
+                inputs.push_back(j.source);
+                if (auto prev = previous.find(j.source); prev != previous.end()) {
+                    inputs.insert(inputs.end(), prev->second.dependencies.begin(), prev->second.dependencies.end());
+                }
+            }
+            hash_files(std::move(inputs));
+
+            auto key_of = [&](const job& j, const std::vector<std::string>& dependencies) {
+                uint64_t key = hash(j.rule->parameters, hash(j.rule->output_extension));
+                key = hash(&files[j.source].hash, 8, key);
+                for (const std::string& dep : dependencies) {
+                    key = hash(&files[dep].hash, 8, hash(dep, key));
+                }
+                return key | 1;
+            };
+
+            std::vector<size_t> dirty;
+            for (size_t i = 0; i < jobs.size(); i++) {
+                job& j = jobs[i];
+                auto prev = previous.find(j.source);
+                if (prev != previous.end() && prev->second.key == key_of(j, prev->second.dependencies) &&
+                    std::filesystem::exists(output_root / prev->second.output, error)) {
+                    j.result = prev->second;
+                    report.up_to_date++;
+                } else {
+                    j.dirty = true;
+                    dirty.push_back(i);
+                }
+            }
 
-        void shader::set_uniform(const char* name, const vec3f& value) {
-            glUniform3f(get_uniform_location(name), value.x, value.y, value.z);
-        }
+            thread_pool::global().parallel_for(dirty.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t d = begin; d < end; d++) {
+                    job& j = jobs[dirty[d]];
+                    std::filesystem::path output = output_root / j.result.output;
+                    std::error_code ignored;
+                    std::filesystem::create_directories(output.parent_path(), ignored);
+                    std::vector<std::string> dependencies;
+                    j.ok = j.rule->cook((source_root / j.source).string(), output.string(), dependencies);
+                    for (std::string& dep : dependencies) {
+                        std::string rel = std::filesystem::path(dep).lexically_normal().lexically_relative(source_root).generic_string();
+                        if (!rel.empty() && rel != j.source) {
+                            j.result.dependencies.push_back(std::move(rel));
+                        }
+                    }
+                    std::sort(j.result.dependencies.begin(), j.result.dependencies.end());
+                    j.result.dependencies.erase(std::unique(j.result.dependencies.begin(), j.result.dependencies.end()), j.result.dependencies.end());
+                }
+            });
 
-        void shader::set_uniform(const char* name, const vec3d& value) {
-            glUniform3d(get_uniform_location(name), value.x, value.y, value.z);
-        }
+            // dependencies found while cooking may not have been hashed yet
+            std::vector<std::string> discovered;
+            for (size_t i : dirty) {
+                discovered.insert(discovered.end(), jobs[i].result.dependencies.begin(), jobs[i].result.dependencies.end());
+            }
+            hash_files(std::move(discovered));
+            for (size_t i : dirty) {
+                job& j = jobs[i];
+                if (j.ok) {
+                    j.result.key = key_of(j, j.result.dependencies);
+                    report.cooked++;
+                } else {
+                    LOG_ERROR("Failed to cook {}", j.source);
+                    report.failed++;
+                }
+            }
 
-        void shader::set_uniform(const char* name, const vec4i& value) {
-            glUniform4i(get_uniform_location(name), value.x, value.y, value.z, value.w);
-        }
+            // sources that went away take their outputs with them
+            std::unordered_set<std::string> live;
+            for (const job& j : jobs) {
+                live.insert(j.source);
+            }
+            for (const auto& [source, r] : previous) {
+                if (!live.count(source)) {
+                    std::filesystem::remove(output_root / r.output, error);
+                    report.removed++;
+                }
+            }
 
-        void shader::set_uniform(const char* name, const vec4u& value) {
-            glUniform4ui(get_uniform_location(name), value.x, value.y, value.z, value.w);
-        }
+            std::ofstream manifest(manifest_path, std::ios::out | std::ios::trunc);
+            manifest << "oge-cook\t1\n";
+            for (const auto& [path, state] : files) {
+                if (state.hash) {
+                    manifest << std::format("file\t{:016x}\t{}\t{}\t{}\n", state.hash, state.size, state.mtime, path);
+                }
+            }
+            for (const job& j : jobs) {
+                // failed assets are left out so the next run tries again
+                if (!j.ok) {
+                    continue;
+                }
+                manifest << std::format("asset\t{:016x}\t{}\t{}", j.result.key, j.source, j.result.output);
+                for (size_t d = 0; d < j.result.dependencies.size(); d++) {
+                    manifest << (d ? '|' : '\t') << j.result.dependencies[d];
+                }
+                manifest << '\n';
+            }
+            if (!manifest) {
+                LOG_ERROR("Failed to write cook manifest: {}", manifest_path);
+            }
 
-        void shader::set_uniform(const char* name, const vec4f& value) {
-            glUniform4f(get_uniform_location(name), value.x, value.y, value.z, value.w);
+            report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            LOG_INFO("cooked {} assets, {} up to date, {} failed, {} removed in {:.0f} ms",
+                report.cooked, report.up_to_date, report.failed, report.removed, report.milliseconds);
+            return report;
         }
 
-        void shader::set_uniform(const char* name, const vec4d& value) {
-            glUniform4d(get_uniform_location(name), value.x, value.y, value.z, value.w);
-        }
+        // texture streaming
 
-        void shader::set_uniform(const char* name, const glm::vec2& value) {
-            glUniform2f(get_uniform_location(name), value.x, value.y);
+        namespace streaming_detail {
+            constexpr size_t max_staging = 8;
+            constexpr uint64_t forget_after = 120;   // frames without requests before a texture falls back to its tail
+            constexpr float fade_per_frame = 0.125f;
         }
 
-        void shader::set_uniform(const char* name, const glm::vec3& value) {
-            glUniform3f(get_uniform_location(name), value.x, value.y, value.z);
-        }
+        texture_streamer::texture_streamer(size_t memory_budget, size_t upload_budget, unsigned int tail_size)
+            : _memory_budget(memory_budget), _upload_budget(upload_budget), _tail_size(std::max(1u, tail_size)) {}
 
-        void shader::set_uniform(const char* name, const glm::vec4& value) {
-            glUniform4f(get_uniform_location(name), value.x, value.y, value.z, value.w);
+        texture_streamer::~texture_streamer() {
+            for (uint32_t i = 0; i < _entries.size(); i++) {
+                if (_entries[i].source) {
+                    remove(i);
+                }
+            }
         }
 
-        void shader::set_uniform(const char* name, const glm::mat2& value) {
-            glUniformMatrix2fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(value));
+        size_t texture_streamer::level_bytes(const entry& e, unsigned int first) const {
+            size_t bytes = 0;
+            const std::vector<cooked_texture::level>& levels = e.source->levels();
+            for (size_t i = first; i < levels.size(); i++) {
+                bytes += levels[i].size;
+            }
+            return bytes;
         }
 
-        void shader::set_uniform(const char* name, const glm::mat3& value) {
-            glUniformMatrix3fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(value));
+        void texture_streamer::reallocate(entry& e, unsigned int first) {
+            const std::vector<cooked_texture::level>& levels = e.source->levels();
+            unsigned int id;
+            glCreateTextures(GL_TEXTURE_2D, 1, &id);
+            glTextureStorage2D(id, (GLsizei)(levels.size() - first), e.source->format(), levels[first].width, levels[first].height);
+            if (e.id) {
+                for (unsigned int l = std::max(first, e.resident); l < levels.size(); l++) {
+                    glCopyImageSubData(e.id, GL_TEXTURE_2D, l - e.resident, 0, 0, 0,
+                                       id, GL_TEXTURE_2D, l - first, 0, 0, 0, levels[l].width, levels[l].height, 1);
+                }
+                glDeleteTextures(1, &e.id);
+            }
+            glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            _stats.resident_bytes += level_bytes(e, first);
+            _stats.resident_bytes -= e.id ? level_bytes(e, e.resident) : 0;
+            e.id = id;
+            e.resident = first;
         }
 
-        void shader::set_uniform(const char* name, const glm::mat4& value) {
-            glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(value));
+        uint32_t texture_streamer::add(const char* path) {
+            auto source = std::make_unique<cooked_texture>(path);
+            if (!source->valid()) {
+                return invalid;
+            }
+            uint32_t index;
+            if (!_free.empty()) {
+                index = _free.back();
+                _free.pop_back();
+            } else {
+                index = (uint32_t)_entries.size();
+                _entries.emplace_back();
+            }
+            entry& e = _entries[index];
+            e = entry();
+            e.source = std::move(source);
+
+            const std::vector<cooked_texture::level>& levels = e.source->levels();
+            e.tail = (unsigned int)levels.size() - 1;
+            while (e.tail > 0 && std::max(levels[e.tail - 1].width, levels[e.tail - 1].height) <= _tail_size) {
+                e.tail--;
+            }
+            e.resident = e.tail;
+            e.wanted = e.tail;
+            reallocate(e, e.tail);
+            for (unsigned int l = e.tail; l < levels.size(); l++) {
+                glCompressedTextureSubImage2D(e.id, l - e.tail, 0, 0, levels[l].width, levels[l].height, e.source->format(), (GLsizei)levels[l].size, levels[l].data);
+            }
+            _stats.textures++;
+            return index;
         }
 
-        int shader::get_uniform_location(const char* name) {
-            if (_uniform_location_cache.find(name) != _uniform_location_cache.end()) {
-                return _uniform_location_cache[name];
+        void texture_streamer::remove(uint32_t texture) {
+            if (texture >= _entries.size() || !_entries[texture].source) {
+                return;
             }
-            int location = glGetUniformLocation(_id, name);
-            if (location == -1) {
-                LOG_WARN("Uniform '{}' doesn't exist!", name);
+            entry& e = _entries[texture];
+            if (e.staging.valid()) {
+                // the job reads from the mapping we are about to close
+                e.staging.wait();
             }
-            _uniform_location_cache[name] = location;
-            return location;
+            _stats.resident_bytes -= level_bytes(e, e.resident);
+            glDeleteTextures(1, &e.id);
+            e = entry();
+            _free.push_back(texture);
+            _stats.textures--;
         }
 
-        unsigned int shader::compile_shader(unsigned int type, const char* source) {
-            unsigned int id = glCreateShader(type);
-            glShaderSource(id, 1, &source, nullptr);
-            glCompileShader(id);
-
-            int result;
-            glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-            if (result == GL_FALSE) {
-                int length;
-                glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-                char* message = (char*)alloca(length * sizeof(char));
-                glGetShaderInfoLog(id, length, &length, message);
-                LOG_ERROR("Failed to compile {} shader:\n{}", (type == GL_VERTEX_SHADER ? "vertex" : "fragment"), message);
-                glDeleteShader(id);
-                return 0;
+        void texture_streamer::begin_frame(const presepctive_camera& camera, const vec2u& viewport) {
+            _view = camera.view();
+            // projection[1][1] is cot(fov / 2); one unit at distance one spans this many pixels
+            _pixels_per_unit = camera.projection()[1][1] * 0.5f * (float)viewport.y;
+            _frame++;
+            for (entry& e : _entries) {
+                if (e.source && _frame - e.last_requested > streaming_detail::forget_after) {
+                    e.wanted = e.tail;
+                }
             }
-            return id;
         }
 
-        unsigned int shader::compile_program(const char* vertex_source, const char* fragment_source) {
-            unsigned int program = glCreateProgram();
-            unsigned int vs = compile_shader(GL_VERTEX_SHADER, vertex_source);
-            unsigned int fs = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
-
-            glAttachShader(program, vs);
-            glAttachShader(program, fs);
-            glLinkProgram(program);
-            glValidateProgram(program);
-
-            int result;
-            glGetProgramiv(program, GL_LINK_STATUS, &result);
-            if (result == GL_FALSE) {
-                int length;
-                glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
-                char* message = (char*)alloca(length * sizeof(char));
-                glGetProgramInfoLog(program, length, &length, message);
-                LOG_ERROR("Failed to link shader program:\n{}", message);
-
-                glDeleteProgram(program);
-                glDeleteShader(vs);
-                glDeleteShader(fs);
-                
-                return 0;
+        void texture_streamer::request(uint32_t texture, const glm::vec3& center, float radius, float uv_scale) {
+            if (texture >= _entries.size() || !_entries[texture].source) {
+                return;
             }
-
-            glDeleteShader(vs);
-            glDeleteShader(fs);
-
-            return program;
+            entry& e = _entries[texture];
+            float depth = -(_view * glm::vec4(center, 1.0f)).z;
+            if (depth < -radius) {
+                return;
+            }
+            if (e.last_requested != _frame) {
+                e.wanted = e.tail;
+                e.last_requested = _frame;
+            }
+            unsigned int wanted = 0;
+            if (depth > radius) {
+                float pixels = 2.0f * radius * _pixels_per_unit / depth;
+                float texels = (float)std::max(e.source->width(), e.source->height()) * uv_scale;
+                wanted = (unsigned int)std::clamp(std::floor(std::log2(std::max(texels / std::max(pixels, 1.0f), 1.0f))), 0.0f, (float)e.tail);
+            }
+            e.wanted = std::min(e.wanted, wanted);
         }
 
+        void texture_streamer::update() {
+            _stats.uploaded_bytes = 0;
+            _stats.streaming = 0;
+
+            // finished reads, neediest first, as far as the upload budget goes
+            frame_vector<uint32_t> ready(frame_arena::resource());
+            for (uint32_t i = 0; i < _entries.size(); i++) {
+                entry& e = _entries[i];
+                if (e.staging.valid()) {
+                    if (e.staging.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                        ready.push_back(i);
+                    } else {
+                        _stats.streaming++;
+                    }
+                }
+            }
+            std::sort(ready.begin(), ready.end(), [&](uint32_t a, uint32_t b) {
+                return (int)_entries[a].resident - (int)_entries[a].wanted > (int)_entries[b].resident - (int)_entries[b].wanted;
+            });
+            for (uint32_t i : ready) {
+                entry& e = _entries[i];
+                unsigned int level = e.staging_level;
+                if (level + 1 != e.resident) {
+                    // the texture changed under the read, it no longer fits on top
+                    e.staging.get();
+                    continue;
+                }
+                const cooked_texture::level& l = e.source->levels()[level];
+                if (_stats.uploaded_bytes && _stats.uploaded_bytes + l.size > _upload_budget) {
+                    _stats.streaming++;
+                    continue;
+                }
+                std::vector<uint8_t> data = e.staging.get();
+                if (e.wanted > level) {
+                    // demand moved away while the read was in flight
+                    continue;
+                }
+                reallocate(e, level);
+                glCompressedTextureSubImage2D(e.id, 0, 0, 0, l.width, l.height, e.source->format(), (GLsizei)l.size, data.data());
+                e.min_lod = 1.0f;
+                _stats.uploaded_bytes += l.size;
+            }
 
-        // camera code
+            // start reads for the textures furthest from what they want. reads still in
+            // flight will land on top of what is resident, so they count against the budget
+            frame_vector<uint32_t> needy(frame_arena::resource());
+            size_t in_flight = 0;
+            for (uint32_t i = 0; i < _entries.size(); i++) {
+                const entry& e = _entries[i];
+                if (e.staging.valid()) {
+                    in_flight += e.source->levels()[e.staging_level].size;
+                } else if (e.source && e.wanted < e.resident) {
+                    needy.push_back(i);
+                }
+            }
+            std::sort(needy.begin(), needy.end(), [&](uint32_t a, uint32_t b) {
+                return (int)_entries[a].resident - (int)_entries[a].wanted > (int)_entries[b].resident - (int)_entries[b].wanted;
+            });
+            size_t committed = _stats.resident_bytes + in_flight;
+            size_t budget_left = _memory_budget > committed ? _memory_budget - committed : 0;
+            size_t blocked = 0;
+            for (uint32_t i : needy) {
+                if (_stats.streaming >= streaming_detail::max_staging) {
+                    break;
+                }
+                entry& e = _entries[i];
+                const cooked_texture::level& l = e.source->levels()[e.resident - 1];
+                if (l.size > budget_left) {
+                    blocked += l.size;
+                    continue;
+                }
+                budget_left -= l.size;
+                // touching the mapping here keeps page faults off the GL thread
+                e.staging = thread_pool::global().submit([data = l.data, size = l.size]() {
+                    return std::vector<uint8_t>(data, data + size);
+                });
+                e.staging_level = e.resident - 1;
+                _stats.streaming++;
+            }
 
-        ortho_camera::ortho_camera( const glm::vec4& bounds ) 
-            : _projection(glm::ortho(bounds.x, bounds.y, bounds.z, bounds.w, -1.0f, 1.0f)),
-              _view(1.0f)
-        {
-            _view_projection = _projection * _view;
-        }
+            // over budget: levels finer than wanted go first, then whatever was used longest ago.
+            // reads blocked on memory may only take levels nobody wants any more. textures
+            // with a read in flight are left alone, the read is sized for what they hold now
+            while (true) {
+                bool over = _stats.resident_bytes > _memory_budget;
+                bool starving = blocked && _stats.resident_bytes + blocked > _memory_budget;
+                if (!over && !starving) {
+                    break;
+                }
+                uint32_t victim = invalid;
+                for (uint32_t i = 0; i < _entries.size(); i++) {
+                    const entry& e = _entries[i];
+                    if (!e.source || e.staging.valid() || e.resident >= e.tail || (!over && e.resident >= e.wanted)) {
+                        continue;
+                    }
+                    if (victim == invalid) {
+                        victim = i;
+                        continue;
+                    }
+                    const entry& v = _entries[victim];
+                    bool excess = e.resident < e.wanted, victim_excess = v.resident < v.wanted;
+                    if (excess != victim_excess ? excess : e.last_requested < v.last_requested) {
+                        victim = i;
+                    }
+                }
+                if (victim == invalid) {
+                    break;
+                }
+                entry& e = _entries[victim];
+                reallocate(e, e.resident + 1);
+                e.min_lod = 0.0f;
+                _stats.dropped_levels++;
+            }
 
-        void ortho_camera::set_projection(const glm::vec4& bounds) {
-            _projection = glm::ortho(bounds.x, bounds.y, bounds.z, bounds.w, -1.0f, 1.0f);
-            update_view();
+            for (entry& e : _entries) {
+                if (e.id && e.min_lod > 0.0f) {
+                    e.min_lod = std::max(0.0f, e.min_lod - streaming_detail::fade_per_frame);
+                    glTextureParameterf(e.id, GL_TEXTURE_MIN_LOD, e.min_lod);
+                }
+            }
         }
 
-        void ortho_camera::update_view() {
-            glm::mat4 transform = glm::translate(
-                glm::mat4(1.0f),
-                _position
-            ) * glm::rotate(
-                glm::mat4(1.0f),
-                glm::radians(_rotation),
-                glm::vec3(0, 0, 1)
-            );
-            _view = glm::inverse(transform);
-            _view_projection = _projection * _view;
+        unsigned int texture_streamer::texture(uint32_t texture) const {
+            return texture < _entries.size() ? _entries[texture].id : 0;
         }
 
-        presepctive_camera::presepctive_camera(float fov, float aspect_ratio, float near_clip, float far_clip) {
-            set_projection(fov, aspect_ratio, near_clip, far_clip);
+        void texture_streamer::bind(uint32_t texture, unsigned int slot) const {
+            glBindTextureUnit(slot, this->texture(texture));
         }
 
-        void presepctive_camera::set_projection(float fov, float aspect_ratio, float near_clip, float far_clip) {
-            _projection = glm::perspective(glm::radians(fov), aspect_ratio, near_clip, far_clip);
-            update_view();
+        unsigned int texture_streamer::resident_level(uint32_t texture) const {
+            return texture < _entries.size() ? _entries[texture].resident : 0;
         }
 
-        void presepctive_camera::update_view() {
-            glm::mat4 transform = glm::translate(
-                glm::mat4(1.0f),
-                _position
-            ) * glm::rotate(
-                glm::mat4(1.0f),
-                glm::radians(_rotation),
-                glm::vec3(0, 0, 1)
-            );
-            _view = glm::inverse(transform);
-            _view_projection = _projection * _view;
+        unsigned int texture_streamer::wanted_level(uint32_t texture) const {
+            return texture < _entries.size() ? _entries[texture].wanted : 0;
         }
 
-
     }
 
     namespace core {
@@ -1131,6 +10723,255 @@ namespace oge {
         }
 
 
+        // frame capture
+
+        frame_capture::frame_capture(const char* path, format fmt, const utils::vec2u& size, unsigned int fps, unsigned int ring)
+            : _path(path), _format(fmt), _size(size), _fps(fps)
+        {
+            if (_format == format::y4m) {
+                // 4:2:0 needs even dimensions, the odd row/column is dropped
+                _size = { size.x & ~1u, size.y & ~1u };
+                _stream.open(_path, std::ios::out | std::ios::binary);
+                if (!_stream) {
+                    LOG_ERROR("Failed to open capture file: {}", _path);
+                    _ok = false;
+                    return;
+                }
+                _stream << "YUV4MPEG2 W" << _size.x << " H" << _size.y << " F" << _fps << ":1 Ip A1:1 C420jpeg\n";
+            }
+
+            GLsizeiptr bytes = (GLsizeiptr)size.x * size.y * 4;
+            GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            for (unsigned int i = 0; i < ring; i++) {
+                auto s = std::make_unique<slot>();
+                glCreateBuffers(1, &s->pbo);
+                glNamedBufferStorage(s->pbo, bytes, nullptr, flags);
+                s->mapped = (unsigned char*)glMapNamedBufferRange(s->pbo, 0, bytes, flags);
+                _slots.push_back(std::move(s));
+            }
+
+            _thread = std::thread(&frame_capture::worker, this);
+        }
+
+        frame_capture::~frame_capture() {
+            if (!_ok) {
+                return;
+            }
+
+            // drain readbacks still in flight, then let the worker finish the queue
+            collect(true);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _cv.notify_one();
+            _thread.join();
+
+            for (auto& s : _slots) {
+                if (s->fence) {
+                    glDeleteSync(s->fence);
+                }
+                glUnmapNamedBuffer(s->pbo);
+                glDeleteBuffers(1, &s->pbo);
+            }
+        }
+
+        frame_capture::stats frame_capture::statistics() const {
+            return { _captured.load(), _written.load(), _dropped.load() };
+        }
+
+        void frame_capture::collect(bool wait) {
+            for (auto& s : _slots) {
+                if (!s->fence) {
+                    continue;
+                }
+                GLenum status = glClientWaitSync(s->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+                if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+                    glDeleteSync(s->fence);
+                    s->fence = nullptr;
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        _queue.push_back(s.get());
+                    }
+                    _cv.notify_one();
+                }
+            }
+        }
+
+        void frame_capture::capture() {
+            if (!_ok) {
+                return;
+            }
+            collect(false);
+
+            slot& s = *_slots[_next];
+            if (s.busy.load(std::memory_order_acquire)) {
+                // either the gpu or the writer is behind, skip rather than stall the frame
+                _dropped++;
+                return;
+            }
+            _next = (_next + 1) % _slots.size();
+
+            s.busy.store(true, std::memory_order_relaxed);
+            s.frame = _frame++;
+
+            glReadBuffer(GL_BACK);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+            glReadPixels(0, 0, _size.x, _size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+            s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            _captured++;
+        }
+
+        void frame_capture::worker() {
+            while (true) {
+                slot* s;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _cv.wait(lock, [this]() { return _stop || !_queue.empty(); });
+                    if (_queue.empty()) {
+                        return;
+                    }
+                    // fences can signal out of order, keep the stream in frame order
+                    auto it = std::min_element(_queue.begin(), _queue.end(), [](slot* a, slot* b) { return a->frame < b->frame; });
+                    s = *it;
+                    _queue.erase(it);
+                }
+
+                if (_format == format::png) {
+                    write_png(s->mapped, s->frame);
+                } else {
+                    write_y4m(s->mapped);
+                }
+                _written++;
+                s->busy.store(false, std::memory_order_release);
+            }
+        }
+
+        static uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size) {
+            static const auto table = []() {
+                std::array<uint32_t, 256> t;
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; k++) {
+                        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                    }
+                    t[i] = c;
+                }
+                return t;
+            }();
+
+            crc = ~crc;
+            for (size_t i = 0; i < size; i++) {
+                crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        void frame_capture::write_png(const unsigned char* pixels, uint64_t frame) {
+            // stored (uncompressed) deflate blocks: big files, but the writer keeps up
+            size_t row = (size_t)_size.x * 4 + 1;
+            std::vector<unsigned char>& raw = _convert;
+            raw.resize(row * _size.y);
+            for (unsigned int y = 0; y < _size.y; y++) {
+                unsigned char* dst = raw.data() + y * row;
+                dst[0] = 0;
+                std::memcpy(dst + 1, pixels + (size_t)(_size.y - 1 - y) * _size.x * 4, row - 1);
+            }
+
+            std::vector<unsigned char> z;
+            z.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+            z.push_back(0x78);
+            z.push_back(0x01);
+            uint32_t a = 1, b = 0;
+            for (size_t pos = 0; ; ) {
+                size_t len = std::min<size_t>(65535, raw.size() - pos);
+                bool last = pos + len == raw.size();
+                z.push_back(last ? 1 : 0);
+                z.push_back(len & 0xff); z.push_back(len >> 8);
+                z.push_back(~len & 0xff); z.push_back((~len >> 8) & 0xff);
+                z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+                for (size_t i = pos; i < pos + len; i++) {
+                    a = (a + raw[i]) % 65521;
+                    b = (b + a) % 65521;
+                }
+                pos += len;
+                if (last) {
+                    break;
+                }
+            }
+            uint32_t adler = b << 16 | a;
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                z.push_back((adler >> shift) & 0xff);
+            }
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "_%06llu.png", (unsigned long long)frame);
+            std::ofstream file(_path + name, std::ios::out | std::ios::binary);
+            if (!file) {
+                LOG_ERROR("Failed to write capture frame: {}{}", _path, name);
+                return;
+            }
+
+            auto chunk = [&file](const char* type, const unsigned char* data, size_t size) {
+                unsigned char header[8] = {
+                    (unsigned char)(size >> 24), (unsigned char)(size >> 16), (unsigned char)(size >> 8), (unsigned char)size,
+                    (unsigned char)type[0], (unsigned char)type[1], (unsigned char)type[2], (unsigned char)type[3]
+                };
+                uint32_t crc = crc32(crc32(0, header + 4, 4), data, size);
+                unsigned char footer[4] = { (unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc };
+                file.write((const char*)header, 8);
+                file.write((const char*)data, size);
+                file.write((const char*)footer, 4);
+            };
+
+            static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+            file.write((const char*)signature, 8);
+
+            unsigned char ihdr[13] = {
+                (unsigned char)(_size.x >> 24), (unsigned char)(_size.x >> 16), (unsigned char)(_size.x >> 8), (unsigned char)_size.x,
+                (unsigned char)(_size.y >> 24), (unsigned char)(_size.y >> 16), (unsigned char)(_size.y >> 8), (unsigned char)_size.y,
+                8, 6, 0, 0, 0
+            };
+            chunk("IHDR", ihdr, sizeof(ihdr));
+            chunk("IDAT", z.data(), z.size());
+            chunk("IEND", nullptr, 0);
+        }
+
+        void frame_capture::write_y4m(const unsigned char* pixels) {
+            // full-range bt.601 (what C420jpeg means), rows flipped from gl's bottom-up order
+            unsigned int w = _size.x, h = _size.y;
+            size_t pitch = (size_t)w * 4;
+            _convert.resize((size_t)w * h * 3 / 2);
+            unsigned char* yp = _convert.data();
+            unsigned char* up = yp + (size_t)w * h;
+            unsigned char* vp = up + (size_t)w * h / 4;
+
+            for (unsigned int y = 0; y < h; y += 2) {
+                const unsigned char* r0 = pixels + (size_t)(h - 1 - y) * pitch;
+                const unsigned char* r1 = r0 - pitch;
+                for (unsigned int x = 0; x < w; x += 2) {
+                    int rs = 0, gs = 0, bs = 0;
+                    for (int k = 0; k < 4; k++) {
+                        const unsigned char* p = (k < 2 ? r0 : r1) + (x + (k & 1)) * 4;
+                        int luma = (19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16;
+                        yp[(size_t)(y + (k >> 1)) * w + x + (k & 1)] = (unsigned char)luma;
+                        rs += p[0]; gs += p[1]; bs += p[2];
+                    }
+                    int u = ((-11059 * rs - 21709 * gs + 32768 * bs) / 4 >> 16) + 128;
+                    int v = ((32768 * rs - 27439 * gs - 5329 * bs) / 4 >> 16) + 128;
+                    up[(size_t)(y / 2) * (w / 2) + x / 2] = (unsigned char)std::clamp(u, 0, 255);
+                    vp[(size_t)(y / 2) * (w / 2) + x / 2] = (unsigned char)std::clamp(v, 0, 255);
+                }
+            }
+
+            _stream << "FRAME\n";
+            _stream.write((const char*)_convert.data(), _convert.size());
+        }
+
         window::window( const window_state& state ) : state(state) {
             init();
         }
@@ -1141,9 +10982,40 @@ namespace oge {
 
         void window::on_update() {
             glfwPollEvents();
+            if (_capture) {
+                int width, height;
+                glfwGetFramebufferSize(state.window, &width, &height);
+                if ((unsigned int)width != _capture_size.x || (unsigned int)height != _capture_size.y) {
+                    LOG_WARN("Window resized, stopping frame capture");
+                    end_capture();
+                } else {
+                    _capture->capture();
+                }
+            }
             glfwSwapBuffers(state.window);
         }
 
+        bool window::begin_capture(const char* path, frame_capture::format fmt, unsigned int fps) {
+            end_capture();
+            int width, height;
+            glfwGetFramebufferSize(state.window, &width, &height);
+            _capture_size = { (unsigned int)width, (unsigned int)height };
+            _capture = std::make_unique<frame_capture>(path, fmt, _capture_size, fps);
+            if (!_capture->ok()) {
+                _capture.reset();
+                return false;
+            }
+            return true;
+        }
+
+        void window::end_capture() {
+            if (_capture) {
+                frame_capture::stats s = _capture->statistics();
+                _capture.reset();
+                LOG_INFO("Frame capture finished: {} captured, {} written, {} dropped", s.captured, s.written, s.dropped);
+            }
+        }
+
         void window::set_event_callback(const window_event_callback_fn& callback) {
             state.callback = callback;
         }
@@ -1200,6 +11072,11 @@ namespace oge {
         }
 
         void window::shutdown() {
+            // debug draw keeps lazily created GL objects that must go before the context
+            utils::debug_draw::shutdown();
+            utils::asset_manager::global().clear();
+            utils::texture2d::shutdown();
+            _capture.reset();
             glfwDestroyWindow(state.window);
             glfw::terminate();
         }
@@ -1263,7 +11140,7 @@ namespace oge {
 
         void imgui_layer::on_event(events::event& e) {
             events::event_dispatcher dispatcher(e);
-            dispatcher.dispatch<events::mouse_button_press_event>(std::bind(&imgui_layer::on_mouse_button_press, this, std::placeholders::_1));
+            dispatcher.dispatch<events::mouse_button_press_event>([this](events::mouse_button_press_event& e) { return on_mouse_button_press(e); });
         }
 
         bool imgui_layer::on_mouse_button_press(events::mouse_button_event& e) {
@@ -1322,6 +11199,11 @@ namespace oge {
             
             _window = std::make_unique<window>( window_state(title, size) );
             _window->set_event_callback(std::bind(&application::on_event, this, std::placeholders::_1));
+
+            // a cooked res.pak next to the executable shadows the loose res/ tree
+            if (std::filesystem::exists("res.pak")) {
+                utils::asset_pack::mount("res.pak");
+            }
         }
 
 
@@ -1332,6 +11214,10 @@ namespace oge {
                 delta_time = time - _lastframe_time;
                 _lastframe_time = time;
 
+                // finished texture decodes reach the GPU before anything draws with them
+                utils::texture2d::process_uploads();
+                utils::asset_manager::global().update();
+
                 for (layer* layer : _layer_stack) {
                     layer->pre_update();
                     layer->on_update(delta_time);
@@ -1339,6 +11225,9 @@ namespace oge {
                 }
 
                 _window->on_update();
+
+                // everything allocated from frame arenas this iteration is gone
+                utils::frame_arena::next_frame();
             }
         }
 
@@ -1357,7 +11246,7 @@ namespace oge {
 
         void application::on_event(events::event& event) {
             events::event_dispatcher dispatcher(event);
-            dispatcher.dispatch<events::window_close_event>(std::bind(&application::on_window_close, this, std::placeholders::_1));
+            dispatcher.dispatch<events::window_close_event>([this](events::window_close_event& e) { return on_window_close(e); });
 
             for (auto it = _layer_stack.end(); it != _layer_stack.begin(); ) {
                 (*--it)->on_event(event);
@@ -1416,8 +11305,8 @@ namespace oge {
 
         void ortho_camera_controller::on_event(events::event& e) {
             events::event_dispatcher dispatcher(e);
-            dispatcher.dispatch<events::mouse_scroll_event>(std::bind(&ortho_camera_controller::on_mouse_scroll, this, std::placeholders::_1));
-            dispatcher.dispatch<events::window_resize_event>(std::bind(&ortho_camera_controller::on_window_resize, this, std::placeholders::_1));
+            dispatcher.dispatch<events::mouse_scroll_event>([this](events::mouse_scroll_event& e) { return on_mouse_scroll(e); });
+            dispatcher.dispatch<events::window_resize_event>([this](events::window_resize_event& e) { return on_window_resize(e); });
         }
 
         bool ortho_camera_controller::on_mouse_scroll(events::mouse_scroll_event& e) {
@@ -1466,8 +11355,8 @@ namespace oge {
 
         void presepctive_camera_controller::on_event(events::event& e) {
             events::event_dispatcher dispatcher(e);
-            dispatcher.dispatch<events::mouse_scroll_event>(std::bind(&presepctive_camera_controller::on_mouse_scroll, this, std::placeholders::_1));
-            dispatcher.dispatch<events::window_resize_event>(std::bind(&presepctive_camera_controller::on_window_resize, this, std::placeholders::_1));
+            dispatcher.dispatch<events::mouse_scroll_event>([this](events::mouse_scroll_event& e) { return on_mouse_scroll(e); });
+            dispatcher.dispatch<events::window_resize_event>([this](events::window_resize_event& e) { return on_window_resize(e); });
         }
 
         bool presepctive_camera_controller::on_mouse_scroll(events::mouse_scroll_event& e) {
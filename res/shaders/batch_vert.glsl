@@ -0,0 +1,19 @@
+#version 450 core
+
+layout (location = 0) in vec3 a_Pos;
+layout (location = 1) in vec2 a_uv;
+layout (location = 2) in vec4 a_color;
+layout (location = 3) in float a_texture;
+
+uniform mat4 u_view_projection;
+
+out vec2 v_uv;
+out vec4 v_color;
+flat out int v_texture;
+
+void main() {
+	v_uv = a_uv;
+	v_color = a_color;
+	v_texture = int(a_texture);
+	gl_Position = u_view_projection * vec4(a_Pos, 1.0);
+}
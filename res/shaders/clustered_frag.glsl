@@ -0,0 +1,53 @@
+#version 450 core
+
+layout (location = 0) out vec4 fragColor;
+
+struct light {
+	vec3 position;
+	float radius;
+	vec3 color;
+	float intensity;
+	vec3 direction;
+	float spot_cos;
+};
+
+layout (std430, binding = 0) readonly buffer lights_buffer { light lights[]; };
+layout (std430, binding = 1) readonly buffer clusters_buffer { uvec2 clusters[]; };
+layout (std430, binding = 2) readonly buffer indices_buffer { uint indices[]; };
+
+uniform uvec3 u_cluster_grid;
+uniform vec2 u_cluster_size;
+uniform float u_cluster_scale;
+uniform float u_cluster_bias;
+
+uniform vec4 u_color;
+uniform vec3 u_ambient;
+
+in vec3 v_position;
+in vec3 v_normal;
+in float v_depth;
+
+void main() {
+	uint slice = uint(clamp(log(v_depth) * u_cluster_scale - u_cluster_bias, 0.0, float(u_cluster_grid.z - 1)));
+	uvec2 tile = min(uvec2(gl_FragCoord.xy / u_cluster_size), u_cluster_grid.xy - 1);
+	uvec2 cluster = clusters[(slice * u_cluster_grid.y + tile.y) * u_cluster_grid.x + tile.x];
+
+	vec3 n = normalize(v_normal);
+	vec3 lit = u_ambient;
+	for (uint i = 0; i < cluster.y; i++) {
+		light l = lights[indices[cluster.x + i]];
+		vec3 to_light = l.position - v_position;
+		float dist = length(to_light);
+		vec3 dir = to_light / max(dist, 1e-4);
+
+		float falloff = clamp(1.0 - dist / l.radius, 0.0, 1.0);
+		falloff *= falloff;
+		if (l.spot_cos > -1.0) {
+			float cone = dot(-dir, l.direction);
+			falloff *= smoothstep(l.spot_cos, mix(l.spot_cos, 1.0, 0.2), cone);
+		}
+		lit += l.color * l.intensity * falloff * max(dot(n, dir), 0.0);
+	}
+
+	fragColor = vec4(u_color.rgb * lit, u_color.a);
+}
@@ -0,0 +1,20 @@
+#version 450 core
+
+layout (location = 0) in vec3 a_Pos;
+layout (location = 1) in vec3 a_Normal;
+
+uniform mat4 u_view_projection;
+uniform mat4 u_view;
+uniform mat4 u_transform;
+
+out vec3 v_position;
+out vec3 v_normal;
+out float v_depth;
+
+void main() {
+	vec4 world = u_transform * vec4(a_Pos, 1.0);
+	v_position = world.xyz;
+	v_normal = mat3(u_transform) * a_Normal;
+	v_depth = -(u_view * world).z;
+	gl_Position = u_view_projection * world;
+}
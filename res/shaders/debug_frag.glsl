@@ -0,0 +1,9 @@
+#version 450 core
+
+layout (location = 0) out vec4 fragColor;
+
+in vec4 v_color;
+
+void main() {
+	fragColor = v_color;
+}
@@ -0,0 +1,13 @@
+#version 450 core
+
+layout (location = 0) in vec3 a_Pos;
+layout (location = 1) in vec4 a_color;
+
+uniform mat4 u_view_projection;
+
+out vec4 v_color;
+
+void main() {
+	v_color = a_color;
+	gl_Position = u_view_projection * vec4(a_Pos, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 450 core
+
+layout (location = 0) in vec4 a_Pos;
+
+// per-instance, divisor 1
+layout (location = 1) in mat4 i_transform;
+layout (location = 5) in vec4 i_color;
+
+uniform mat4 u_view_projection;
+
+out vec4 v_color;
+
+void main() {
+	v_color = i_color;
+	gl_Position = u_view_projection * i_transform * vec4(a_Pos.xyz, 1.0);
+}
@@ -0,0 +1,45 @@
+#version 450 core
+
+// vertex_layout with half4 positions, octahedral normals/tangents, half2 uvs and unorm8 colors
+layout (location = 0) in vec4 a_Pos;
+layout (location = 1) in vec2 a_Normal;
+layout (location = 2) in vec2 a_Tangent;
+layout (location = 3) in vec2 a_UV;
+layout (location = 4) in vec4 a_Color;
+
+uniform mat4 u_view_projection;
+uniform mat4 u_view;
+uniform mat4 u_transform;
+
+out vec3 v_position;
+out vec3 v_normal;
+out vec4 v_tangent;
+out vec2 v_uv;
+out vec4 v_color;
+out float v_depth;
+
+vec3 unpack_octahedral(vec2 p) {
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
+vec4 unpack_tangent(vec2 p) {
+	// the handedness lives in the lowest bit of the snorm16 y
+	int y = int(round(p.y * 32767.0));
+	float w = (y & 1) != 0 ? -1.0 : 1.0;
+	return vec4(unpack_octahedral(vec2(p.x, float(y & ~1) / 32767.0)), w);
+}
+
+void main() {
+	vec4 world = u_transform * vec4(a_Pos.xyz, 1.0);
+	v_position = world.xyz;
+	v_normal = mat3(u_transform) * unpack_octahedral(a_Normal);
+	vec4 tangent = unpack_tangent(a_Tangent);
+	v_tangent = vec4(mat3(u_transform) * tangent.xyz, tangent.w);
+	v_uv = a_UV;
+	v_color = a_Color;
+	v_depth = -(u_view * world).z;
+	gl_Position = u_view_projection * world;
+}
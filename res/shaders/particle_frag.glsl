@@ -0,0 +1,20 @@
+#version 450 core
+
+layout (location = 0) out vec4 fragColor;
+
+layout (binding = 0) uniform sampler2D u_texture;
+uniform int u_textured;
+
+in vec2 v_uv;
+in vec4 v_color;
+
+void main() {
+	vec4 color = v_color;
+	if (u_textured != 0) {
+		color *= texture(u_texture, v_uv);
+	} else {
+		// soft round sprite
+		color.a *= clamp(1.0 - length(v_uv - 0.5) * 2.0, 0.0, 1.0);
+	}
+	fragColor = color;
+}
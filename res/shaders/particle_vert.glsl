@@ -0,0 +1,22 @@
+#version 450 core
+
+layout (location = 0) in vec2 a_corner;
+
+// per-instance, divisor 1
+layout (location = 1) in vec4 i_position_size;
+layout (location = 2) in vec4 i_color;
+
+uniform mat4 u_view_projection;
+uniform vec3 u_camera_right;
+uniform vec3 u_camera_up;
+
+out vec2 v_uv;
+out vec4 v_color;
+
+void main() {
+	vec3 world = i_position_size.xyz
+	           + (u_camera_right * a_corner.x + u_camera_up * a_corner.y) * i_position_size.w;
+	v_uv = a_corner + 0.5;
+	v_color = i_color;
+	gl_Position = u_view_projection * vec4(world, 1.0);
+}
@@ -0,0 +1,11 @@
+#version 450 core
+
+layout (location = 0) out vec4 fragColor;
+
+layout (binding = 0) uniform sampler2D u_atlas;
+
+in vec2 v_uv;
+
+void main() {
+	fragColor = texture(u_atlas, v_uv);
+}
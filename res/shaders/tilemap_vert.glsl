@@ -0,0 +1,13 @@
+#version 450 core
+
+layout (location = 0) in vec2 a_Pos;
+layout (location = 1) in vec2 a_uv;
+
+uniform mat4 u_view_projection;
+
+out vec2 v_uv;
+
+void main() {
+	v_uv = a_uv;
+	gl_Position = u_view_projection * vec4(a_Pos, 0.0, 1.0);
+}
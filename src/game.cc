@@ -7,11 +7,12 @@ void game::on_attach() {
 
 
     // a square containing the lower half of the screen
-    float vertices[] = {
-        -1.0f, -1.0f, 0.0f, // bottom left
-        -1.0f, -0.3f, 0.0f, // top left
-         1.0f, -0.3f, 0.0f, // top right
-         1.0f, -1.0f, 0.0f  // bottom right
+    oge::utils::mesh_data ground;
+    ground.positions = {
+        { -1.0f, -1.0f, 0.0f }, // bottom left
+        { -1.0f, -0.3f, 0.0f }, // top left
+        {  1.0f, -0.3f, 0.0f }, // top right
+        {  1.0f, -1.0f, 0.0f }  // bottom right
     };
 
     unsigned int indices[] = {
@@ -19,17 +20,21 @@ void game::on_attach() {
         2, 3, 0
     };
 
+    oge::utils::vertex_layout layout = {
+        { oge::utils::vertex_semantic::position, oge::utils::vertex_format::half4, 0 }
+    };
+    std::vector<uint8_t> vertices = layout.pack(ground);
+
     glGenVertexArrays(1, &m_vao);
-    glBindVertexArray(m_vao);
 
     glGenBuffers(1, &m_vbo);
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
     // attribute 0
-    
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    layout.attach(m_vao, m_vbo);
+
+    glBindVertexArray(m_vao);
 
     // index buffer object
     glGenBuffers(1, &m_ibo);
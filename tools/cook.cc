@@ -0,0 +1,18 @@
+// cooks a source tree with the default rules, run from the project root:
+// oge_cook res target/cooked
+#define OGE_IMPL
+#include "oge.hh"
+
+int main(int argc, char** argv) {
+    oge::utils::log::init();
+
+    if (argc != 3) {
+        LOG_ERROR("usage: oge_cook <source dir> <output dir>");
+        return 1;
+    }
+
+    oge::utils::asset_cooker cooker(argv[1], argv[2]);
+    cooker.add_default_rules();
+    // cook() logs its own summary
+    return cooker.cook().failed ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+// bundles directories into an asset pack, run from the project root so entry names match
+// what read_file asks for:  oge_pack res.pak res [more dirs...] [--raw]
+#define OGE_IMPL
+#include "oge.hh"
+
+int main(int argc, char** argv) {
+    oge::utils::log::init();
+
+    if (argc < 3) {
+        LOG_ERROR("usage: oge_pack <output.pak> <directory>... [--raw]");
+        return 1;
+    }
+
+    bool compress = true;
+    for (int i = 2; i < argc; i++) {
+        if (std::string_view(argv[i]) == "--raw") {
+            compress = false;
+        }
+    }
+
+    oge::utils::asset_pack_builder builder;
+    size_t files = 0;
+    for (int i = 2; i < argc; i++) {
+        if (std::string_view(argv[i]) != "--raw") {
+            files += builder.add_directory(argv[i], compress);
+        }
+    }
+
+    if (!builder.write(argv[1])) {
+        return 1;
+    }
+    LOG_INFO("Packed {} files into {}", files, argv[1]);
+    return 0;
+}